@@ -0,0 +1,513 @@
+#include "pch.h"
+#include "MeshOptimisation.h"
+#include "Common/JobSystem.h"
+#include <mutex>
+
+// ---- private types and function declarations ----
+
+//triangles using each vertex, stored in compressed sparse row layout
+struct VertexTriangleAdjacency {
+    std::vector<uint32_t> offsets;      //vertexCount + 1 entries, triangles of vertex v are in [offsets[v], offsets[v + 1])
+    std::vector<uint32_t> triangles;
+};
+
+//a cluster is ended once its ACMR is at most this factor times the ACMR of the whole mesh
+//smaller values result in fewer, larger clusters, which are better for the vertex cache and worse for overdraw sorting
+//value is taken from the paper
+const float overdrawClusterACMRThreshold = 1.05f;
+
+//resolution of the longer side of the overdraw rasterization, the shorter side is scaled to keep pixels square
+const uint32_t overdrawRasterResolution = 256;
+
+VertexTriangleAdjacency buildVertexTriangleAdjacency(const std::vector<uint32_t>& indices, const size_t vertexCount);
+
+//returns the triangle order, hard cluster boundaries are written as first triangle of every cluster, in output order
+std::vector<uint32_t> tipsify(const std::vector<uint32_t>& indices, const size_t vertexCount,
+    std::vector<uint32_t>* outClusterBegins);
+
+//splits hard clusters at points where the cluster's ACMR is low enough, so clusters can be sorted for overdraw
+std::vector<uint32_t> computeSoftClusterBoundaries(const std::vector<uint32_t>& indices, const size_t vertexCount,
+    const std::vector<uint32_t>& triangleOrder, const std::vector<uint32_t>& hardClusterBegins);
+
+//clusters are sorted by dot(clusterCentroid - meshCentroid, clusterNormal), descending
+//normals are taken from the vertex normals, so the result doesn't depend on the winding convention
+std::vector<uint32_t> sortClustersForOverdraw(const MeshData& mesh, const std::vector<uint32_t>& triangleOrder,
+    const std::vector<uint32_t>& clusterBegins);
+
+//reorders vertex attributes by first use in the index buffer and remaps the indices
+void reorderVerticesByFirstUse(MeshData* mesh);
+
+template<typename T>
+std::vector<T> remapVertexAttribute(const std::vector<T>& attribute, const std::vector<uint32_t>& newToOldVertex);
+
+//simulates a FIFO cache of vertexCacheSize, returns the number of cache misses
+uint64_t countTransformedVertices(const std::vector<uint32_t>& indices, const size_t vertexCount);
+
+//rasterizes all triangles in index order with depth test and backface culling from the six axis directions
+void measureOverdraw(const MeshData& mesh, uint64_t* outShadedPixelCount, uint64_t* outCoveredPixelCount);
+
+//position is projected onto the two axes orthogonal to viewAxis, the depth buffer keeps the closest fragment
+//triangles facing away from the viewer are culled, using the winding convention of the runtime
+void rasterizeOverdrawView(const MeshData& mesh, const int viewAxis, const bool viewFromPositive,
+    uint64_t* outShadedPixelCount, uint64_t* outCoveredPixelCount);
+
+// ---- implementation ----
+
+MeshOrderStatistics computeMeshOrderStatistics(const std::vector<MeshData>& meshes) {
+    MeshOrderStatistics statistics;
+    std::mutex statisticsMutex;
+    JobSystem::parallelFor(0, meshes.size(), 1, [&meshes, &statistics, &statisticsMutex](const size_t rangeBegin, const size_t rangeEnd, int) {
+        for (size_t i = rangeBegin; i < rangeEnd; i++) {
+            const MeshData& mesh = meshes[i];
+            const uint64_t transformedVertexCount = countTransformedVertices(mesh.indices, mesh.positions.size());
+            uint64_t shadedPixelCount = 0;
+            uint64_t coveredPixelCount = 0;
+            measureOverdraw(mesh, &shadedPixelCount, &coveredPixelCount);
+
+            std::lock_guard<std::mutex> lock(statisticsMutex);
+            statistics.triangleCount += mesh.indices.size() / 3;
+            statistics.vertexCount += mesh.positions.size();
+            statistics.transformedVertexCount += transformedVertexCount;
+            statistics.shadedPixelCount += shadedPixelCount;
+            statistics.coveredPixelCount += coveredPixelCount;
+        }
+    });
+    return statistics;
+}
+
+void printMeshOrderStatistics(const MeshOrderStatistics& before, const MeshOrderStatistics& after) {
+    const auto ratio = [](const uint64_t numerator, const uint64_t denominator) {
+        return denominator > 0 ? float(numerator) / float(denominator) : 0.f;
+    };
+    std::cout << "Mesh order optimisation, vertex cache size " << vertexCacheSize << "\n"
+        << "    ACMR: " << ratio(before.transformedVertexCount, before.triangleCount)
+        << " -> " << ratio(after.transformedVertexCount, after.triangleCount) << "\n"
+        << "    ATVR: " << ratio(before.transformedVertexCount, before.vertexCount)
+        << " -> " << ratio(after.transformedVertexCount, after.vertexCount) << "\n"
+        << "    overdraw: " << ratio(before.shadedPixelCount, before.coveredPixelCount)
+        << " -> " << ratio(after.shadedPixelCount, after.coveredPixelCount) << "\n";
+}
+
+void optimiseMeshOrder(MeshData* mesh) {
+    const size_t vertexCount = mesh->positions.size();
+    if (mesh->indices.size() < 3 || vertexCount == 0) {
+        return;
+    }
+    std::vector<uint32_t> hardClusterBegins;
+    const std::vector<uint32_t> cacheOrder = tipsify(mesh->indices, vertexCount, &hardClusterBegins);
+    const std::vector<uint32_t> clusterBegins = computeSoftClusterBoundaries(mesh->indices, vertexCount, cacheOrder,
+        hardClusterBegins);
+    const std::vector<uint32_t> triangleOrder = sortClustersForOverdraw(*mesh, cacheOrder, clusterBegins);
+
+    std::vector<uint32_t> reorderedIndices;
+    reorderedIndices.reserve(mesh->indices.size());
+    for (const uint32_t triangle : triangleOrder) {
+        for (uint32_t i = 0; i < 3; i++) {
+            reorderedIndices.push_back(mesh->indices[triangle * 3 + i]);
+        }
+    }
+    mesh->indices = std::move(reorderedIndices);
+    reorderVerticesByFirstUse(mesh);
+}
+
+void optimiseMeshOrder(std::vector<MeshData>* meshes) {
+    JobSystem::parallelFor(0, meshes->size(), 1, [meshes](const size_t rangeBegin, const size_t rangeEnd, int) {
+        for (size_t i = rangeBegin; i < rangeEnd; i++) {
+            optimiseMeshOrder(&(*meshes)[i]);
+        }
+    });
+}
+
+VertexTriangleAdjacency buildVertexTriangleAdjacency(const std::vector<uint32_t>& indices, const size_t vertexCount) {
+    VertexTriangleAdjacency adjacency;
+    adjacency.offsets.resize(vertexCount + 1, 0);
+    for (const uint32_t index : indices) {
+        adjacency.offsets[index + 1]++;
+    }
+    for (size_t v = 0; v < vertexCount; v++) {
+        adjacency.offsets[v + 1] += adjacency.offsets[v];
+    }
+    adjacency.triangles.resize(indices.size());
+    std::vector<uint32_t> fillCounts(vertexCount, 0);
+    for (size_t i = 0; i < indices.size(); i++) {
+        const uint32_t v = indices[i];
+        adjacency.triangles[adjacency.offsets[v] + fillCounts[v]] = uint32_t(i / 3);
+        fillCounts[v]++;
+    }
+    return adjacency;
+}
+
+std::vector<uint32_t> tipsify(const std::vector<uint32_t>& indices, const size_t vertexCount,
+    std::vector<uint32_t>* outClusterBegins) {
+
+    const size_t triangleCount = indices.size() / 3;
+    const VertexTriangleAdjacency adjacency = buildVertexTriangleAdjacency(indices, vertexCount);
+
+    //live triangle count is the number of triangles using the vertex that were not emitted yet
+    std::vector<uint32_t> liveTriangleCounts(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++) {
+        liveTriangleCounts[v] = adjacency.offsets[v + 1] - adjacency.offsets[v];
+    }
+    //a vertex is in the cache if fewer than vertexCacheSize vertices entered it since the vertex did
+    std::vector<uint32_t> cacheTimeStamps(vertexCount, 0);
+    uint32_t time = vertexCacheSize + 1;
+
+    std::vector<bool> isEmitted(triangleCount, false);
+    std::vector<uint32_t> deadEndStack;
+    std::vector<uint32_t> candidates;
+    size_t cursor = 0;
+
+    std::vector<uint32_t> triangleOrder;
+    triangleOrder.reserve(triangleCount);
+
+    //returns a vertex with live triangles, the most recently used ones are preferred, as they are likely in the cache
+    const auto skipDeadEnd = [&]() -> int64_t {
+        while (!deadEndStack.empty()) {
+            const uint32_t v = deadEndStack.back();
+            deadEndStack.pop_back();
+            if (liveTriangleCounts[v] > 0) {
+                return v;
+            }
+        }
+        for (; cursor < vertexCount; cursor++) {
+            if (liveTriangleCounts[cursor] > 0) {
+                return (int64_t)cursor;
+            }
+        }
+        return -1;
+    };
+
+    int64_t fanningVertex = skipDeadEnd();
+    outClusterBegins->clear();
+    outClusterBegins->push_back(0);
+    while (fanningVertex >= 0) {
+        candidates.clear();
+        for (uint32_t i = adjacency.offsets[fanningVertex]; i < adjacency.offsets[fanningVertex + 1]; i++) {
+            const uint32_t triangle = adjacency.triangles[i];
+            if (isEmitted[triangle]) {
+                continue;
+            }
+            for (uint32_t corner = 0; corner < 3; corner++) {
+                const uint32_t v = indices[triangle * 3 + corner];
+                deadEndStack.push_back(v);
+                candidates.push_back(v);
+                liveTriangleCounts[v]--;
+                if (time - cacheTimeStamps[v] > vertexCacheSize) {
+                    cacheTimeStamps[v] = time;
+                    time++;
+                }
+            }
+            isEmitted[triangle] = true;
+            triangleOrder.push_back(triangle);
+        }
+
+        //next fanning vertex is a candidate that stays in the cache while its remaining triangles are emitted
+        //if there is none, the oldest candidate with live triangles is chosen, as it leaves the cache first
+        int64_t nextVertex = -1;
+        int64_t bestPriority = -1;
+        for (const uint32_t v : candidates) {
+            if (liveTriangleCounts[v] == 0) {
+                continue;
+            }
+            int64_t priority = 0;
+            const int64_t age = int64_t(time) - int64_t(cacheTimeStamps[v]);
+            if (age + 2 * int64_t(liveTriangleCounts[v]) <= int64_t(vertexCacheSize)) {
+                priority = age;
+            }
+            if (priority > bestPriority) {
+                bestPriority = priority;
+                nextVertex = v;
+            }
+        }
+        if (nextVertex < 0) {
+            //dead end, the cache content is unrelated to the following triangles, which ends a hard cluster
+            nextVertex = skipDeadEnd();
+            if (nextVertex >= 0 && triangleOrder.size() < triangleCount) {
+                outClusterBegins->push_back((uint32_t)triangleOrder.size());
+            }
+        }
+        fanningVertex = nextVertex;
+    }
+    return triangleOrder;
+}
+
+std::vector<uint32_t> computeSoftClusterBoundaries(const std::vector<uint32_t>& indices, const size_t vertexCount,
+    const std::vector<uint32_t>& triangleOrder, const std::vector<uint32_t>& hardClusterBegins) {
+
+    std::vector<uint32_t> orderedIndices;
+    orderedIndices.reserve(indices.size());
+    for (const uint32_t triangle : triangleOrder) {
+        for (uint32_t i = 0; i < 3; i++) {
+            orderedIndices.push_back(indices[triangle * 3 + i]);
+        }
+    }
+    const float meshACMR = float(countTransformedVertices(orderedIndices, vertexCount)) / float(triangleOrder.size());
+    const float clusterACMRThreshold = meshACMR * overdrawClusterACMRThreshold;
+
+    //cache is simulated from empty for every cluster, as the drawing order of clusters is not known yet
+    std::vector<uint64_t> cacheTimeStamps(vertexCount, 0);
+    uint64_t missCount = 0;
+    const auto resetCache = [&]() {
+        missCount += vertexCacheSize + 1;  //every timestamp is at least a cache size old
+    };
+
+    std::vector<uint32_t> clusterBegins;
+    for (size_t cluster = 0; cluster < hardClusterBegins.size(); cluster++) {
+        const uint32_t hardBegin = hardClusterBegins[cluster];
+        const uint32_t hardEnd = cluster + 1 < hardClusterBegins.size() ? hardClusterBegins[cluster + 1] : (uint32_t)triangleOrder.size();
+
+        clusterBegins.push_back(hardBegin);
+        resetCache();
+        uint64_t clusterStartMissCount = missCount;
+        for (uint32_t triangle = hardBegin; triangle < hardEnd; triangle++) {
+            for (uint32_t i = 0; i < 3; i++) {
+                const uint32_t v = orderedIndices[triangle * 3 + i];
+                if (missCount - cacheTimeStamps[v] >= vertexCacheSize) {
+                    cacheTimeStamps[v] = missCount;
+                    missCount++;
+                }
+            }
+            const uint32_t clusterTriangleCount = triangle + 1 - clusterBegins.back();
+            const float clusterACMR = float(missCount - clusterStartMissCount) / float(clusterTriangleCount);
+            if (clusterACMR <= clusterACMRThreshold && triangle + 1 < hardEnd) {
+                clusterBegins.push_back(triangle + 1);
+                resetCache();
+                clusterStartMissCount = missCount;
+            }
+        }
+    }
+    return clusterBegins;
+}
+
+std::vector<uint32_t> sortClustersForOverdraw(const MeshData& mesh, const std::vector<uint32_t>& triangleOrder,
+    const std::vector<uint32_t>& clusterBegins) {
+
+    struct ClusterSortKey {
+        float sortKey = 0.f;
+        uint32_t begin = 0;
+        uint32_t end = 0;
+    };
+
+    const auto triangleVertex = [&mesh](const uint32_t triangle, const uint32_t corner) {
+        return mesh.indices[triangle * 3 + corner];
+    };
+
+    //geometric normals are only a fallback, they use the winding convention of the runtime, see rasterizeOverdrawView
+    const bool hasVertexNormals = mesh.normals.size() == mesh.positions.size();
+
+    //area weighted centroids, so densely tessellated parts don't pull the mesh centroid
+    std::vector<glm::vec3> clusterCentroids(clusterBegins.size(), glm::vec3(0.f));
+    std::vector<glm::vec3> clusterNormals(clusterBegins.size(), glm::vec3(0.f));
+    std::vector<float> clusterAreas(clusterBegins.size(), 0.f);
+    glm::vec3 meshCentroid = glm::vec3(0.f);
+    float meshArea = 0.f;
+
+    std::vector<ClusterSortKey> clusters(clusterBegins.size());
+    for (size_t cluster = 0; cluster < clusterBegins.size(); cluster++) {
+        clusters[cluster].begin = clusterBegins[cluster];
+        clusters[cluster].end = cluster + 1 < clusterBegins.size() ? clusterBegins[cluster + 1] : (uint32_t)triangleOrder.size();
+        for (uint32_t i = clusters[cluster].begin; i < clusters[cluster].end; i++) {
+            const uint32_t triangle = triangleOrder[i];
+            const glm::vec3 p0 = mesh.positions[triangleVertex(triangle, 0)];
+            const glm::vec3 p1 = mesh.positions[triangleVertex(triangle, 1)];
+            const glm::vec3 p2 = mesh.positions[triangleVertex(triangle, 2)];
+            const float area = 0.5f * glm::length(glm::cross(p1 - p0, p2 - p0));
+            const glm::vec3 centroid = (p0 + p1 + p2) / 3.f;
+            const glm::vec3 normal = hasVertexNormals ?
+                mesh.normals[triangleVertex(triangle, 0)] +
+                mesh.normals[triangleVertex(triangle, 1)] +
+                mesh.normals[triangleVertex(triangle, 2)] :
+                glm::cross(p2 - p0, p1 - p0);
+
+            clusterCentroids[cluster] += centroid * area;
+            clusterNormals[cluster] += normal * area;
+            clusterAreas[cluster] += area;
+        }
+        meshCentroid += clusterCentroids[cluster];
+        meshArea += clusterAreas[cluster];
+    }
+    if (meshArea > 0.f) {
+        meshCentroid /= meshArea;
+    }
+
+    for (size_t cluster = 0; cluster < clusters.size(); cluster++) {
+        if (clusterAreas[cluster] <= 0.f) {
+            continue;
+        }
+        const glm::vec3 centroid = clusterCentroids[cluster] / clusterAreas[cluster];
+        const float normalLength = glm::length(clusterNormals[cluster]);
+        if (normalLength > 0.f) {
+            clusters[cluster].sortKey = glm::dot(centroid - meshCentroid, clusterNormals[cluster] / normalLength);
+        }
+    }
+
+    //stable, so clusters with equal keys keep the cache friendly order
+    std::stable_sort(clusters.begin(), clusters.end(), [](const ClusterSortKey& a, const ClusterSortKey& b) {
+        return a.sortKey > b.sortKey;
+    });
+
+    std::vector<uint32_t> sortedTriangleOrder;
+    sortedTriangleOrder.reserve(triangleOrder.size());
+    for (const ClusterSortKey& cluster : clusters) {
+        sortedTriangleOrder.insert(sortedTriangleOrder.end(),
+            triangleOrder.begin() + cluster.begin, triangleOrder.begin() + cluster.end);
+    }
+    return sortedTriangleOrder;
+}
+
+void reorderVerticesByFirstUse(MeshData* mesh) {
+    const uint32_t unused = std::numeric_limits<uint32_t>::max();
+    const size_t vertexCount = mesh->positions.size();
+    std::vector<uint32_t> oldToNewVertex(vertexCount, unused);
+    std::vector<uint32_t> newToOldVertex;
+    newToOldVertex.reserve(vertexCount);
+
+    for (uint32_t& index : mesh->indices) {
+        if (oldToNewVertex[index] == unused) {
+            oldToNewVertex[index] = (uint32_t)newToOldVertex.size();
+            newToOldVertex.push_back(index);
+        }
+        index = oldToNewVertex[index];
+    }
+    for (uint32_t v = 0; v < vertexCount; v++) {
+        if (oldToNewVertex[v] == unused) {
+            oldToNewVertex[v] = (uint32_t)newToOldVertex.size();
+            newToOldVertex.push_back(v);
+        }
+    }
+
+    mesh->positions     = remapVertexAttribute(mesh->positions, newToOldVertex);
+    mesh->normals       = remapVertexAttribute(mesh->normals, newToOldVertex);
+    mesh->tangents      = remapVertexAttribute(mesh->tangents, newToOldVertex);
+    mesh->bitangents    = remapVertexAttribute(mesh->bitangents, newToOldVertex);
+    mesh->uvs           = remapVertexAttribute(mesh->uvs, newToOldVertex);
+}
+
+template<typename T>
+std::vector<T> remapVertexAttribute(const std::vector<T>& attribute, const std::vector<uint32_t>& newToOldVertex) {
+    if (attribute.empty()) {
+        return attribute;
+    }
+    assert(attribute.size() == newToOldVertex.size());
+    std::vector<T> remapped(newToOldVertex.size());
+    for (size_t i = 0; i < newToOldVertex.size(); i++) {
+        remapped[i] = attribute[newToOldVertex[i]];
+    }
+    return remapped;
+}
+
+uint64_t countTransformedVertices(const std::vector<uint32_t>& indices, const size_t vertexCount) {
+    //timestamps start old enough to be a miss
+    std::vector<uint64_t> cacheTimeStamps(vertexCount, 0);
+    uint64_t missCount = vertexCacheSize;
+    for (const uint32_t v : indices) {
+        if (missCount - cacheTimeStamps[v] >= vertexCacheSize) {
+            cacheTimeStamps[v] = missCount;
+            missCount++;
+        }
+    }
+    return missCount - vertexCacheSize;
+}
+
+void measureOverdraw(const MeshData& mesh, uint64_t* outShadedPixelCount, uint64_t* outCoveredPixelCount) {
+    *outShadedPixelCount = 0;
+    *outCoveredPixelCount = 0;
+    for (int axis = 0; axis < 3; axis++) {
+        for (const bool viewFromPositive : { true, false }) {
+            uint64_t shadedPixelCount = 0;
+            uint64_t coveredPixelCount = 0;
+            rasterizeOverdrawView(mesh, axis, viewFromPositive, &shadedPixelCount, &coveredPixelCount);
+            *outShadedPixelCount += shadedPixelCount;
+            *outCoveredPixelCount += coveredPixelCount;
+        }
+    }
+}
+
+void rasterizeOverdrawView(const MeshData& mesh, const int viewAxis, const bool viewFromPositive,
+    uint64_t* outShadedPixelCount, uint64_t* outCoveredPixelCount) {
+
+    *outShadedPixelCount = 0;
+    *outCoveredPixelCount = 0;
+    if (mesh.positions.empty()) {
+        return;
+    }
+    const int axisU = (viewAxis + 1) % 3;
+    const int axisV = (viewAxis + 2) % 3;
+
+    glm::vec3 bbMin = glm::vec3(std::numeric_limits<float>::infinity());
+    glm::vec3 bbMax = glm::vec3(-std::numeric_limits<float>::infinity());
+    for (const glm::vec3& p : mesh.positions) {
+        bbMin = glm::min(bbMin, p);
+        bbMax = glm::max(bbMax, p);
+    }
+    const float extentU = bbMax[axisU] - bbMin[axisU];
+    const float extentV = bbMax[axisV] - bbMin[axisV];
+    const float maxExtent = glm::max(extentU, extentV);
+    if (maxExtent <= 0.f) {
+        return;
+    }
+    const float pixelPerUnit = overdrawRasterResolution / maxExtent;
+    const int width = glm::max((int)std::ceil(extentU * pixelPerUnit), 1);
+    const int height = glm::max((int)std::ceil(extentV * pixelPerUnit), 1);
+
+    //depth is distance to the viewer, smaller is closer
+    std::vector<float> depthBuffer((size_t)width * height, std::numeric_limits<float>::infinity());
+    const auto projectVertex = [&](const uint32_t index) {
+        const glm::vec3 p = mesh.positions[index];
+        const float depth = viewFromPositive ? bbMax[viewAxis] - p[viewAxis] : p[viewAxis] - bbMin[viewAxis];
+        return glm::vec3((p[axisU] - bbMin[axisU]) * pixelPerUnit, (p[axisV] - bbMin[axisV]) * pixelPerUnit, depth);
+    };
+
+    //the viewer looks along the negative view axis if viewing from the positive side
+    const float viewerSide = viewFromPositive ? 1.f : -1.f;
+
+    for (size_t triangle = 0; triangle + 2 < mesh.indices.size(); triangle += 3) {
+        //the main pass culls back faces, they are never shaded, so they don't count as overdraw
+        //with the runtime camera conventions a triangle faces the viewer if cross(v2 - v0, v1 - v0) points towards it
+        const glm::vec3 v0 = mesh.positions[mesh.indices[triangle]];
+        const glm::vec3 v1 = mesh.positions[mesh.indices[triangle + 1]];
+        const glm::vec3 v2 = mesh.positions[mesh.indices[triangle + 2]];
+        const float facing = glm::cross(v2 - v0, v1 - v0)[viewAxis] * viewerSide;
+        if (facing <= 0.f) {
+            continue;
+        }
+
+        const glm::vec3 p0 = projectVertex(mesh.indices[triangle]);
+        const glm::vec3 p1 = projectVertex(mesh.indices[triangle + 1]);
+        const glm::vec3 p2 = projectVertex(mesh.indices[triangle + 2]);
+
+        //projected winding depends on the view side, normalizing the edge functions by the signed area works for either
+        const float doubleArea = (p1.x - p0.x) * (p2.y - p0.y) - (p2.x - p0.x) * (p1.y - p0.y);
+        if (doubleArea == 0.f) {
+            continue;
+        }
+        const int xMin = glm::max((int)std::floor(glm::min(p0.x, glm::min(p1.x, p2.x))), 0);
+        const int yMin = glm::max((int)std::floor(glm::min(p0.y, glm::min(p1.y, p2.y))), 0);
+        const int xMax = glm::min((int)std::ceil(glm::max(p0.x, glm::max(p1.x, p2.x))), width - 1);
+        const int yMax = glm::min((int)std::ceil(glm::max(p0.y, glm::max(p1.y, p2.y))), height - 1);
+
+        for (int y = yMin; y <= yMax; y++) {
+            for (int x = xMin; x <= xMax; x++) {
+                const float px = x + 0.5f;
+                const float py = y + 0.5f;
+                const float w0 = ((p1.x - px) * (p2.y - py) - (p2.x - px) * (p1.y - py)) / doubleArea;
+                const float w1 = ((p2.x - px) * (p0.y - py) - (p0.x - px) * (p2.y - py)) / doubleArea;
+                const float w2 = 1.f - w0 - w1;
+                if (w0 < 0.f || w1 < 0.f || w2 < 0.f) {
+                    continue;
+                }
+                const float depth = w0 * p0.z + w1 * p1.z + w2 * p2.z;
+                float& bufferDepth = depthBuffer[(size_t)y * width + x];
+                if (depth < bufferDepth) {
+                    bufferDepth = depth;
+                    (*outShadedPixelCount)++;
+                }
+            }
+        }
+    }
+    for (const float depth : depthBuffer) {
+        if (depth < std::numeric_limits<float>::infinity()) {
+            (*outCoveredPixelCount)++;
+        }
+    }
+}
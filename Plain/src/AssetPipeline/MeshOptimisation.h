@@ -0,0 +1,33 @@
+#pragma once
+#include "pch.h"
+#include "Common/MeshData.h"
+
+//size of the simulated FIFO post transform vertex cache, triangles are ordered for it
+const uint32_t vertexCacheSize = 16;
+
+//sums of all measured meshes, ratios are computed from the sums, so large meshes have more weight
+struct MeshOrderStatistics {
+    uint64_t triangleCount = 0;
+    uint64_t vertexCount = 0;
+    uint64_t transformedVertexCount = 0;    //cache misses of the simulated vertex cache
+    uint64_t shadedPixelCount = 0;          //pixels passing the depth test, summed over all views
+    uint64_t coveredPixelCount = 0;         //pixels covered in the final image, summed over all views
+};
+
+//ACMR and ATVR are measured with a FIFO cache of vertexCacheSize
+//overdraw is measured by rasterizing each mesh from the six axis directions, with depth test and backface culling like the main pass
+//meshes are measured in parallel using the job system
+MeshOrderStatistics computeMeshOrderStatistics(const std::vector<MeshData>& meshes);
+
+//prints average cache miss ratio (ACMR), average transform to vertex ratio (ATVR) and overdraw
+void printMeshOrderStatistics(const MeshOrderStatistics& before, const MeshOrderStatistics& after);
+
+//triangles are reordered for vertex cache locality using Tipsify
+//the resulting triangle clusters are then sorted so outer, outwards facing clusters are drawn first, reducing overdraw
+//finally vertices are reordered by first use, for vertex fetch locality
+//triangle winding is kept, vertices not referenced by any triangle keep their relative order at the end
+//reference: "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw", Sander et al.
+void optimiseMeshOrder(MeshData* mesh);
+
+//optimises all meshes in parallel using the job system
+void optimiseMeshOrder(std::vector<MeshData>* meshes);
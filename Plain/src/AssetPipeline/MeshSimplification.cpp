@@ -0,0 +1,621 @@
+#include "pch.h"
+#include "MeshSimplification.h"
+#include "Common/JobSystem.h"
+#include <algorithm>
+#include <unordered_map>
+
+// ---- private types and function declarations ----
+
+//symmetric error quadric of a set of weighted planes
+//error is divided by the summed weight, so it is the weighted mean squared distance to the planes
+struct Quadric {
+    double a00 = 0.0, a01 = 0.0, a02 = 0.0, a11 = 0.0, a12 = 0.0, a22 = 0.0;
+    double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+    double c = 0.0;
+    double weight = 0.0;
+};
+
+//manifold vertices can collapse into any neighbour, border and seam vertices only along border and seam edges
+//locked vertices are never moved, but other vertices can collapse into them
+enum class VertexKind : uint8_t { Manifold, Border, Seam, Locked };
+
+//triangles using each position, stored in compressed sparse row layout, indexed by position id
+struct PositionTriangleAdjacency {
+    std::vector<uint32_t> offsets;      //vertexCount + 1 entries, triangles of position p are in [offsets[p], offsets[p + 1])
+    std::vector<uint32_t> triangles;
+};
+
+//state of a mesh during simplification, kept between levels of detail, so quadrics keep accumulating
+struct SimplificationState {
+    const MeshData*         mesh = nullptr;
+    std::vector<uint32_t>   positionIds;        //per vertex, lowest vertex index with a bitwise equal position
+    std::vector<Quadric>    quadrics;           //indexed by position id
+    std::vector<uint32_t>   indices;            //current triangles, referencing vertices of the full detail mesh
+    float                   maxCollapseError = 0.f;    //squared distance
+};
+
+//triangles sharing the edge between two positions, seam edges are used by two triangles with different vertices
+struct EdgeInfo {
+    uint32_t triangleCount = 0;
+    bool isSeam = false;
+};
+
+//vertices of a collapsed position are moved onto the vertex of the target position they share an edge with
+struct CollapseCandidate {
+    uint32_t position = 0;
+    uint32_t targetPosition = 0;
+    float cost = 0.f;           //error including normal penalty, used for ordering
+    float error = 0.f;          //positional error only
+    uint32_t vertexCount = 0;
+    std::array<uint32_t, 2> vertices;
+    std::array<uint32_t, 2> targetVertices;
+};
+
+//border and seam edges add a plane perpendicular to their triangle, so collapses moving them are penalized
+//value is taken from meshoptimizer
+const float boundaryEdgeWeight = 2.f;
+
+//cost of moving a vertex onto one with a different normal, scaled by the squared collapse length
+const float normalChangePenalty = 0.5f;
+
+//collapses changing a triangle normal by more than the angle of this cosine are rejected, this prevents flips and slivers
+const float maxTriangleNormalChangeCos = 0.25f;
+
+//levels that don't reduce the triangle count of the previous level to this ratio are discarded, and the chain ends
+const float meshLodMaxAchievedRatio = 0.85f;
+
+void addPlaneToQuadric(const glm::vec3& normal, const float distance, const double weight, Quadric* quadric);
+void addQuadric(const Quadric& src, Quadric* dst);
+float evaluateQuadric(const Quadric& quadric, const glm::vec3& p);
+
+std::vector<uint32_t> computePositionIds(const std::vector<glm::vec3>& positions);
+
+PositionTriangleAdjacency buildPositionTriangleAdjacency(const std::vector<uint32_t>& indices,
+    const std::vector<uint32_t>& positionIds);
+
+EdgeInfo getEdgeInfo(const SimplificationState& state, const PositionTriangleAdjacency& adjacency,
+    const uint32_t position, const uint32_t otherPosition);
+
+//returns the distinct neighbour positions of a position
+std::vector<uint32_t> getNeighbourPositions(const SimplificationState& state, const PositionTriangleAdjacency& adjacency,
+    const uint32_t position);
+
+std::vector<VertexKind> classifyVertices(const SimplificationState& state, const PositionTriangleAdjacency& adjacency);
+
+//triangle planes weighted by area and boundary edge planes
+void initQuadrics(SimplificationState* state, const PositionTriangleAdjacency& adjacency);
+
+//returns false if no valid collapse of position exists
+bool findBestCollapse(const SimplificationState& state, const PositionTriangleAdjacency& adjacency,
+    const std::vector<VertexKind>& vertexKinds, const uint32_t position, CollapseCandidate* outCandidate);
+
+//true if moving position onto targetPosition flips or strongly rotates any remaining triangle
+bool hasTriangleFlip(const SimplificationState& state, const PositionTriangleAdjacency& adjacency,
+    const uint32_t position, const uint32_t targetPosition);
+
+//collapses are performed in passes, every pass collapses the cheapest edges with disjoint neighbourhoods
+void simplifyToTriangleCount(SimplificationState* state, const size_t targetTriangleCount);
+
+//removes triangles with two corners at the same position
+void removeDegenerateTriangles(SimplificationState* state);
+
+// ---- implementation ----
+
+void generateMeshLods(MeshData* mesh) {
+    mesh->lods.clear();
+    if (mesh->indices.size() / 3 < meshLodMinTriangleCount || mesh->positions.empty()) {
+        return;
+    }
+
+    SimplificationState state;
+    state.mesh = mesh;
+    state.positionIds = computePositionIds(mesh->positions);
+    state.indices = mesh->indices;
+    removeDegenerateTriangles(&state);
+
+    const PositionTriangleAdjacency adjacency = buildPositionTriangleAdjacency(state.indices, state.positionIds);
+    initQuadrics(&state, adjacency);
+
+    size_t previousTriangleCount = mesh->indices.size() / 3;
+    for (uint32_t level = 0; level < maxMeshLodCount; level++) {
+        if (previousTriangleCount < meshLodMinTriangleCount) {
+            break;
+        }
+        const size_t targetTriangleCount = size_t(previousTriangleCount * meshLodTriangleRatio);
+        simplifyToTriangleCount(&state, targetTriangleCount);
+
+        const size_t triangleCount = state.indices.size() / 3;
+        if (triangleCount > previousTriangleCount * meshLodMaxAchievedRatio || triangleCount == 0) {
+            break;
+        }
+        MeshDataLod lod;
+        lod.indices = state.indices;
+        lod.error = glm::sqrt(state.maxCollapseError);
+        mesh->lods.push_back(lod);
+        previousTriangleCount = triangleCount;
+    }
+}
+
+void generateMeshLods(std::vector<MeshData>* meshes) {
+    JobSystem::parallelFor(0, meshes->size(), 1, [meshes](const size_t rangeBegin, const size_t rangeEnd, int) {
+        for (size_t i = rangeBegin; i < rangeEnd; i++) {
+            generateMeshLods(&(*meshes)[i]);
+        }
+    });
+}
+
+void printMeshLodStatistics(const std::vector<MeshData>& meshes) {
+    std::vector<uint64_t> triangleCountPerLevel(maxMeshLodCount + 1, 0);
+    std::vector<uint64_t> meshCountPerLevel(maxMeshLodCount + 1, 0);
+    for (const MeshData& mesh : meshes) {
+        triangleCountPerLevel[0] += mesh.indices.size() / 3;
+        meshCountPerLevel[0]++;
+        for (size_t level = 0; level < mesh.lods.size(); level++) {
+            triangleCountPerLevel[level + 1] += mesh.lods[level].indices.size() / 3;
+            meshCountPerLevel[level + 1]++;
+        }
+    }
+    std::cout << "Mesh levels of detail\n";
+    for (size_t level = 0; level < triangleCountPerLevel.size(); level++) {
+        std::cout << "    LOD" << level << ": " << meshCountPerLevel[level] << " meshes, "
+            << triangleCountPerLevel[level] << " triangles\n";
+    }
+}
+
+void addPlaneToQuadric(const glm::vec3& normal, const float distance, const double weight, Quadric* quadric) {
+    const double nx = normal.x;
+    const double ny = normal.y;
+    const double nz = normal.z;
+    const double d = distance;
+    quadric->a00 += weight * nx * nx;
+    quadric->a01 += weight * nx * ny;
+    quadric->a02 += weight * nx * nz;
+    quadric->a11 += weight * ny * ny;
+    quadric->a12 += weight * ny * nz;
+    quadric->a22 += weight * nz * nz;
+    quadric->b0 += weight * nx * d;
+    quadric->b1 += weight * ny * d;
+    quadric->b2 += weight * nz * d;
+    quadric->c += weight * d * d;
+    quadric->weight += weight;
+}
+
+void addQuadric(const Quadric& src, Quadric* dst) {
+    dst->a00 += src.a00;
+    dst->a01 += src.a01;
+    dst->a02 += src.a02;
+    dst->a11 += src.a11;
+    dst->a12 += src.a12;
+    dst->a22 += src.a22;
+    dst->b0 += src.b0;
+    dst->b1 += src.b1;
+    dst->b2 += src.b2;
+    dst->c += src.c;
+    dst->weight += src.weight;
+}
+
+float evaluateQuadric(const Quadric& quadric, const glm::vec3& p) {
+    if (quadric.weight <= 0.0) {
+        return 0.f;
+    }
+    const double x = p.x;
+    const double y = p.y;
+    const double z = p.z;
+    const double error =
+        quadric.a00 * x * x + 2.0 * quadric.a01 * x * y + 2.0 * quadric.a02 * x * z +
+        quadric.a11 * y * y + 2.0 * quadric.a12 * y * z +
+        quadric.a22 * z * z +
+        2.0 * (quadric.b0 * x + quadric.b1 * y + quadric.b2 * z) +
+        quadric.c;
+    //can be slightly negative because of rounding
+    return float(std::max(error / quadric.weight, 0.0));
+}
+
+std::vector<uint32_t> computePositionIds(const std::vector<glm::vec3>& positions) {
+    const auto hashPosition = [](const glm::vec3& p) {
+        uint32_t bits[3];
+        memcpy(bits, &p, sizeof(bits));
+        return size_t(bits[0] * 73856093u ^ bits[1] * 19349663u ^ bits[2] * 83492791u);
+    };
+    //compared bitwise, keys are canonicalized so -0 and 0 are equal
+    const auto isPositionEqual = [](const glm::vec3& a, const glm::vec3& b) {
+        return memcmp(&a, &b, sizeof(glm::vec3)) == 0;
+    };
+    std::unordered_map<glm::vec3, uint32_t, decltype(hashPosition), decltype(isPositionEqual)> firstVertexOfPosition(
+        positions.size(), hashPosition, isPositionEqual);
+
+    std::vector<uint32_t> positionIds(positions.size());
+    for (uint32_t v = 0; v < positions.size(); v++) {
+        //adding zero turns -0 into 0
+        const glm::vec3 key = positions[v] + glm::vec3(0.f);
+        positionIds[v] = firstVertexOfPosition.emplace(key, v).first->second;
+    }
+    return positionIds;
+}
+
+PositionTriangleAdjacency buildPositionTriangleAdjacency(const std::vector<uint32_t>& indices,
+    const std::vector<uint32_t>& positionIds) {
+
+    const size_t vertexCount = positionIds.size();
+    PositionTriangleAdjacency adjacency;
+    adjacency.offsets.resize(vertexCount + 1, 0);
+    for (const uint32_t index : indices) {
+        adjacency.offsets[positionIds[index] + 1]++;
+    }
+    for (size_t v = 0; v < vertexCount; v++) {
+        adjacency.offsets[v + 1] += adjacency.offsets[v];
+    }
+    adjacency.triangles.resize(indices.size());
+    std::vector<uint32_t> fillCounts(vertexCount, 0);
+    for (size_t i = 0; i < indices.size(); i++) {
+        const uint32_t p = positionIds[indices[i]];
+        adjacency.triangles[adjacency.offsets[p] + fillCounts[p]] = uint32_t(i / 3);
+        fillCounts[p]++;
+    }
+    return adjacency;
+}
+
+EdgeInfo getEdgeInfo(const SimplificationState& state, const PositionTriangleAdjacency& adjacency,
+    const uint32_t position, const uint32_t otherPosition) {
+
+    EdgeInfo info;
+    uint32_t firstVertex = 0;
+    uint32_t firstOtherVertex = 0;
+    for (uint32_t i = adjacency.offsets[position]; i < adjacency.offsets[position + 1]; i++) {
+        const uint32_t triangle = adjacency.triangles[i];
+        uint32_t vertex = 0;
+        uint32_t otherVertex = 0;
+        bool containsOther = false;
+        for (uint32_t corner = 0; corner < 3; corner++) {
+            const uint32_t v = state.indices[triangle * 3 + corner];
+            if (state.positionIds[v] == position) {
+                vertex = v;
+            }
+            else if (state.positionIds[v] == otherPosition) {
+                otherVertex = v;
+                containsOther = true;
+            }
+        }
+        if (!containsOther) {
+            continue;
+        }
+        if (info.triangleCount == 0) {
+            firstVertex = vertex;
+            firstOtherVertex = otherVertex;
+        }
+        else if (vertex != firstVertex || otherVertex != firstOtherVertex) {
+            info.isSeam = true;
+        }
+        info.triangleCount++;
+    }
+    return info;
+}
+
+std::vector<uint32_t> getNeighbourPositions(const SimplificationState& state, const PositionTriangleAdjacency& adjacency,
+    const uint32_t position) {
+
+    std::vector<uint32_t> neighbours;
+    for (uint32_t i = adjacency.offsets[position]; i < adjacency.offsets[position + 1]; i++) {
+        const uint32_t triangle = adjacency.triangles[i];
+        for (uint32_t corner = 0; corner < 3; corner++) {
+            const uint32_t p = state.positionIds[state.indices[triangle * 3 + corner]];
+            if (p != position && std::find(neighbours.begin(), neighbours.end(), p) == neighbours.end()) {
+                neighbours.push_back(p);
+            }
+        }
+    }
+    return neighbours;
+}
+
+std::vector<VertexKind> classifyVertices(const SimplificationState& state, const PositionTriangleAdjacency& adjacency) {
+    const size_t vertexCount = state.positionIds.size();
+    std::vector<VertexKind> kinds(vertexCount, VertexKind::Locked);
+
+    for (uint32_t p = 0; p < vertexCount; p++) {
+        const bool isPositionId = state.positionIds[p] == p;
+        const bool hasTriangles = adjacency.offsets[p + 1] > adjacency.offsets[p];
+        if (!isPositionId || !hasTriangles) {
+            continue;
+        }
+
+        //vertices with equal position, but different attributes
+        std::array<uint32_t, 2> usedVertices;
+        uint32_t usedVertexCount = 0;
+        bool hasTooManyVertices = false;
+        for (uint32_t i = adjacency.offsets[p]; i < adjacency.offsets[p + 1] && !hasTooManyVertices; i++) {
+            const uint32_t triangle = adjacency.triangles[i];
+            for (uint32_t corner = 0; corner < 3; corner++) {
+                const uint32_t v = state.indices[triangle * 3 + corner];
+                const bool isNew = state.positionIds[v] == p &&
+                    std::find(usedVertices.begin(), usedVertices.begin() + usedVertexCount, v) == usedVertices.begin() + usedVertexCount;
+                if (isNew) {
+                    if (usedVertexCount == 2) {
+                        hasTooManyVertices = true;
+                        break;
+                    }
+                    usedVertices[usedVertexCount++] = v;
+                }
+            }
+        }
+        if (hasTooManyVertices) {
+            continue;
+        }
+
+        uint32_t borderEdgeCount = 0;
+        uint32_t seamEdgeCount = 0;
+        bool isNonManifold = false;
+        for (const uint32_t neighbour : getNeighbourPositions(state, adjacency, p)) {
+            const EdgeInfo edge = getEdgeInfo(state, adjacency, p, neighbour);
+            borderEdgeCount += edge.triangleCount == 1 ? 1 : 0;
+            seamEdgeCount += edge.isSeam ? 1 : 0;
+            isNonManifold |= edge.triangleCount > 2;
+        }
+
+        //seam and border vertices must lie on a single line, so collapses along it keep its shape
+        const bool isSeam = usedVertexCount == 2;
+        const bool isBorder = borderEdgeCount > 0;
+        if (isNonManifold || (isSeam && isBorder)) {
+            continue;
+        }
+        if (isSeam) {
+            kinds[p] = seamEdgeCount == 2 ? VertexKind::Seam : VertexKind::Locked;
+        }
+        else if (isBorder) {
+            kinds[p] = borderEdgeCount == 2 ? VertexKind::Border : VertexKind::Locked;
+        }
+        else {
+            kinds[p] = VertexKind::Manifold;
+        }
+    }
+    return kinds;
+}
+
+void initQuadrics(SimplificationState* state, const PositionTriangleAdjacency& adjacency) {
+    const std::vector<glm::vec3>& positions = state->mesh->positions;
+    state->quadrics.resize(state->positionIds.size());
+
+    for (size_t triangle = 0; triangle < state->indices.size() / 3; triangle++) {
+        std::array<uint32_t, 3> triangleVertices;
+        for (uint32_t corner = 0; corner < 3; corner++) {
+            triangleVertices[corner] = state->indices[triangle * 3 + corner];
+        }
+        const glm::vec3 p0 = positions[triangleVertices[0]];
+        const glm::vec3 p1 = positions[triangleVertices[1]];
+        const glm::vec3 p2 = positions[triangleVertices[2]];
+        const glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+        const float nLength = glm::length(n);
+        if (nLength <= 0.f) {
+            continue;
+        }
+        const glm::vec3 normal = n / nLength;
+        const float area = nLength * 0.5f;
+
+        for (uint32_t corner = 0; corner < 3; corner++) {
+            const uint32_t position = state->positionIds[triangleVertices[corner]];
+            addPlaneToQuadric(normal, -glm::dot(normal, p0), area, &state->quadrics[position]);
+        }
+
+        for (uint32_t edgeStart = 0; edgeStart < 3; edgeStart++) {
+            const uint32_t position = state->positionIds[triangleVertices[edgeStart]];
+            const uint32_t otherPosition = state->positionIds[triangleVertices[(edgeStart + 1) % 3]];
+            const EdgeInfo edge = getEdgeInfo(*state, adjacency, position, otherPosition);
+            if (edge.triangleCount != 1 && !edge.isSeam) {
+                continue;
+            }
+            const glm::vec3 edgeStartPosition = positions[position];
+            const glm::vec3 edgeVector = positions[otherPosition] - edgeStartPosition;
+            const float edgeLength = glm::length(edgeVector);
+            if (edgeLength <= 0.f) {
+                continue;
+            }
+            const glm::vec3 edgeNormal = glm::normalize(glm::cross(edgeVector, normal));
+            const double weight = double(edgeLength) * double(edgeLength) * boundaryEdgeWeight;
+            const float distance = -glm::dot(edgeNormal, edgeStartPosition);
+            addPlaneToQuadric(edgeNormal, distance, weight, &state->quadrics[position]);
+            addPlaneToQuadric(edgeNormal, distance, weight, &state->quadrics[otherPosition]);
+        }
+    }
+}
+
+bool findBestCollapse(const SimplificationState& state, const PositionTriangleAdjacency& adjacency,
+    const std::vector<VertexKind>& vertexKinds, const uint32_t position, CollapseCandidate* outCandidate) {
+
+    const VertexKind kind = vertexKinds[position];
+    if (kind == VertexKind::Locked) {
+        return false;
+    }
+    const std::vector<glm::vec3>& positions = state.mesh->positions;
+    const std::vector<glm::vec3>& normals = state.mesh->normals;
+    const bool hasNormals = normals.size() == positions.size();
+
+    bool foundCollapse = false;
+    for (const uint32_t target : getNeighbourPositions(state, adjacency, position)) {
+        const EdgeInfo edge = getEdgeInfo(state, adjacency, position, target);
+        if (kind == VertexKind::Border && edge.triangleCount != 1) {
+            continue;
+        }
+        if (kind == VertexKind::Seam && !edge.isSeam) {
+            continue;
+        }
+
+        //every vertex of position must share an edge with exactly one vertex of target
+        //moving it onto that vertex keeps attributes consistent on both sides of seams
+        CollapseCandidate candidate;
+        candidate.position = position;
+        candidate.targetPosition = target;
+        bool isConsistent = true;
+        for (uint32_t i = adjacency.offsets[position]; i < adjacency.offsets[position + 1] && isConsistent; i++) {
+            const uint32_t triangle = adjacency.triangles[i];
+            uint32_t vertex = 0;
+            uint32_t targetVertex = 0;
+            bool containsTarget = false;
+            for (uint32_t corner = 0; corner < 3; corner++) {
+                const uint32_t v = state.indices[triangle * 3 + corner];
+                if (state.positionIds[v] == position) {
+                    vertex = v;
+                }
+                else if (state.positionIds[v] == target) {
+                    targetVertex = v;
+                    containsTarget = true;
+                }
+            }
+            if (!containsTarget) {
+                continue;
+            }
+            const auto verticesEnd = candidate.vertices.begin() + candidate.vertexCount;
+            const auto existing = std::find(candidate.vertices.begin(), verticesEnd, vertex);
+            if (existing == verticesEnd) {
+                if (candidate.vertexCount == 2) {
+                    isConsistent = false;
+                    break;
+                }
+                candidate.vertices[candidate.vertexCount] = vertex;
+                candidate.targetVertices[candidate.vertexCount] = targetVertex;
+                candidate.vertexCount++;
+            }
+            else {
+                isConsistent &= candidate.targetVertices[existing - candidate.vertices.begin()] == targetVertex;
+            }
+        }
+        //vertices of position that don't touch target would have no vertex to move onto
+        const uint32_t requiredVertexCount = kind == VertexKind::Seam ? 2 : 1;
+        if (!isConsistent || candidate.vertexCount != requiredVertexCount) {
+            continue;
+        }
+        if (hasTriangleFlip(state, adjacency, position, target)) {
+            continue;
+        }
+
+        const glm::vec3 collapseVector = positions[target] - positions[position];
+        const float collapseLengthSquared = glm::dot(collapseVector, collapseVector);
+        float normalChange = 0.f;
+        if (hasNormals) {
+            for (uint32_t i = 0; i < candidate.vertexCount; i++) {
+                const float normalDot = glm::dot(normals[candidate.vertices[i]], normals[candidate.targetVertices[i]]);
+                normalChange = glm::max(normalChange, 1.f - normalDot);
+            }
+        }
+        candidate.error = evaluateQuadric(state.quadrics[position], positions[target]);
+        candidate.cost = candidate.error + normalChangePenalty * normalChange * collapseLengthSquared;
+
+        if (!foundCollapse || candidate.cost < outCandidate->cost) {
+            *outCandidate = candidate;
+            foundCollapse = true;
+        }
+    }
+    return foundCollapse;
+}
+
+bool hasTriangleFlip(const SimplificationState& state, const PositionTriangleAdjacency& adjacency,
+    const uint32_t position, const uint32_t targetPosition) {
+
+    const std::vector<glm::vec3>& positions = state.mesh->positions;
+    for (uint32_t i = adjacency.offsets[position]; i < adjacency.offsets[position + 1]; i++) {
+        const uint32_t triangle = adjacency.triangles[i];
+        std::array<glm::vec3, 3> before;
+        std::array<glm::vec3, 3> after;
+        bool containsTarget = false;
+        for (uint32_t corner = 0; corner < 3; corner++) {
+            const uint32_t p = state.positionIds[state.indices[triangle * 3 + corner]];
+            containsTarget |= p == targetPosition;
+            before[corner] = positions[p];
+            after[corner] = p == position ? positions[targetPosition] : positions[p];
+        }
+        //triangles along the collapsed edge are removed
+        if (containsTarget) {
+            continue;
+        }
+        const glm::vec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+        const glm::vec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+        const float lengthProduct = glm::length(normalBefore) * glm::length(normalAfter);
+        if (glm::dot(normalBefore, normalAfter) <= maxTriangleNormalChangeCos * lengthProduct) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void simplifyToTriangleCount(SimplificationState* state, const size_t targetTriangleCount) {
+    const size_t vertexCount = state->positionIds.size();
+
+    while (state->indices.size() / 3 > targetTriangleCount) {
+        const PositionTriangleAdjacency adjacency = buildPositionTriangleAdjacency(state->indices, state->positionIds);
+        const std::vector<VertexKind> vertexKinds = classifyVertices(*state, adjacency);
+
+        std::vector<CollapseCandidate> candidates;
+        for (uint32_t p = 0; p < vertexCount; p++) {
+            CollapseCandidate candidate;
+            if (state->positionIds[p] == p && findBestCollapse(*state, adjacency, vertexKinds, p, &candidate)) {
+                candidates.push_back(candidate);
+            }
+        }
+        if (candidates.empty()) {
+            break;
+        }
+        std::sort(candidates.begin(), candidates.end(), [](const CollapseCandidate& a, const CollapseCandidate& b) {
+            return a.cost < b.cost;
+        });
+
+        //every collapse removes about two triangles
+        //candidates much more expensive than needed for the goal are left for the next pass, as their cost may change
+        size_t triangleCount = state->indices.size() / 3;
+        const size_t collapseGoal = std::max<size_t>((triangleCount - targetTriangleCount) / 2, 1);
+        const float passCostLimit = candidates[std::min(collapseGoal, candidates.size()) - 1].cost * 1.5f;
+
+        //collapses lock the neighbourhood of the collapsed position, so every collapse sees unchanged triangles
+        std::vector<uint8_t> isLockedInPass(vertexCount, 0);
+        std::vector<uint32_t> vertexRemap(vertexCount);
+        for (uint32_t v = 0; v < vertexCount; v++) {
+            vertexRemap[v] = v;
+        }
+        size_t collapseCount = 0;
+        for (const CollapseCandidate& candidate : candidates) {
+            if (triangleCount <= targetTriangleCount || candidate.cost > passCostLimit) {
+                break;
+            }
+            if (isLockedInPass[candidate.position] || isLockedInPass[candidate.targetPosition]) {
+                continue;
+            }
+            for (uint32_t i = 0; i < candidate.vertexCount; i++) {
+                vertexRemap[candidate.vertices[i]] = candidate.targetVertices[i];
+            }
+            addQuadric(state->quadrics[candidate.position], &state->quadrics[candidate.targetPosition]);
+            state->maxCollapseError = glm::max(state->maxCollapseError, candidate.error);
+
+            for (uint32_t i = adjacency.offsets[candidate.position]; i < adjacency.offsets[candidate.position + 1]; i++) {
+                const uint32_t triangle = adjacency.triangles[i];
+                bool containsTarget = false;
+                for (uint32_t corner = 0; corner < 3; corner++) {
+                    const uint32_t p = state->positionIds[state->indices[triangle * 3 + corner]];
+                    isLockedInPass[p] = 1;
+                    containsTarget |= p == candidate.targetPosition;
+                }
+                triangleCount -= containsTarget ? 1 : 0;
+            }
+            collapseCount++;
+        }
+        if (collapseCount == 0) {
+            break;
+        }
+        for (uint32_t& index : state->indices) {
+            index = vertexRemap[index];
+        }
+        removeDegenerateTriangles(state);
+    }
+}
+
+void removeDegenerateTriangles(SimplificationState* state) {
+    size_t writeIndex = 0;
+    for (size_t i = 0; i < state->indices.size(); i += 3) {
+        const uint32_t p0 = state->positionIds[state->indices[i]];
+        const uint32_t p1 = state->positionIds[state->indices[i + 1]];
+        const uint32_t p2 = state->positionIds[state->indices[i + 2]];
+        if (p0 == p1 || p1 == p2 || p0 == p2) {
+            continue;
+        }
+        for (size_t corner = 0; corner < 3; corner++) {
+            state->indices[writeIndex++] = state->indices[i + corner];
+        }
+    }
+    state->indices.resize(writeIndex);
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include "pch.h"
+#include "Common/MeshData.h"
+
+//at most this many levels are generated per mesh, in addition to the full detail mesh
+const uint32_t maxMeshLodCount = 4;
+
+//every level targets this ratio of the triangle count of the previous level
+const float meshLodTriangleRatio = 0.5f;
+
+//levels are only generated for meshes with at least this many triangles in the previous level
+const uint32_t meshLodMinTriangleCount = 64;
+
+//generates coarser levels of detail into mesh.lods, using quadric error metric edge collapse
+//collapses move a vertex onto a neighbouring one, so all levels reference the vertex attributes of the full detail mesh
+//vertices with equal positions but different attributes form UV or normal seams, seams and open borders are only collapsed along themselves
+//collapses that change vertex normals are penalized, triangles flipping their orientation are prevented
+//the chain ends early if a level can't reduce the triangle count enough, e.g. because too many vertices are locked
+//reference: "Surface Simplification Using Quadric Error Metrics", Garland and Heckbert
+//reference: "meshoptimizer", Arseny Kapoulkine, meshopt_simplify
+void generateMeshLods(MeshData* mesh);
+
+//generates levels of detail of all meshes in parallel using the job system
+void generateMeshLods(std::vector<MeshData>* meshes);
+
+//prints triangle count per level, summed over all meshes
+void printMeshLodStatistics(const std::vector<MeshData>& meshes);
@@ -247,9 +247,12 @@ bool loadModelGLTF(const std::filesystem::path& filename, Scene* outScene) {
                 primitiveName += primitiveIndex > 0 ? "_" + std::to_string(primitiveIndex) : "";
                 data.texturePaths.sdfTexturePath = modelDirectory / "sdfTextures" / primitiveName;
                 data.texturePaths.sdfTexturePath += ".dds";
+                data.texturePaths.sdfIndirectionTexturePath = modelDirectory / "sdfTextures" / primitiveName;
+                data.texturePaths.sdfIndirectionTexturePath += "_indirection.dds";
             }
             else {
                 data.texturePaths.sdfTexturePath.clear();
+                data.texturePaths.sdfIndirectionTexturePath.clear();
             }
 
             primitiveList.push_back(outScene->meshes.size());
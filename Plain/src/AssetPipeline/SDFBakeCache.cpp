@@ -0,0 +1,107 @@
+#include "pch.h"
+#include "SDFBakeCache.h"
+
+//stored in the SDF texture directory of a model
+constexpr const char* sdfBakeCacheFileName = "bakeCache.txt";
+
+// ---- private function declarations ----
+
+//64 bit FNV-1a, hash is continued from inOutHash
+void hashBytes(const void* data, const size_t size, uint64_t* inOutHash);
+
+// ---- implementation ----
+
+void loadSDFBakeCache(const std::filesystem::path& sdfTextureDirectory, SDFBakeCache* outCache) {
+    outCache->filePath = sdfTextureDirectory / sdfBakeCacheFileName;
+    outCache->entries.clear();
+
+    std::ifstream file(outCache->filePath);
+    if (!file.is_open()) {
+        return;
+    }
+    //one entry per line: hash as hex, space, texture file name
+    std::string line;
+    while (std::getline(file, line)) {
+        const size_t separator = line.find(' ');
+        if (separator == std::string::npos) {
+            continue;
+        }
+        uint64_t hash = 0;
+        const std::from_chars_result result = std::from_chars(line.data(), line.data() + separator, hash, 16);
+        if (result.ec != std::errc() || result.ptr != line.data() + separator) {
+            std::cout << "Skipping invalid SDF bake cache entry: " << line << "\n";
+            continue;
+        }
+        outCache->entries[line.substr(separator + 1)] = hash;
+    }
+}
+
+bool saveSDFBakeCache(SDFBakeCache& cache) {
+    std::lock_guard<std::mutex> lock(cache.entryMutex);
+    std::error_code error; //directory is created by the first bake if this fails
+    std::filesystem::create_directories(cache.filePath.parent_path(), error);
+    std::ofstream file(cache.filePath);
+    if (!file.is_open()) {
+        std::cout << "Failed to write SDF bake cache: " << cache.filePath << "\n";
+        return false;
+    }
+    for (const auto& [textureName, hash] : cache.entries) {
+        file << std::hex << hash << " " << textureName << "\n";
+    }
+    return true;
+}
+
+uint64_t computeSDFBakeHash(const MeshData& mesh, const AxisAlignedBoundingBox& meshBB, const SDFBakeMethod bakeMethod,
+    const SDFAtlasFormat atlasFormat) {
+    uint64_t hash = 14695981039346656037ull;    //FNV offset basis
+
+    hashBytes(&sdfBakerVersion, sizeof(sdfBakerVersion), &hash);
+    hashBytes(&bakeMethod, sizeof(bakeMethod), &hash);
+    hashBytes(&atlasFormat, sizeof(atlasFormat), &hash);
+
+    //resolution policy can change without the mesh changing
+    const glm::uvec3 brickGridResolution = computeSDFBrickGridResolution(meshBB);
+    hashBytes(&brickGridResolution, sizeof(brickGridResolution), &hash);
+    hashBytes(&sdfBrickSize, sizeof(sdfBrickSize), &hash);
+
+    //sizes are included, so moving data from positions to indices changes the hash
+    const uint64_t positionCount = mesh.positions.size();
+    const uint64_t indexCount = mesh.indices.size();
+    hashBytes(&positionCount, sizeof(positionCount), &hash);
+    hashBytes(mesh.positions.data(), mesh.positions.size() * sizeof(glm::vec3), &hash);
+    hashBytes(&indexCount, sizeof(indexCount), &hash);
+    hashBytes(mesh.indices.data(), mesh.indices.size() * sizeof(uint32_t), &hash);
+    return hash;
+}
+
+bool isSDFTextureCached(SDFBakeCache& cache, const TexturePaths& texturePaths, const uint64_t bakeHash) {
+    std::lock_guard<std::mutex> lock(cache.entryMutex);
+    const auto entry = cache.entries.find(texturePaths.sdfTexturePath.filename().string());
+    if (entry == cache.entries.end() || entry->second != bakeHash) {
+        return false;
+    }
+    std::error_code error;
+    return std::filesystem::exists(texturePaths.sdfTexturePath, error)
+        && std::filesystem::exists(texturePaths.sdfIndirectionTexturePath, error);
+}
+
+void removeSDFBakeCacheEntry(SDFBakeCache* cache, const std::filesystem::path& sdfTexturePath) {
+    std::lock_guard<std::mutex> lock(cache->entryMutex);
+    cache->entries.erase(sdfTexturePath.filename().string());
+}
+
+void setSDFBakeCacheEntry(SDFBakeCache* cache, const std::filesystem::path& sdfTexturePath, const uint64_t bakeHash) {
+    std::lock_guard<std::mutex> lock(cache->entryMutex);
+    cache->entries[sdfTexturePath.filename().string()] = bakeHash;
+}
+
+void hashBytes(const void* data, const size_t size, uint64_t* inOutHash) {
+    const uint64_t prime = 1099511628211ull;
+    const uint8_t* bytes = (const uint8_t*)data;
+    uint64_t hash = *inOutHash;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= prime;
+    }
+    *inOutHash = hash;
+}
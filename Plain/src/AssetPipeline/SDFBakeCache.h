@@ -0,0 +1,31 @@
+#pragma once
+#include "pch.h"
+#include "Common/MeshData.h"
+#include "SceneSDF.h"
+#include <mutex>
+
+//increment when a change to the baking code changes the results, this invalidates all cached SDF textures
+const uint32_t sdfBakerVersion = 7;
+
+//remembers which inputs the SDF textures of a directory were baked from, so unchanged meshes are not baked again
+//stored as text file next to the textures, deleting it forces all textures to be baked again
+struct SDFBakeCache {
+    std::filesystem::path filePath;
+    std::unordered_map<std::string, uint64_t> entries;  //texture file name to bake hash
+    std::mutex entryMutex;                              //entries are updated by bake jobs
+};
+
+//missing or unreadable cache file results in an empty cache
+void loadSDFBakeCache(const std::filesystem::path& sdfTextureDirectory, SDFBakeCache* outCache);
+bool saveSDFBakeCache(SDFBakeCache& cache);
+
+//hash of everything the SDF texture depends on: positions, indices, resolution, bake method, atlas format and baker version
+uint64_t computeSDFBakeHash(const MeshData& mesh, const AxisAlignedBoundingBox& meshBB, const SDFBakeMethod bakeMethod,
+    const SDFAtlasFormat atlasFormat);
+
+//true if SDF textures exist and were baked from inputs with the same hash
+bool isSDFTextureCached(SDFBakeCache& cache, const TexturePaths& texturePaths, const uint64_t bakeHash);
+
+//removing the entry before baking ensures an interrupted bake is not mistaken for a valid one
+void removeSDFBakeCacheEntry(SDFBakeCache* cache, const std::filesystem::path& sdfTexturePath);
+void setSDFBakeCacheEntry(SDFBakeCache* cache, const std::filesystem::path& sdfTexturePath, const uint64_t bakeHash);
@@ -5,6 +5,10 @@
 #include "Utilities/MathUtils.h"
 #include "Common/sdfUtilities.h"
 #include "Common/JobSystem.h"
+#include "Common/CompressedTypes.h"
+#include "TrianglePacket.h"
+#include "TriangleBVH.h"
+#include <bit>
 
 // ---- private function declarations ----
 
@@ -14,141 +18,295 @@ bool isAxisSeparating(const glm::vec3& axis, const glm::vec3 bbHalfVector,
 bool doTriangleAABBOverlap(const glm::vec3& bbCenter, const glm::vec3& bbExtends,
     const glm::vec3& v0In, const glm::vec3& v1In, const glm::vec3& v2In, const glm::vec3& N);
 
-std::vector<uint8_t> computeSDF(const glm::uvec3& resolution, const AxisAlignedBoundingBox& aabb, const MeshData& mesh);
-
-int flattenGridIndex(const glm::ivec3& index3D, const glm::ivec3& resolution);
-glm::uvec3 pointToCellIndex(const glm::vec3& p, const AxisAlignedBoundingBox& aabb, const glm::ivec3 resolution);
-glm::vec3 volumeIndexToCellCenter(const glm::ivec3& index, const glm::ivec3& resolution, const VolumeInfo& volume);
+//uniform grid in compressed sparse row layout, the triangles overlapping cell i are
+//triangleIndices[cellOffsets[i]] up to triangleIndices[cellOffsets[i + 1]], in mesh order
+//triangles overlapping several cells are stored once, cells only reference them
+struct UniformGrid {
+    std::vector<uint32_t> cellOffsets;      //cell count + 1 entries
+    std::vector<uint32_t> triangleIndices;
+    TriangleArray triangles;
+};
 
-//the uniform grid contains triangle info directly instead of indices
-//this increases memory consumption but improves speed due to better cache coherence
-struct TriangleInfo {
-    glm::vec3 v0;
-    glm::vec3 v1;
-    glm::vec3 v2;
-    glm::vec3 N;
+//acceleration structures and settings shared by all bricks of a SDF computation
+struct SDFComputationInfo {
+    SDFBakeMethod bakeMethod;
+    SDFAtlasFormat atlasFormat;
+    std::vector<glm::vec3> rayDirections;   //same for every texel, empty if no rays are used
+    glm::uvec3 brickGridResolution;
+    glm::vec3 texelSize;                    //distance between neighbouring texels
+    AxisAlignedBoundingBox AABBPadded;
+    VolumeInfo sdfVolumeInfo;
+    glm::uvec3 uniformGridResolution;
+    glm::vec3 uniformGridCellSize;
+    UniformGrid uniformGrid;
+    TriangleBVH bvh;    //built for every method, used to find bricks within the narrow band and for rays missing the mesh
 };
 
-//uniform grid is used as acceleration structure for raytracing of SDF creation
-std::vector<std::vector<TriangleInfo>> buildUniformGrid(const MeshData& mesh, const VolumeInfo& sdfVolumeInfo,
-    const AxisAlignedBoundingBox& AABB, const glm::ivec3& uniformGridResolution);
+//BVH and the acceleration structure of the bake method are built
+SDFComputationInfo prepareSDFComputation(const glm::uvec3& brickGridResolution, const AxisAlignedBoundingBox& aabb,
+    const MeshData& mesh, const SDFBakeMethod bakeMethod, const SDFAtlasFormat atlasFormat);
 
-uint32_t nextPowerOfTwo(const uint32_t in);
-float computePointTrianglesClosestDistance(const glm::vec3 p, const std::vector<TriangleInfo>& triangles);
+//rays evenly distributed over the sphere, parametrized by angles theta and phi
+std::vector<glm::vec3> computeSDFRayDirections();
 
-// ---- implementation ----
 
-//see: http://graphics.stanford.edu/~seander/bithacks.html#RoundUpPowerOf2
-uint32_t nextPowerOfTwo(const uint32_t in) {
-    uint32_t out = in;
-    out--;
-    out |= out >> 1;
-    out |= out >> 2;
-    out |= out >> 4;
-    out |= out >> 8;
-    out |= out >> 16;
-    out++;
-    return out;
-}
+//walks the uniform grid until a cell containing a hit is found
+RayHit castRayUniformGrid(const SDFComputationInfo& info, const glm::vec3& rayOrigin, const glm::vec3& rayDirection);
 
-//reference: https://www.iquilezles.org/www/articles/triangledistance/triangledistance.htm
-float computePointTrianglesClosestDistance(const glm::vec3 p, const std::vector<TriangleInfo>& triangles) {
+//bricks with a distance bound below this many texels are stored
+//has to cover the trace hit threshold and the offsets used for normal computation
+const float sdfNarrowBandTexels = 2.f;
 
-    float closestD = std::numeric_limits<float>::infinity();
-    for (const TriangleInfo& t : triangles) {
+//signed distance at p, computed using the bake method
+//scratchRayHits must be sized for the ray directions, passed in to avoid allocating it per texel
+float computeSDFValue(const SDFComputationInfo& info, const glm::vec3& p, std::vector<RayHit>* scratchRayHits);
 
-        const glm::vec3 v1ToP = p - t.v0;
-        const glm::vec3 v2ToP = p - t.v1;
-        const glm::vec3 v3ToP = p - t.v2;
+//texels are placed on the bounding box border, not at cell centers, so neighbouring bricks can share them
+glm::vec3 sdfTexelPosition(const SDFComputationInfo& info, const glm::uvec3& texelIndex);
 
-        const glm::vec3 v0ToV1 = t.v1 - t.v0;
-        const glm::vec3 v1ToV2 = t.v2 - t.v1;
-        const glm::vec3 v2ToV0 = t.v0 - t.v2;
+//lower bound of the distance anywhere within the brick, negative if brick center is inside
+//uses exact distance and winding number independent of the bake method, a missed brick would cut a hole into the surface
+float computeSDFBrickDistanceBound(const SDFComputationInfo& info, const glm::uvec3& brickIndex);
 
-        const glm::vec3 eN0 = glm::cross(v0ToV1, t.N);
-        const glm::vec3 eN1 = glm::cross(v1ToV2, t.N);
-        const glm::vec3 eN2 = glm::cross(v2ToV0, t.N);
+const uint32_t sdfBrickTexelCount = sdfBrickSize * sdfBrickSize * sdfBrickSize;
 
-        const float s1 = glm::sign(glm::dot(eN0, -v1ToP));
-        const float s2 = glm::sign(glm::dot(eN1, -v2ToP));
-        const float s3 = glm::sign(glm::dot(eN2, -v3ToP));
+//texels of a brick, x first, then y, then z
+//also used for bricks of lower mips, which only use the first texels
+using SDFBrickTexels = std::array<float, sdfBrickTexelCount>;
 
-        const bool onEdge =
-            s1 +
-            s2 +
-            s3 < 2.f;
+//each texel is the minimum of the 2x2x2 texels of the finer brick it covers
+void downsampleSDFBrickMin(const SDFBrickTexels& fineTexels, const uint32_t fineBrickSize, SDFBrickTexels* outCoarseTexels);
 
-        const float c1 = glm::clamp(glm::dot(v1ToP, v0ToV1) / dot2(v0ToV1), 0.f, 1.f);
-        const float c2 = glm::clamp(glm::dot(v2ToP, v1ToV2) / dot2(v1ToV2), 0.f, 1.f);
-        const float c3 = glm::clamp(glm::dot(v3ToP, v2ToV0) / dot2(v2ToV0), 0.f, 1.f);
+//the minimum alone doesn't make filtered mip samples a lower bound, interpolating between coarse texel centers
+//can still exceed the distance at a full resolution texel, e.g. fine texels 10, 10, 0, 0 give 2.5 at the third one
+//a filtered sample only uses coarse texels whose covered full resolution texels are within (mipScale + 1) / 2 texels per axis
+//the distance is 1-Lipschitz, so subtracting that distance from every coarse texel makes samples a lower bound
+float computeSDFMipLipschitzMargin(const glm::vec3& texelSize, const uint32_t mipLevel);
 
-        float l1 = dot2(p - (t.v0 + v0ToV1 * c1));
-        float l2 = dot2(p - (t.v1 + v1ToV2 * c2));
-        float l3 = dot2(p - (t.v2 + v2ToV0 * c3));
+//offset of a mip in the atlas data, mips are stored one after another
+size_t sdfAtlasMipByteOffset(const glm::uvec3& atlasResolution, const ImageFormat format, const uint32_t mipLevel);
 
-        float d = onEdge ? glm::min(glm::min(l1, l2), l3) : abs(glm::dot(t.N, v1ToP) * glm::dot(t.N, v1ToP));
-        d = abs(d);
+//decode scale of a brick and difference between baked and decoded distances, errors are in distance units
+struct SDFBrickEncoding {
+    float decodeScale = 1.f;
+    float maxError = 0.f;
+    double squaredErrorSum = 0.0;
+};
 
-        closestD = glm::min(closestD, d);
-    }
-    return sqrt(abs(closestD));
-}
+//computes all texels of the brick and its mips, encodes them in the atlas format and writes them to their place in the atlas
+//outAtlasData must be sized for the whole atlas including mips, bricks can be computed in parallel
+//errors are measured on the full resolution texels
+SDFBrickEncoding computeSDFBrick(const SDFComputationInfo& info, const glm::uvec3& brickIndex, const glm::uvec3& atlasBrickIndex,
+    const glm::uvec3& atlasResolution, std::vector<uint8_t>* outAtlasData);
 
-SceneSDFTextures computeSceneSDFTextures(const std::vector<MeshData>& meshes, const std::vector<AxisAlignedBoundingBox>& AABBList) {
+ImageFormat sdfAtlasImageFormat(const SDFAtlasFormat atlasFormat);
 
-    SceneSDFTextures result;
-    result.descriptions.resize(meshes.size());
-    result.data.resize(meshes.size());
+//full resolution texels are rounded to nearest, to minimize the error
+//mip texels are rounded down, as their margin only makes them a lower bound if quantization doesn't increase them
+enum class SDFRounding { Nearest, Down };
 
-    JobSystem::Counter workFinised;
-    const std::chrono::system_clock::time_point startTime = std::chrono::system_clock::now();
+//writes the distances to the atlas and returns what sampling the atlas would result in, so the error can be measured
+//8 bit formats divide the distances by the decode scale, so they map to [-1:1]
+//brickSize is the texel count per axis, atlas resolution and outAtlasData refer to the mip the brick is written to
+//BC4 requires brickSize to be a multiple of the block size
+//when rounding down, decoded values don't exceed the distances, except for 8 bit formats below -decodeScale, which are clamped
+void encodeSDFBrick(const SDFBrickTexels& distances, const uint32_t brickSize, const SDFAtlasFormat atlasFormat,
+    const float decodeScale, const SDFRounding rounding, const glm::uvec3& firstAtlasTexel, const glm::uvec3& atlasResolution,
+    uint8_t* outAtlasData, SDFBrickTexels* outDecoded);
 
-    assert(meshes.size() == AABBList.size());
-    for (size_t i = 0; i < meshes.size(); i++) {
+//values must be in range [-1:1], block is written to outBlock, decoded values to outDecoded
+//endpoints are the block minimum and maximum, so the six interpolated values cover the block range
+//rounding down selects the largest palette value not above the value, the lower endpoint always is one
+//reference: https://docs.microsoft.com/en-us/windows/win32/direct3d10/d3d10-graphics-programming-guide-resources-block-compression#bc4
+void encodeBC4SNormBlock(const float values[16], const SDFRounding rounding, uint8_t outBlock[8], float outDecoded[16]);
 
-        //disable workerIndex unused parameter warning
-        #pragma warning( push )
-        #pragma warning( disable : 4100)
+//largest half float below the given one, infinities are returned unchanged
+uint16_t nextHalfDown(const uint16_t half);
+
+ImageDescription createSparseSDFImageDescription(const glm::uvec3& resolution, const ImageFormat format);
+
+int flattenGridIndex(const glm::ivec3& index3D, const glm::ivec3& resolution);
+glm::uvec3 pointToCellIndex(const glm::vec3& p, const AxisAlignedBoundingBox& aabb, const glm::ivec3 resolution);
+glm::vec3 volumeIndexToCellCenter(const glm::ivec3& index, const glm::ivec3& resolution, const VolumeInfo& volume);
+
+//uniform grid is used as acceleration structure for raytracing of SDF creation
+//built in two passes, the first counts the triangles per cell, the second writes the indices into the flat array
+//this avoids a heap allocation per cell and copying triangle data into every overlapping cell
+UniformGrid buildUniformGrid(const MeshData& mesh, const VolumeInfo& sdfVolumeInfo,
+    const AxisAlignedBoundingBox& AABB, const glm::ivec3& uniformGridResolution);
 
+size_t computeUniformGridByteSize(const UniformGrid& grid);
+
+//size the grid would have if every cell stored its own list of triangle packets, for comparison
+size_t computeUniformGridPacketListByteSize(const UniformGrid& grid);
+
+// ---- implementation ----
+
+glm::uvec3 computeSDFBrickGridResolution(const AxisAlignedBoundingBox& meshBB) {
+
+    //memory scales with surface instead of volume, which allows a higher resolution than dense textures
+    const uint32_t maxSdfRes = 256;
+    const uint32_t minSdfRes = 16;
+    const float targetTexelSize = 0.125f;
+    const uint32_t texelIntervalsPerBrick = sdfBrickSize - 1;
+
+    glm::uvec3 brickGridResolution;
+    const glm::vec3 bbExtents = meshBB.max - meshBB.min;
+    for (int component = 0; component < 3; component++) {
+        const float targetRes = bbExtents[component] / targetTexelSize;
+        const uint32_t sdfRes = glm::clamp((uint32_t)targetRes, minSdfRes, maxSdfRes);
+        //rounding up, so effective resolution is at least sdfRes
+        brickGridResolution[component] = (sdfRes - 1 + texelIntervalsPerBrick - 1) / texelIntervalsPerBrick;
+    }
+    return brickGridResolution;
+}
+
+ImageDescription createSparseSDFImageDescription(const glm::uvec3& resolution, const ImageFormat format) {
+    ImageDescription description;
+    description.width = resolution.x;
+    description.height = resolution.y;
+    description.depth = resolution.z;
+    description.type = ImageType::Type3D;
+    description.format = format;
+    description.usageFlags = ImageUsageFlags::Storage | ImageUsageFlags::Sampled;
+    description.mipCount = MipCount::One;
+    description.autoCreateMips = false;
+    return description;
+}
+
+std::vector<size_t> computeSDFBakeOrder(const std::vector<MeshData>& meshes, const std::vector<AxisAlignedBoundingBox>& AABBList) {
+    assert(meshes.size() == AABBList.size());
+
+    std::vector<size_t> order;
+    std::vector<size_t> brickCounts(meshes.size(), 0);
+    for (size_t i = 0; i < meshes.size(); i++) {
         if (meshes[i].texturePaths.sdfTexturePath.empty()) {
             continue;
         }
-        JobSystem::addJob([&result, &meshes, &AABBList, i](int workerIndex) {
-            const MeshData& mesh = meshes[i];
-            const AxisAlignedBoundingBox meshBB = AABBList[i];
-
-            const uint32_t maxSdfRes = 64;
-            const uint32_t minSdfRes = 16;
-            const float targetTexelPerMeter = 0.25f;
+        const glm::uvec3 brickGridResolution = computeSDFBrickGridResolution(AABBList[i]);
+        brickCounts[i] = size_t(brickGridResolution.x) * brickGridResolution.y * brickGridResolution.z;
+        order.push_back(i);
+    }
+    std::stable_sort(order.begin(), order.end(), [&meshes, &brickCounts](const size_t a, const size_t b) {
+        if (brickCounts[a] != brickCounts[b]) {
+            return brickCounts[a] > brickCounts[b];
+        }
+        return meshes[a].indices.size() > meshes[b].indices.size();
+    });
+    return order;
+}
 
-            glm::uvec3 sdfRes;
-            const glm::vec3 bbExtents = meshBB.max - meshBB.min;
-            for (int component = 0; component < 3; component++) {
-                const float targetRes = bbExtents[component] / targetTexelPerMeter;
-            
-                sdfRes[component] = nextPowerOfTwo((uint32_t)targetRes);
-                sdfRes[component] = glm::clamp(sdfRes[component], minSdfRes, maxSdfRes);
+JobSystem::CoroutineJob computeMeshSDFTextureAsync(const MeshData& mesh, const AxisAlignedBoundingBox meshBB,
+    SparseSDFTextures* outSDF, const SDFBakeMethod bakeMethod, const SDFAtlasFormat atlasFormat) {
+
+    const glm::uvec3 brickGridResolution = computeSDFBrickGridResolution(meshBB);
+    const SDFComputationInfo info = prepareSDFComputation(brickGridResolution, meshBB, mesh, bakeMethod, atlasFormat);
+
+    //acceleration structures are read only from here on and shared by all jobs
+    //a brick bound is a single distance query, so one job handles a whole slice of bricks
+    std::vector<float> brickDistanceBounds(size_t(brickGridResolution.x) * brickGridResolution.y * brickGridResolution.z);
+    JobSystem::Counter boundsFinished;
+    for (uint32_t z = 0; z < brickGridResolution.z; z++) {
+        JobSystem::addJob([&info, &brickDistanceBounds, z](int) {
+            for (uint32_t y = 0; y < info.brickGridResolution.y; y++) {
+                for (uint32_t x = 0; x < info.brickGridResolution.x; x++) {
+                    const glm::uvec3 brickIndex = glm::uvec3(x, y, z);
+                    brickDistanceBounds[flattenGridIndex(glm::ivec3(brickIndex), glm::ivec3(info.brickGridResolution))] =
+                        computeSDFBrickDistanceBound(info, brickIndex);
+                }
             }
+        }, &boundsFinished, JobSystem::JobPriority::Low, "Compute SDF brick bounds");
+    }
+    co_await boundsFinished;
+
+    const float narrowBandWidth = sdfNarrowBandTexels * glm::max(glm::max(info.texelSize.x, info.texelSize.y), info.texelSize.z);
+    std::vector<glm::uvec3> storedBricks;
+    for (uint32_t z = 0; z < brickGridResolution.z; z++) {
+        for (uint32_t y = 0; y < brickGridResolution.y; y++) {
+            for (uint32_t x = 0; x < brickGridResolution.x; x++) {
+                const glm::uvec3 brickIndex = glm::uvec3(x, y, z);
+                if (std::abs(brickDistanceBounds[flattenGridIndex(glm::ivec3(brickIndex), glm::ivec3(brickGridResolution))]) < narrowBandWidth) {
+                    storedBricks.push_back(brickIndex);
+                }
+            }
+        }
+    }
 
-            ImageDescription sdfTexture;
-            sdfTexture.width = sdfRes[0];
-            sdfTexture.height = sdfRes[1];
-            sdfTexture.depth = sdfRes[2];
-            sdfTexture.type = ImageType::Type3D;
-            sdfTexture.format = ImageFormat::R16_sFloat;
-            sdfTexture.usageFlags = ImageUsageFlags::Storage | ImageUsageFlags::Sampled;
-            sdfTexture.mipCount = MipCount::One;
-            sdfTexture.autoCreateMips = false;
-
-            result.descriptions[i] = sdfTexture;
-            result.data[i] = computeSDF(glm::uvec3(sdfTexture.width, sdfTexture.height, sdfTexture.depth), meshBB, mesh);
-        }, &workFinised);
+    //atlas is about a cube, at least one brick so the texture is valid
+    const uint32_t atlasBrickCount = glm::max((uint32_t)storedBricks.size(), 1u);
+    const uint32_t atlasSide = (uint32_t)std::ceil(std::cbrt((double)atlasBrickCount));
+    const glm::uvec3 atlasBrickGridResolution = glm::uvec3(atlasSide, atlasSide,
+        (atlasBrickCount + atlasSide * atlasSide - 1) / (atlasSide * atlasSide));
+    const glm::uvec3 atlasResolution = atlasBrickGridResolution * sdfBrickSize;
+
+    //indirection, bricks that aren't stored are marked by negative atlas position
+    const size_t bytePerIndirectionTexel = 4 * sizeof(uint16_t);
+    outSDF->indirectionDescription = createSparseSDFImageDescription(brickGridResolution, ImageFormat::RGBA16_sFloat);
+    outSDF->indirectionData.resize(brickDistanceBounds.size() * bytePerIndirectionTexel);
+    for (size_t i = 0; i < brickDistanceBounds.size(); i++) {
+        const glm::u16vec4 texel = glm::packHalf(glm::vec4(-1.f, -1.f, -1.f, brickDistanceBounds[i]));
+        memcpy(outSDF->indirectionData.data() + i * bytePerIndirectionTexel, &texel, bytePerIndirectionTexel);
+    }
 
-        //reenable warning
-        #pragma warning( pop )
+    const ImageFormat atlasImageFormat = sdfAtlasImageFormat(atlasFormat);
+    const uint32_t atlasMipCount = computeSDFAtlasMipCount(atlasFormat);
+    outSDF->atlasDescription = createSparseSDFImageDescription(atlasResolution, atlasImageFormat);
+    outSDF->atlasDescription.mipCount = MipCount::Manual;
+    outSDF->atlasDescription.manualMipCount = atlasMipCount;
+    outSDF->atlasData.resize(sdfAtlasMipByteOffset(atlasResolution, atlasImageFormat, atlasMipCount));
+    outSDF->storedBrickCount = storedBricks.size();
+
+    //stored bricks are computed as independent jobs
+    //small enough that a big mesh is split into hundreds of jobs, big enough that job overhead doesn't matter
+    JobSystem::Counter bricksFinished;
+    std::vector<SDFBrickEncoding> brickEncodings(storedBricks.size());
+    std::vector<glm::uvec3> atlasBrickIndices(storedBricks.size());
+    for (uint32_t i = 0; i < (uint32_t)storedBricks.size(); i++) {
+        const glm::uvec3 brickIndex = storedBricks[i];
+        const glm::uvec3 atlasBrickIndex = glm::uvec3(i % atlasSide, (i / atlasSide) % atlasSide, i / (atlasSide * atlasSide));
+        atlasBrickIndices[i] = atlasBrickIndex;
+
+        std::vector<uint8_t>* atlasData = &outSDF->atlasData;
+        SDFBrickEncoding* encoding = &brickEncodings[i];
+        JobSystem::addJob([&info, brickIndex, atlasBrickIndex, atlasResolution, atlasData, encoding](int) {
+            *encoding = computeSDFBrick(info, brickIndex, atlasBrickIndex, atlasResolution, atlasData);
+        }, &bricksFinished, JobSystem::JobPriority::Low, "Compute SDF brick");
     }
+    //suspends instead of blocking, so the worker can compute bricks in the meantime
+    co_await bricksFinished;
+
+    //decode scale is only known once the brick is computed
+    float maxError = 0.f;
+    double squaredErrorSum = 0.0;
+    for (size_t i = 0; i < storedBricks.size(); i++) {
+        const glm::u16vec4 texel = glm::packHalf(glm::vec4(glm::vec3(atlasBrickIndices[i]), brickEncodings[i].decodeScale));
+        const size_t indirectionIndex = flattenGridIndex(glm::ivec3(storedBricks[i]), glm::ivec3(brickGridResolution));
+        memcpy(outSDF->indirectionData.data() + indirectionIndex * bytePerIndirectionTexel, &texel, bytePerIndirectionTexel);
+
+        maxError = glm::max(maxError, brickEncodings[i].maxError);
+        squaredErrorSum += brickEncodings[i].squaredErrorSum;
+    }
+    const float texelSizeMax = glm::max(glm::max(info.texelSize.x, info.texelSize.y), info.texelSize.z);
+    const size_t storedTexelCount = glm::max(storedBricks.size(), size_t(1)) * sdfBrickTexelCount;
+    outSDF->maxQuantizationError = maxError / texelSizeMax;
+    outSDF->rmsQuantizationError = float(std::sqrt(squaredErrorSum / storedTexelCount)) / texelSizeMax;
+}
+
+std::vector<SparseSDFTextures> computeSceneSDFTextures(const std::vector<MeshData>& meshes,
+    const std::vector<AxisAlignedBoundingBox>& AABBList, const SDFBakeMethod bakeMethod, const SDFAtlasFormat atlasFormat) {
 
-    JobSystem::waitOnCounter(workFinised);
+    std::vector<SparseSDFTextures> result(meshes.size());
+
+    const std::chrono::system_clock::time_point startTime = std::chrono::system_clock::now();
+
+    assert(meshes.size() == AABBList.size());
+    //one job per mesh, each one adding a job per brick
+    JobSystem::Counter meshesFinished;
+    for (const size_t i : computeSDFBakeOrder(meshes, AABBList)) {
+        JobSystem::addCoroutineJob(computeMeshSDFTextureAsync(meshes[i], AABBList[i], &result[i], bakeMethod, atlasFormat),
+            &meshesFinished, JobSystem::JobPriority::High, "Bake SDF texture");
+    }
+    JobSystem::waitOnCounter(meshesFinished);
 
     const std::chrono::duration<double> computationTime = std::chrono::system_clock::now() - startTime;
     std::cout << "SDF computation time: " << computationTime.count() << "s\n";
@@ -250,265 +408,565 @@ glm::vec3 volumeIndexToCellCenter(const glm::ivec3& index, const glm::ivec3& res
     return cellCenter;
 };
 
-std::vector<std::vector<TriangleInfo>> buildUniformGrid(const MeshData& mesh, const VolumeInfo& sdfVolumeInfo,
+UniformGrid buildUniformGrid(const MeshData& mesh, const VolumeInfo& sdfVolumeInfo,
     const AxisAlignedBoundingBox& AABB, const glm::ivec3& uniformGridResolution) {
 
     const glm::vec3 uniformGridCellSize = glm::vec3(sdfVolumeInfo.extends) / glm::vec3(uniformGridResolution);
-
     const uint32_t uniformGridCellCount = uniformGridResolution.x * uniformGridResolution.y * uniformGridResolution.z;
-    std::vector<std::vector<TriangleInfo>> uniformGrid(uniformGridCellCount); //for every cell contains list of triangles
 
+    UniformGrid grid;
+    const size_t triangleCount = mesh.indices.size() / 3;
+    for (int component = 0; component < 3; component++) {
+        grid.triangles.v0[component].reserve(triangleCount);
+        grid.triangles.v1[component].reserve(triangleCount);
+        grid.triangles.v2[component].reserve(triangleCount);
+        grid.triangles.N[component].reserve(triangleCount);
+    }
     for (size_t i = 0; i < mesh.indices.size(); i += 3) {
+        const glm::vec3 v0 = mesh.positions[mesh.indices[i]];
+        const glm::vec3 v1 = mesh.positions[mesh.indices[i + 1]];
+        const glm::vec3 v2 = mesh.positions[mesh.indices[i + 2]];
+        const glm::vec3 N = glm::normalize(cross(v0 - v2, v0 - v1));
+        addTriangleToArray(v0, v1, v2, N, &grid.triangles);
+    }
 
-        const size_t i0 = mesh.indices[i];
-        const size_t i1 = mesh.indices[i + 1];
-        const size_t i2 = mesh.indices[i + 2];
-
-        TriangleInfo triangle;
-        triangle.v0 = mesh.positions[i0];
-        triangle.v1 = mesh.positions[i1];
-        triangle.v2 = mesh.positions[i2];
-
-        triangle.N = glm::normalize(cross(triangle.v0 - triangle.v2, triangle.v0 - triangle.v1));
+    //calls onCellOverlap(cellIndex) for every cell within the triangle bounding box that the triangle overlaps
+    const auto forEachOverlappedCell = [&](const uint32_t triangle, const auto& onCellOverlap) {
+        const TriangleArray& t = grid.triangles;
+        const glm::vec3 v0 = glm::vec3(t.v0[0][triangle], t.v0[1][triangle], t.v0[2][triangle]);
+        const glm::vec3 v1 = glm::vec3(t.v1[0][triangle], t.v1[1][triangle], t.v1[2][triangle]);
+        const glm::vec3 v2 = glm::vec3(t.v2[0][triangle], t.v2[1][triangle], t.v2[2][triangle]);
+        const glm::vec3 N = glm::vec3(t.N[0][triangle], t.N[1][triangle], t.N[2][triangle]);
 
-        const glm::vec3 triangleMin = glm::min(glm::min(triangle.v0, triangle.v1), triangle.v2);
-        const glm::vec3 triangleMax = glm::max(glm::max(triangle.v0, triangle.v1), triangle.v2);
+        const glm::vec3 triangleMin = glm::min(glm::min(v0, v1), v2);
+        const glm::vec3 triangleMax = glm::max(glm::max(v0, v1), v2);
 
         const glm::ivec3 minIndex = pointToCellIndex(triangleMin, AABB, uniformGridResolution);
         const glm::ivec3 maxIndex = pointToCellIndex(triangleMax, AABB, uniformGridResolution);
 
-        //iterate over cells within triangles bounding box
         for (int x = minIndex.x; x <= maxIndex.x; x++) {
             for (int y = minIndex.y; y <= maxIndex.y; y++) {
                 for (int z = minIndex.z; z <= maxIndex.z; z++) {
                     const glm::vec3 cellCenter = volumeIndexToCellCenter(glm::ivec3(x, y, z), uniformGridResolution, sdfVolumeInfo);
-                    if (doTriangleAABBOverlap(cellCenter, uniformGridCellSize, triangle.v0, triangle.v1, triangle.v2, triangle.N)) {
-                        const size_t cellIndex = flattenGridIndex(glm::ivec3(x, y, z), uniformGridResolution);
-                        uniformGrid[cellIndex].push_back(triangle);
+                    if (doTriangleAABBOverlap(cellCenter, uniformGridCellSize, v0, v1, v2, N)) {
+                        onCellOverlap(flattenGridIndex(glm::ivec3(x, y, z), uniformGridResolution));
                     }
                 }
             }
         }
+    };
+
+    //first pass counts triangles per cell, counts are shifted by one so the prefix sum results in the offsets
+    grid.cellOffsets.resize(uniformGridCellCount + 1, 0);
+    for (uint32_t triangle = 0; triangle < grid.triangles.triangleCount; triangle++) {
+        forEachOverlappedCell(triangle, [&grid](const int cellIndex) {
+            grid.cellOffsets[cellIndex + 1]++;
+        });
+    }
+    for (uint32_t cell = 0; cell < uniformGridCellCount; cell++) {
+        grid.cellOffsets[cell + 1] += grid.cellOffsets[cell];
+    }
+
+    //second pass writes indices, triangles are visited in order, so every cell lists them in mesh order
+    grid.triangleIndices.resize(grid.cellOffsets.back());
+    std::vector<uint32_t> cellWritePositions(grid.cellOffsets.begin(), grid.cellOffsets.end() - 1);
+    for (uint32_t triangle = 0; triangle < grid.triangles.triangleCount; triangle++) {
+        forEachOverlappedCell(triangle, [&grid, &cellWritePositions, triangle](const int cellIndex) {
+            grid.triangleIndices[cellWritePositions[cellIndex]++] = triangle;
+        });
+    }
+    return grid;
+}
+
+size_t computeUniformGridByteSize(const UniformGrid& grid) {
+    const size_t triangleArrayFloatCount = 12 * (size_t)grid.triangles.triangleCount;
+    return grid.cellOffsets.size() * sizeof(uint32_t)
+        + grid.triangleIndices.size() * sizeof(uint32_t)
+        + triangleArrayFloatCount * sizeof(float);
+}
+
+size_t computeUniformGridPacketListByteSize(const UniformGrid& grid) {
+    const size_t cellCount = grid.cellOffsets.size() - 1;
+    size_t byteSize = cellCount * sizeof(TrianglePacketList);
+    for (size_t cell = 0; cell < cellCount; cell++) {
+        const size_t cellTriangleCount = grid.cellOffsets[cell + 1] - grid.cellOffsets[cell];
+        byteSize += (cellTriangleCount + trianglePacketWidth - 1) / trianglePacketWidth * sizeof(TrianglePacket);
+    }
+    return byteSize;
+}
+
+std::vector<glm::vec3> computeSDFRayDirections() {
+    const int sampleCount1D = 15;
+    std::vector<glm::vec3> directions;
+    directions.reserve(sampleCount1D * sampleCount1D);
+    for (int sampleIndexX = 0; sampleIndexX < sampleCount1D; sampleIndexX++) {
+        for (int sampleIndexY = 0; sampleIndexY < sampleCount1D; sampleIndexY++) {
+
+            float sampleX = sampleIndexX / float(sampleCount1D - 1);            //in range [0:1]
+            float sampleY = sampleIndexY / float(sampleCount1D - 1) * 2 - 1;    //in range [-1:1]
+
+            const float phi = sampleX * 2.f * 3.1415f;
+            const float theta = acosf(sampleY);
+
+            const glm::vec2 angles = glm::vec2(phi, theta) / 3.1415f * 180.f;
+            directions.push_back(directionToVector(angles));
+        }
     }
-    return uniformGrid;
+    return directions;
 }
 
-std::vector<uint8_t> computeSDF(const glm::uvec3& resolution, const AxisAlignedBoundingBox& aabb, const MeshData& mesh) {
+SDFComputationInfo prepareSDFComputation(const glm::uvec3& brickGridResolution, const AxisAlignedBoundingBox& aabb,
+    const MeshData& mesh, const SDFBakeMethod bakeMethod, const SDFAtlasFormat atlasFormat) {
 
-    const AxisAlignedBoundingBox AABBPadded = padSDFBoundingBox(aabb);
-    const VolumeInfo sdfVolumeInfo = volumeInfoFromBoundingBox(AABBPadded);
+    SDFComputationInfo info;
+    info.bakeMethod = bakeMethod;
+    info.atlasFormat = atlasFormat;
+    info.brickGridResolution = brickGridResolution;
+    info.AABBPadded = padSDFBoundingBox(aabb);
+    info.sdfVolumeInfo = volumeInfoFromBoundingBox(info.AABBPadded);
+    info.texelSize = (info.AABBPadded.max - info.AABBPadded.min) / glm::vec3(brickGridResolution * (sdfBrickSize - 1));
+    info.bvh = buildTriangleBVH(mesh.positions, mesh.indices);
 
-    //build uniform grid
-    const glm::uvec3 uniformGridResolution = glm::ivec3(16);
-    const std::vector<std::vector<TriangleInfo>> uniformGrid = buildUniformGrid(mesh, sdfVolumeInfo, AABBPadded, uniformGridResolution);
+    if (bakeMethod == SDFBakeMethod::ClosestPointWindingNumber) {
+        return info;
+    }
 
-    //if no rays hit, distance to closest triangle is computed
-    //for this a vector of all triangles is prepared
-    std::vector<TriangleInfo> totalMeshTriangles;
-    totalMeshTriangles.reserve(mesh.indices.size() / 3);
-    for (size_t i = 0; i < mesh.indices.size(); i += 3) {
-        TriangleInfo t;
-        const uint32_t i0 = mesh.indices[i];
-        const uint32_t i1 = mesh.indices[i+1];
-        const uint32_t i2 = mesh.indices[i+2];
-        t.v0 = mesh.positions[i0];
-        t.v1 = mesh.positions[i1];
-        t.v2 = mesh.positions[i2];
-        t.N = glm::normalize(glm::cross(t.v0 - t.v2, t.v0 - t.v1));
+    info.rayDirections = computeSDFRayDirections();
+    if (bakeMethod == SDFBakeMethod::UniformGridRays) {
+        info.uniformGridResolution = glm::ivec3(16);
+        const std::chrono::system_clock::time_point startTime = std::chrono::system_clock::now();
+        info.uniformGrid = buildUniformGrid(mesh, info.sdfVolumeInfo, info.AABBPadded, info.uniformGridResolution);
+        const std::chrono::duration<double, std::milli> buildTime = std::chrono::system_clock::now() - startTime;
+        info.uniformGridCellSize = glm::vec3(info.sdfVolumeInfo.extends) / glm::vec3(info.uniformGridResolution);
+
+        //compared to per cell packet lists, which copy every triangle into every overlapping cell
+        std::cout << "Built SDF uniform grid in " + std::to_string(buildTime.count()) + "ms, triangle references: "
+            + std::to_string(info.uniformGrid.triangleIndices.size()) + "/"
+            + std::to_string(info.uniformGrid.triangles.triangleCount)
+            + ", memory: " + std::to_string(computeUniformGridByteSize(info.uniformGrid) / 1024) + "KB"
+            + ", as packet lists: " + std::to_string(computeUniformGridPacketListByteSize(info.uniformGrid) / 1024) + "KB\n";
+    }
+    return info;
+}
+
+RayHit castRayUniformGrid(const SDFComputationInfo& info, const glm::vec3& rayOrigin, const glm::vec3& rayDirection) {
+
+    const AxisAlignedBoundingBox& AABBPadded = info.AABBPadded;
+    const VolumeInfo& sdfVolumeInfo = info.sdfVolumeInfo;
+    const glm::uvec3& uniformGridResolution = info.uniformGridResolution;
+    const glm::vec3& uniformGridCellSize = info.uniformGridCellSize;
+    const UniformGrid& uniformGrid = info.uniformGrid;
+
+    bool isBackfaceHit = false;
+    float rayClosestHit = std::numeric_limits<float>::infinity();
+
+    bool rayIsInBoundingBox = true;
+
+    //start index
+    glm::uvec3 uniformGridIndex = pointToCellIndex(rayOrigin, AABBPadded, uniformGridResolution);
+
+    glm::vec3 currentRayPosition = rayOrigin;
+
+    //traverse uniform grid until hit or going out of bounding box
+    while (rayIsInBoundingBox) {
+        const size_t cellIndex = flattenGridIndex(uniformGridIndex, uniformGridResolution);
+
+        const glm::vec3 cellMin = AABBPadded.min + glm::vec3(uniformGridIndex) / glm::vec3(uniformGridResolution) * glm::vec3(sdfVolumeInfo.extends);
+        const glm::vec3 cellMax = cellMin + uniformGridCellSize;
+
+        bool hitTriangle = false;
+        //triangles of the cell are gathered into packets, so they can be intersected using SIMD
+        const uint32_t cellBegin = uniformGrid.cellOffsets[cellIndex];
+        const uint32_t cellEnd = uniformGrid.cellOffsets[cellIndex + 1];
+        for (uint32_t packetBegin = cellBegin; packetBegin < cellEnd; packetBegin += trianglePacketWidth) {
+            TrianglePacket packet;
+            gatherTrianglePacket(uniformGrid.triangles, &uniformGrid.triangleIndices[packetBegin],
+                glm::min(cellEnd - packetBegin, trianglePacketWidth), &packet);
 
-        totalMeshTriangles.push_back(t);
+            float hitDistances[trianglePacketWidth];
+            uint32_t backfaceMask = 0;
+            uint32_t hitMask = intersectTrianglePacket(packet, rayOrigin, rayDirection, cellMin, cellMax,
+                hitDistances, &backfaceMask);
+
+            hitTriangle |= hitMask != 0;
+
+            //lanes are visited in triangle order, so ties resolve like testing triangles one by one
+            while (hitMask != 0) {
+                const int lane = std::countr_zero(hitMask);
+                hitMask &= hitMask - 1;
+                //rayDirection is normalized so t is distance to hit
+                const float t = hitDistances[lane];
+                if (t < rayClosestHit) {
+                    rayClosestHit = t;
+                    isBackfaceHit = (backfaceMask >> lane) & 1;
+                }
+            }
+        }
+
+        //stop if ray hit something in current cell
+        if (hitTriangle) {
+            break;
+        }
+        else {
+            //find next cell intersection
+            float distanceToNextCellIntersection = std::numeric_limits<float>::infinity();
+
+            //check x,y,z
+            int intersectedComponent = 0;
+            for (int component = 0; component < 3; component++) {
+                if (rayDirection[component] == 0.f) {
+                    //parallel, ignore
+                    continue;
+                }
+                else  {
+                    float nextIntersection;
+                    if (rayDirection[component] > 0) {
+                        //moving in positive direction, intersecting with cell max
+                        nextIntersection = cellMax[component];
+                        //move to next cell if currently at intersection
+                        nextIntersection = nextIntersection == currentRayPosition[component]
+                            ? nextIntersection + uniformGridCellSize[component] : nextIntersection;
+                    }
+                    else {
+                        //moving in negative direction, intersecting with cell min
+                        nextIntersection = cellMin[component];
+                        //move to next cell if currently at intersection
+                        nextIntersection = nextIntersection == currentRayPosition[component]
+                            ? nextIntersection - uniformGridCellSize[component] : nextIntersection;
+                    }
+                    const float distanceToCellIntersection = (nextIntersection - currentRayPosition[component]) / rayDirection[component];
+                    //choose smallest distance
+                    if (distanceToCellIntersection < distanceToNextCellIntersection) {
+                        distanceToNextCellIntersection = distanceToCellIntersection;
+                        intersectedComponent = component;
+                    }
+                }
+            }
+            assert(distanceToNextCellIntersection != 0);
+            currentRayPosition += distanceToNextCellIntersection * rayDirection;
+
+            //advance index
+            uniformGridIndex[intersectedComponent] += rayDirection[intersectedComponent] > 0 ? 1 : -1;
+
+            rayIsInBoundingBox = 
+                uniformGridIndex[intersectedComponent] < uniformGridResolution[intersectedComponent] &&
+                uniformGridIndex[intersectedComponent] >= 0;
+        }
     }
 
-const glm::vec3 uniformGridCellSize = glm::vec3(sdfVolumeInfo.extends) / glm::vec3(uniformGridResolution);
+    RayHit hit;
+    hit.distance = rayClosestHit;
+    hit.isBackface = isBackfaceHit;
+    return hit;
+}
 
-    //calculate SDF
-   const uint32_t pixelCount = resolution.x * resolution.y * resolution.z;
-   const uint32_t bytePerPixel = 2; //distance stored as 16 bit float
-   const uint32_t byteCount = pixelCount * bytePerPixel;
-   std::vector<uint8_t> byteData(byteCount);
+float computeSDFValue(const SDFComputationInfo& info, const glm::vec3& p, std::vector<RayHit>* scratchRayHits) {
 
-    //for every texel
-    for (uint32_t z = 0; z < resolution.z; z++) {
-        for (uint32_t y = 0; y < resolution.y; y++) {
-            for (uint32_t x = 0; x < resolution.x; x++) {
+    if (info.bakeMethod == SDFBakeMethod::ClosestPointWindingNumber) {
+        //winding number is about one inside, threshold at one half is robust against holes and overlaps
+        const float distance = glm::sqrt(computeClosestTriangleDistanceSquared(info.bvh, p));
+        const bool isInside = computeWindingNumber(info.bvh, p) > 0.5f;
+        return isInside ? -distance : distance;
+    }
 
-                const uint32_t index = flattenGridIndex(glm::ivec3(x, y, z), glm::ivec3(resolution));
-                const uint32_t byteIndex = index * bytePerPixel;
+    //ray triangle intersection
+    //scratch a pixel has a sign error in computation of t
+    //reference: https://www.scratchapixel.com/lessons/3d-basic-rendering/ray-tracing-rendering-a-triangle/ray-triangle-intersection-geometric-solution
+    //reference: https://courses.cs.washington.edu/courses/csep557/10au/lectures/triangle_intersection.pdf
+    std::vector<RayHit>& rayHits = *scratchRayHits;
+    if (info.bakeMethod == SDFBakeMethod::BVHRays) {
+        std::fill(rayHits.begin(), rayHits.end(), RayHit());
+        traceRayStream(info.bvh, p, info.rayDirections, &rayHits);
+    }
+    else {
+        for (size_t ray = 0; ray < info.rayDirections.size(); ray++) {
+            rayHits[ray] = castRayUniformGrid(info, p, info.rayDirections[ray]);
+        }
+    }
 
-                //ray triangle intersection
-                //scratch a pixel has a sign error in computation of t
-                //reference: https://www.scratchapixel.com/lessons/3d-basic-rendering/ray-tracing-rendering-a-triangle/ray-triangle-intersection-geometric-solution
-                //reference: https://courses.cs.washington.edu/courses/csep557/10au/lectures/triangle_intersection.pdf
-                const glm::vec3 rayOrigin = volumeIndexToCellCenter(glm::ivec3(x, y, z), resolution, sdfVolumeInfo);
-                float closestHitTotal = std::numeric_limits<float>::infinity();
+    float closestHitTotal = std::numeric_limits<float>::infinity();
+    uint32_t backHitCounter = 0;
+    for (const RayHit& hit : rayHits) {
+        if (hit.isBackface) {
+            backHitCounter++;
+        }
+        closestHitTotal = glm::min(closestHitTotal, hit.distance);
+    }
+    //using sign heuristic from "Dynamic Occlusion with Signed Distance Fields", page 22
+    //assuming negative sign when more than half rays hit backface
+    const size_t hitsTotal = rayHits.size();
+    const float backHitPercentage = backHitCounter / (float)hitsTotal;
+    closestHitTotal *= backHitPercentage > 0.5f ? -1 : 1;
+
+    if (closestHitTotal == std::numeric_limits<float>::infinity()) {
+        //indicates no hits, in this case assume that point is outside of mesh and compute distance to closest triangle
+        closestHitTotal = glm::sqrt(computeClosestTriangleDistanceSquared(info.bvh, p));
+    }
+    return closestHitTotal;
+}
+
+glm::vec3 sdfTexelPosition(const SDFComputationInfo& info, const glm::uvec3& texelIndex) {
+    return info.AABBPadded.min + glm::vec3(texelIndex) * info.texelSize;
+}
+
+float computeSDFBrickDistanceBound(const SDFComputationInfo& info, const glm::uvec3& brickIndex) {
+    const glm::vec3 brickExtents = info.texelSize * float(sdfBrickSize - 1);
+    const glm::vec3 brickCenter = info.AABBPadded.min + (glm::vec3(brickIndex) + 0.5f) * brickExtents;
+    const float halfDiagonal = 0.5f * glm::length(brickExtents);
+
+    const float centerDistance = glm::sqrt(computeClosestTriangleDistanceSquared(info.bvh, brickCenter));
+    const float bound = glm::max(centerDistance - halfDiagonal, 0.f);
+    return computeWindingNumber(info.bvh, brickCenter) > 0.5f ? -bound : bound;
+}
+
+SDFBrickEncoding computeSDFBrick(const SDFComputationInfo& info, const glm::uvec3& brickIndex, const glm::uvec3& atlasBrickIndex,
+    const glm::uvec3& atlasResolution, std::vector<uint8_t>* outAtlasData) {
+
+    std::vector<RayHit> rayHits(info.rayDirections.size());
 
-                const int sampleCount1D = 15;
+    //first texel is shared with previous brick
+    const glm::uvec3 firstTexel = brickIndex * (sdfBrickSize - 1);
 
-                uint32_t backHitCounter = 0;
-                //for every ray, parametrized by angles theta and phi
-                for (int sampleIndexX = 0; sampleIndexX < sampleCount1D; sampleIndexX++) {
-                    for (int sampleIndexY = 0; sampleIndexY < sampleCount1D; sampleIndexY++) {
-
-                        float sampleX = sampleIndexX / float(sampleCount1D - 1);            //in range [0:1]
-                        float sampleY = sampleIndexY / float(sampleCount1D - 1) * 2 - 1;    //in range [-1:1]
-
-                        const float phi = sampleX * 2.f * 3.1415f;
-                        const float theta = acosf(sampleY);
-    
-                        bool isBackfaceHit = false;
-
-                        const glm::vec2 angles = glm::vec2(phi, theta) / 3.1415f * 180.f;
-                        const glm::vec3 rayDirection = directionToVector(angles);
-                        float rayClosestHit = std::numeric_limits<float>::infinity();
-
-                        bool rayIsInBoundingBox = true;
-
-                        //start index
-                        glm::uvec3 uniformGridIndex = pointToCellIndex(rayOrigin, AABBPadded, uniformGridResolution);
-
-                        glm::vec3 currentRayPosition = rayOrigin;
-
-                        //traverse uniform grid until hit or going out of bounding box
-                        while (rayIsInBoundingBox) {
-                            const size_t cellIndex = flattenGridIndex(uniformGridIndex, uniformGridResolution);
-
-                            const glm::vec3 cellMin = AABBPadded.min + glm::vec3(uniformGridIndex) / glm::vec3(uniformGridResolution) * glm::vec3(sdfVolumeInfo.extends);
-                            const glm::vec3 cellMax = cellMin + uniformGridCellSize;
-
-                            bool hitTriangle = false;
-                            //for every triangle in uniform grid cell
-                            for (const TriangleInfo& triangle : uniformGrid[cellIndex]) {
-
-                                const float NoR = glm::dot(triangle.N, rayDirection);
-
-                                if (abs(NoR) < 0.0001f) {
-                                    continue; //ray parallel to triangle
-                                }
-
-                                const float D = glm::dot(triangle.N, triangle.v0);
-
-                                const float t = (D - glm::dot(triangle.N, rayOrigin)) / NoR;
-
-                                if (t < 0.f) {
-                                    continue; //intersection in wrong direction
-                                }
-
-                                const glm::vec3 edge0 = triangle.v1 - triangle.v0;
-                                const glm::vec3 edge1 = triangle.v2 - triangle.v1;
-                                const glm::vec3 edge2 = triangle.v0 - triangle.v2;
-
-                                const glm::vec3 planeIntersection = rayOrigin + rayDirection * t;
-
-                                const glm::vec3 C0 = planeIntersection - triangle.v0;
-                                const glm::vec3 C1 = planeIntersection - triangle.v1;
-                                const glm::vec3 C2 = planeIntersection - triangle.v2;
-
-                                const float d0 = glm::dot(triangle.N, cross(C0, edge0));
-                                const float d1 = glm::dot(triangle.N, cross(C1, edge1));
-                                const float d2 = glm::dot(triangle.N, cross(C2, edge2));
-
-                                const bool isInsideTriangle =
-                                    d0 >= 0.f &&
-                                    d1 >= 0.f &&
-                                    d2 >= 0.f;
-
-                                if (!isInsideTriangle) {
-                                    continue;
-                                }
-
-                                //discard hits in other cells
-                                const glm::vec3 hitPos = rayOrigin + t * rayDirection;
-                                const bool hitInCurrentCell = isPointInAABB(hitPos, cellMin, cellMax);
-
-                                if (hitInCurrentCell) {
-                                    hitTriangle = true;
-                                }
-                                else {
-                                    continue;
-                                }
-
-                                //rayDirection is normalized so t is distance to hit
-                                if (t < rayClosestHit) {
-                                    rayClosestHit = t;
-                                    const float test = glm::dot(rayDirection, triangle.N);
-                                    isBackfaceHit = test > 0.f;
-                                }
-                            }
-
-                            //stop if ray hit something in current cell
-                            if (hitTriangle) {
-                                break;
-                            }
-                            else {
-                                //find next cell intersection
-                                float distanceToNextCellIntersection = std::numeric_limits<float>::infinity();
-
-                                //check x,y,z
-                                int intersectedComponent = 0;
-                                for (int component = 0; component < 3; component++) {
-                                    if (rayDirection[component] == 0.f) {
-                                        //parallel, ignore
-                                        continue;
-                                    }
-                                    else  {
-                                        float nextIntersection;
-                                        if (rayDirection[component] > 0) {
-                                            //moving in positive direction, intersecting with cell max
-                                            nextIntersection = cellMax[component];
-                                            //move to next cell if currently at intersection
-                                            nextIntersection = nextIntersection == currentRayPosition[component]
-                                                ? nextIntersection + uniformGridCellSize[component] : nextIntersection;
-                                        }
-                                        else {
-                                            //moving in negative direction, intersecting with cell min
-                                            nextIntersection = cellMin[component];
-                                            //move to next cell if currently at intersection
-                                            nextIntersection = nextIntersection == currentRayPosition[component]
-                                                ? nextIntersection - uniformGridCellSize[component] : nextIntersection;
-                                        }
-                                        const float distanceToCellIntersection = (nextIntersection - currentRayPosition[component]) / rayDirection[component];
-                                        //choose smallest distance
-                                        if (distanceToCellIntersection < distanceToNextCellIntersection) {
-                                            distanceToNextCellIntersection = distanceToCellIntersection;
-                                            intersectedComponent = component;
-                                        }
-                                    }
-                                }
-                                assert(distanceToNextCellIntersection != 0);
-                                currentRayPosition += distanceToNextCellIntersection * rayDirection;
-
-                                //advance index
-                                uniformGridIndex[intersectedComponent] += rayDirection[intersectedComponent] > 0 ? 1 : -1;
-
-                                rayIsInBoundingBox = 
-                                    uniformGridIndex[intersectedComponent] < uniformGridResolution[intersectedComponent] &&
-                                    uniformGridIndex[intersectedComponent] >= 0;
-                            }
-                        }
-
-                        if (isBackfaceHit) {
-                            backHitCounter++;
-                        }
-                        closestHitTotal = glm::min(closestHitTotal, rayClosestHit);
+    SDFBrickTexels distances;
+    SDFBrickEncoding encoding;
+    encoding.decodeScale = 0.f;
+    for (uint32_t z = 0; z < sdfBrickSize; z++) {
+        for (uint32_t y = 0; y < sdfBrickSize; y++) {
+            for (uint32_t x = 0; x < sdfBrickSize; x++) {
+                const glm::vec3 position = sdfTexelPosition(info, firstTexel + glm::uvec3(x, y, z));
+                const float distance = computeSDFValue(info, position, &rayHits);
+                distances[x + y * sdfBrickSize + z * sdfBrickSize * sdfBrickSize] = distance;
+                encoding.decodeScale = glm::max(encoding.decodeScale, std::abs(distance));
+            }
+        }
+    }
+    //float atlas is not scaled, the scale of a brick exactly on the surface must not be zero
+    //scale is stored as 16 bit float in the indirection, encoding uses the same value as decoding
+    if (info.atlasFormat == SDFAtlasFormat::Float16) {
+        encoding.decodeScale = 1.f;
+    }
+    const float minDecodeScale = 0.0001f;
+    encoding.decodeScale = glm::unpackHalf1x16(glm::packHalf1x16(glm::max(encoding.decodeScale, minDecodeScale)));
+
+    const ImageFormat atlasImageFormat = sdfAtlasImageFormat(info.atlasFormat);
+    SDFBrickTexels decoded;
+    encodeSDFBrick(distances, sdfBrickSize, info.atlasFormat, encoding.decodeScale, SDFRounding::Nearest,
+        atlasBrickIndex * sdfBrickSize, atlasResolution, outAtlasData->data(), &decoded);
+
+    for (uint32_t i = 0; i < sdfBrickTexelCount; i++) {
+        const float error = std::abs(decoded[i] - distances[i]);
+        encoding.maxError = glm::max(encoding.maxError, error);
+        encoding.squaredErrorSum += double(error) * error;
+    }
+
+    //mips are computed from the baked distances, not the decoded ones, so quantization errors don't accumulate
+    SDFBrickTexels mipDistances = distances;
+    const uint32_t mipCount = computeSDFAtlasMipCount(info.atlasFormat);
+    for (uint32_t mipLevel = 1; mipLevel < mipCount; mipLevel++) {
+        const uint32_t mipBrickSize = sdfBrickSize >> mipLevel;
+        SDFBrickTexels coarseDistances;
+        downsampleSDFBrickMin(mipDistances, mipBrickSize * 2, &coarseDistances);
+        mipDistances = coarseDistances;
+
+        //the margin is only applied to the encoded texels, the next mip is downsampled from the plain minimum
+        //texels are rounded down, 8 bit formats clamp to the decode scale though,
+        //so the bound is lost deep inside the mesh, where tracing doesn't start
+        const float margin = computeSDFMipLipschitzMargin(info.texelSize, mipLevel);
+        const uint32_t mipTexelCount = mipBrickSize * mipBrickSize * mipBrickSize;
+        SDFBrickTexels boundDistances;
+        for (uint32_t i = 0; i < mipTexelCount; i++) {
+            boundDistances[i] = mipDistances[i] - margin;
+        }
+
+        uint8_t* mipData = outAtlasData->data() + sdfAtlasMipByteOffset(atlasResolution, atlasImageFormat, mipLevel);
+        encodeSDFBrick(boundDistances, mipBrickSize, info.atlasFormat, encoding.decodeScale, SDFRounding::Down,
+            atlasBrickIndex * mipBrickSize, atlasResolution >> mipLevel, mipData, &decoded);
+
+        //decoding multiplies by the scale, which can round up by a few ulps
+        const bool isClamped = info.atlasFormat != SDFAtlasFormat::Float16;
+        const float roundingTolerance = encoding.decodeScale * 0.00001f;
+        for (uint32_t i = 0; i < mipTexelCount; i++) {
+            assert(decoded[i] <= boundDistances[i] + roundingTolerance
+                || (isClamped && boundDistances[i] < -encoding.decodeScale));
+        }
+    }
+    return encoding;
+}
+
+uint32_t computeSDFAtlasMipCount(const SDFAtlasFormat atlasFormat) {
+    return atlasFormat == SDFAtlasFormat::BC4 ? 2 : 3;
+}
+
+void downsampleSDFBrickMin(const SDFBrickTexels& fineTexels, const uint32_t fineBrickSize, SDFBrickTexels* outCoarseTexels) {
+    const uint32_t coarseBrickSize = fineBrickSize / 2;
+    for (uint32_t z = 0; z < coarseBrickSize; z++) {
+        for (uint32_t y = 0; y < coarseBrickSize; y++) {
+            for (uint32_t x = 0; x < coarseBrickSize; x++) {
+                float minDistance = std::numeric_limits<float>::infinity();
+                for (uint32_t i = 0; i < 8; i++) {
+                    const glm::uvec3 fine = glm::uvec3(x, y, z) * 2u + glm::uvec3(i & 1, (i >> 1) & 1, i >> 2);
+                    minDistance = glm::min(minDistance, fineTexels[fine.x + fine.y * fineBrickSize + fine.z * fineBrickSize * fineBrickSize]);
+                }
+                (*outCoarseTexels)[x + y * coarseBrickSize + z * coarseBrickSize * coarseBrickSize] = minDistance;
+            }
+        }
+    }
+}
+
+float computeSDFMipLipschitzMargin(const glm::vec3& texelSize, const uint32_t mipLevel) {
+    //a coarse texel covers mipScale full resolution texels per axis and is sampled up to mipScale texels away from its center
+    //the sample position is then at most (mipScale + 1) / 2 texels from the closest covered texel per axis
+    //position clamping at brick borders only moves samples towards the covered texels
+    const float mipScale = float(1u << mipLevel);
+    return glm::length(texelSize * (mipScale + 1.f) * 0.5f);
+}
+
+size_t sdfAtlasMipByteOffset(const glm::uvec3& atlasResolution, const ImageFormat format, const uint32_t mipLevel) {
+    size_t offset = 0;
+    for (uint32_t i = 0; i < mipLevel; i++) {
+        const glm::uvec3 mipResolution = atlasResolution >> i;
+        const size_t texelCount = size_t(mipResolution.x) * mipResolution.y * mipResolution.z;
+        offset += size_t(texelCount * getImageFormatBytePerPixel(format));
+    }
+    return offset;
+}
+
+ImageFormat sdfAtlasImageFormat(const SDFAtlasFormat atlasFormat) {
+    if (atlasFormat == SDFAtlasFormat::SNorm8) {
+        return ImageFormat::R8_sNorm;
+    }
+    else if (atlasFormat == SDFAtlasFormat::BC4) {
+        return ImageFormat::BC4_sNorm;
+    }
+    else {
+        return ImageFormat::R16_sFloat;
+    }
+}
+
+void encodeSDFBrick(const SDFBrickTexels& distances, const uint32_t brickSize, const SDFAtlasFormat atlasFormat,
+    const float decodeScale, const SDFRounding rounding, const glm::uvec3& firstAtlasTexel, const glm::uvec3& atlasResolution,
+    uint8_t* outAtlasData, SDFBrickTexels* outDecoded) {
+
+    if (atlasFormat == SDFAtlasFormat::BC4) {
+        //blocks are stored slice by slice, row by row, 8 bytes each
+        const uint32_t blockSize = 4;
+        const uint32_t bytePerBlock = 8;
+        assert(brickSize % blockSize == 0);
+        const size_t blocksPerRow = atlasResolution.x / blockSize;
+        const size_t blocksPerSlice = blocksPerRow * (atlasResolution.y / blockSize);
+        for (uint32_t z = 0; z < brickSize; z++) {
+            for (uint32_t blockY = 0; blockY < brickSize; blockY += blockSize) {
+                for (uint32_t blockX = 0; blockX < brickSize; blockX += blockSize) {
+                    float values[16];
+                    float decoded[16];
+                    for (uint32_t i = 0; i < 16; i++) {
+                        const uint32_t x = blockX + i % blockSize;
+                        const uint32_t y = blockY + i / blockSize;
+                        values[i] = distances[x + y * brickSize + z * brickSize * brickSize] / decodeScale;
                     }
+                    const glm::uvec3 atlasTexel = firstAtlasTexel + glm::uvec3(blockX, blockY, z);
+                    const size_t blockIndex = atlasTexel.z * blocksPerSlice + (atlasTexel.y / blockSize) * blocksPerRow
+                        + atlasTexel.x / blockSize;
+                    encodeBC4SNormBlock(values, rounding, outAtlasData + blockIndex * bytePerBlock, decoded);
+                    for (uint32_t i = 0; i < 16; i++) {
+                        const uint32_t x = blockX + i % blockSize;
+                        const uint32_t y = blockY + i / blockSize;
+                        (*outDecoded)[x + y * brickSize + z * brickSize * brickSize] = decoded[i] * decodeScale;
+                    }
+                }
+            }
+        }
+        return;
+    }
+
+    for (uint32_t z = 0; z < brickSize; z++) {
+        for (uint32_t y = 0; y < brickSize; y++) {
+            const uint32_t rowTexelIndex = y * brickSize + z * brickSize * brickSize;
+            const size_t rowAtlasIndex = flattenGridIndex(glm::ivec3(firstAtlasTexel + glm::uvec3(0, y, z)), glm::ivec3(atlasResolution));
+            if (atlasFormat == SDFAtlasFormat::SNorm8) {
+                for (uint32_t x = 0; x < brickSize; x++) {
+                    const float distance = distances[rowTexelIndex + x];
+                    const float scaled = glm::clamp(distance / decodeScale, -1.f, 1.f) * 127.f;
+                    const int8_t quantized = (int8_t)(rounding == SDFRounding::Down ? std::floor(scaled) : std::round(scaled));
+                    outAtlasData[rowAtlasIndex + x] = (uint8_t)quantized;
+                    (*outDecoded)[rowTexelIndex + x] = quantized / 127.f * decodeScale;
                 }
-                //using sign heuristic from "Dynamic Occlusion with Signed Distance Fields", page 22
-                //assuming negative sign when more than half rays hit backface
-                const size_t hitsTotal = sampleCount1D * sampleCount1D;
-                const float backHitPercentage = backHitCounter / (float)hitsTotal;
-                closestHitTotal *= backHitPercentage > 0.5f ? -1 : 1;
-
-                if (closestHitTotal == std::numeric_limits<float>::infinity()) {
-                    //indicates no hits, in this case assume that point is outside of mesh and compute distance to closest triangle
-                    closestHitTotal = computePointTrianglesClosestDistance(rayOrigin, totalMeshTriangles);
+            }
+            else {
+                //brick rows are contiguous in the atlas, so a row is converted at once
+                uint16_t* atlasRow = (uint16_t*)(outAtlasData + rowAtlasIndex * sizeof(uint16_t));
+                floatsToHalf(std::span(&distances[rowTexelIndex], brickSize), std::span(atlasRow, brickSize));
+                for (uint32_t x = 0; x < brickSize; x++) {
+                    //conversion rounds to nearest, so at most one step down is needed
+                    if (rounding == SDFRounding::Down && glm::unpackHalf1x16(atlasRow[x]) > distances[rowTexelIndex + x]) {
+                        atlasRow[x] = nextHalfDown(atlasRow[x]);
+                    }
+                    (*outDecoded)[rowTexelIndex + x] = glm::unpackHalf1x16(atlasRow[x]);
                 }
+            }
+        }
+    }
+}
+
+void encodeBC4SNormBlock(const float values[16], const SDFRounding rounding, uint8_t outBlock[8], float outDecoded[16]) {
+    float minValue = values[0];
+    float maxValue = values[0];
+    for (int i = 1; i < 16; i++) {
+        minValue = glm::min(minValue, values[i]);
+        maxValue = glm::max(maxValue, values[i]);
+    }
+    //rounded outwards, so the endpoints enclose all values, -128 is not used as it decodes like -127
+    const int red0 = glm::clamp((int)std::ceil(maxValue * 127.f), -127, 127);
+    const int red1 = glm::clamp((int)std::floor(minValue * 127.f), -127, 127);
+
+    //red0 > red1 selects six interpolated values, if they are equal all texels use red0
+    float palette[8];
+    palette[0] = red0 / 127.f;
+    palette[1] = red1 / 127.f;
+    for (int i = 2; i < 8; i++) {
+        palette[i] = ((8 - i) * red0 + (i - 1) * red1) / (7.f * 127.f);
+    }
 
-                uint16_t half = glm::packHalf(glm::vec1(closestHitTotal))[0];	//distance is stored as 16 bit float
-                byteData[byteIndex] = ((uint8_t*)&half)[0];
-                byteData[size_t(byteIndex) + 1] = ((uint8_t*)&half)[1];
+    uint64_t indexBits = 0;
+    for (int i = 0; i < 16; i++) {
+        int bestIndex = 0;
+        if (red0 > red1 && rounding == SDFRounding::Down) {
+            //red1 is the smallest value, it is only above the value if that is clamped below -1
+            bestIndex = 1;
+            for (int paletteIndex = 0; paletteIndex < 8; paletteIndex++) {
+                if (palette[paletteIndex] <= values[i] && palette[paletteIndex] > palette[bestIndex]) {
+                    bestIndex = paletteIndex;
+                }
+            }
+        }
+        else if (red0 > red1) {
+            for (int paletteIndex = 1; paletteIndex < 8; paletteIndex++) {
+                if (std::abs(palette[paletteIndex] - values[i]) < std::abs(palette[bestIndex] - values[i])) {
+                    bestIndex = paletteIndex;
+                }
             }
         }
+        indexBits |= uint64_t(bestIndex) << (3 * i);
+        outDecoded[i] = palette[bestIndex];
     }
 
-    return byteData;
+    outBlock[0] = (uint8_t)(int8_t)red0;
+    outBlock[1] = (uint8_t)(int8_t)red1;
+    for (int i = 0; i < 6; i++) {
+        outBlock[2 + i] = (uint8_t)(indexBits >> (8 * i));
+    }
+}
+
+uint16_t nextHalfDown(const uint16_t half) {
+    const uint16_t signBit = 0x8000;
+    const uint16_t positiveInfinity = 0x7c00;
+    const uint16_t negativeInfinity = 0xfc00;
+    if (half == positiveInfinity || half == negativeInfinity) {
+        return half;
+    }
+    //magnitude grows with the bit pattern, zero of either sign steps to the smallest negative denormal
+    if ((half & ~signBit) == 0) {
+        return uint16_t(signBit | 1);
+    }
+    return half & signBit ? uint16_t(half + 1) : uint16_t(half - 1);
 }
\ No newline at end of file
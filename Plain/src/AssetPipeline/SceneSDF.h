@@ -2,9 +2,65 @@
 #include "pch.h"
 #include "Common/MeshData.h"
 #include "ImageDescription.h"
+#include "Common/JobSystem.h"
 
-struct SceneSDFTextures {
-    std::vector<ImageDescription> descriptions;
-    std::vector<std::vector<uint8_t>> data;
+//ray based methods take the closest hit as distance and guess the sign from the ratio of backface hits
+//uniform grid has a fixed resolution, BVH adapts to the triangle distribution and traces all rays of a texel together
+//closest point method computes the exact distance and takes the sign from the generalized winding number
+//this is robust for thin geometry and meshes with small holes, where rays miss or the backface ratio is wrong
+//ray methods are kept to compare bake times and results
+enum class SDFBakeMethod { UniformGridRays, BVHRays, ClosestPointWindingNumber };
+
+//texels per brick along each axis, bricks are stored in the atlas and computed as independent jobs
+//neighbouring bricks share their border texels, so a brick covers sdfBrickSize - 1 texel intervals
+//this way trilinear filtering never needs texels of another brick
+const uint32_t sdfBrickSize = 8;
+
+//texel format of the atlas, 8 bit formats halve and BC4 quarters the atlas size compared to 16 bit float
+//8 bit formats store the distance divided by a decode scale per brick, which is the largest distance within the brick
+//BC4 compresses 4x4 texel blocks of every slice, brick borders are aligned to blocks
+enum class SDFAtlasFormat { Float16, SNorm8, BC4 };
+
+//atlas mips are computed per brick, a brick of mip n has sdfBrickSize >> n texels per axis
+//mip texels are the minimum of the texels they cover, minus the distance a filtered sample can be away from these texels
+//so filtered coarse samples are a lower bound of the baked distances, mip texels are rounded down when encoded to keep it
+//BC4 stops at 4x4 texel bricks, smaller bricks would share compression blocks
+uint32_t computeSDFAtlasMipCount(const SDFAtlasFormat atlasFormat);
+
+//sparse SDF only stores bricks within a narrow band around the surface
+//indirection has one RGBA16 float texel per brick, xyz is the brick position in the atlas in bricks
+//for bricks that aren't stored xyz is negative and w is a lower bound of the distance within the brick
+//for stored bricks w is the decode scale atlas values are multiplied with, one for float atlas
+//the atlas is a texture of all stored bricks, atlas data contains all mips, starting with the full resolution
+struct SparseSDFTextures {
+    ImageDescription indirectionDescription;
+    std::vector<uint8_t> indirectionData;
+    ImageDescription atlasDescription;
+    std::vector<uint8_t> atlasData;
+    size_t storedBrickCount = 0;
+
+    //difference between baked and decoded distance over all atlas texels, in texels of the SDF
+    float maxQuantizationError = 0.f;
+    float rmsQuantizationError = 0.f;
 };
-SceneSDFTextures computeSceneSDFTextures(const std::vector<MeshData>& meshes, const std::vector<AxisAlignedBoundingBox>& AABBList);
\ No newline at end of file
+
+//brick count per axis is chosen based on bounding box size
+//effective resolution per axis is brickCount * (sdfBrickSize - 1) + 1
+glm::uvec3 computeSDFBrickGridResolution(const AxisAlignedBoundingBox& meshBB);
+
+//indices of meshes with an SDF texture path, largest SDF texture first, ties ordered by triangle count
+//starting the largest bakes first keeps a big mesh from finishing last while the other workers are idle
+std::vector<size_t> computeSDFBakeOrder(const std::vector<MeshData>& meshes, const std::vector<AxisAlignedBoundingBox>& AABBList);
+
+//first finds bricks within the narrow band, then computes them with one job per brick
+//suspends instead of blocking while waiting for the jobs
+//mesh must stay alive and output must not be accessed until the coroutine finished
+JobSystem::CoroutineJob computeMeshSDFTextureAsync(const MeshData& mesh, const AxisAlignedBoundingBox meshBB,
+    SparseSDFTextures* outSDF, const SDFBakeMethod bakeMethod = SDFBakeMethod::ClosestPointWindingNumber,
+    const SDFAtlasFormat atlasFormat = SDFAtlasFormat::Float16);
+
+//computes SDF textures of all meshes with an SDF texture path in parallel, meshes without one get empty textures
+std::vector<SparseSDFTextures> computeSceneSDFTextures(const std::vector<MeshData>& meshes,
+    const std::vector<AxisAlignedBoundingBox>& AABBList,
+    const SDFBakeMethod bakeMethod = SDFBakeMethod::ClosestPointWindingNumber,
+    const SDFAtlasFormat atlasFormat = SDFAtlasFormat::Float16);
\ No newline at end of file
@@ -0,0 +1,508 @@
+#include "pch.h"
+#include "TriangleBVH.h"
+#include "Utilities/MathUtils.h"
+#include <bit>
+
+// ---- private types and function declarations ----
+
+struct BVHBuildTriangle {
+    glm::vec3 v0;
+    glm::vec3 v1;
+    glm::vec3 v2;
+    glm::vec3 N;
+    glm::vec3 bbMin;
+    glm::vec3 bbMax;
+    glm::vec3 centroid;
+};
+
+struct BVHBin {
+    glm::vec3 bbMin = glm::vec3(std::numeric_limits<float>::infinity());
+    glm::vec3 bbMax = glm::vec3(-std::numeric_limits<float>::infinity());
+    uint32_t triangleCount = 0;
+};
+
+const int bvhBinCount = 16;
+const uint32_t bvhMaxLeafTriangleCount = 64; //bigger leaves are always split, if possible
+const int bvhMaxDepth = 48;                  //bounds stack usage of traversal
+
+//dipole is used if point is further away from its center than this factor times its radius, 2 is suggested by Barill et al.
+const float windingNumberAccuracy = 2.f;
+
+//builds node and its children recursively, triangles in range [begin, end) are reordered
+void buildBVHNode(const uint32_t nodeIndex, const uint32_t begin, const uint32_t end, const int depth,
+    std::vector<BVHBuildTriangle>* triangles, TriangleBVH* bvh);
+
+void makeBVHLeaf(const uint32_t nodeIndex, const uint32_t begin, const uint32_t end,
+    const std::vector<BVHBuildTriangle>& triangles, TriangleBVH* bvh);
+
+//computes dipoles bottom up, children are always stored after their parent
+void computeBVHDipoles(TriangleBVH* bvh);
+
+//calls function(v0, v1, v2, N) for every triangle of the leaf
+template<typename Function>
+void forEachLeafTriangle(const TriangleBVH& bvh, const BVHNode& leaf, const Function& function);
+
+//reference: "Real-Time Collision Detection", Ericson, section 5.1.5
+float pointTriangleDistanceSquared(const glm::vec3& p, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c);
+
+//signed solid angle of triangle seen from p, positive if p is behind the triangle with respect to N
+//reference: "The Solid Angle of a Plane Triangle", Van Oosterom and Strackee
+float triangleSolidAngle(const glm::vec3& p, const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2);
+
+//half surface area, the factor doesn't matter for comparing costs
+float halfSurfaceArea(const glm::vec3& bbMin, const glm::vec3& bbMax);
+
+//cost in packet intersections, as triangles are intersected in packets
+float packetCount(const uint32_t triangleCount);
+
+//returns distance to box entry, negative if origin is inside, infinity if box is missed
+float intersectRayAABB(const glm::vec3& origin, const glm::vec3& inverseDirection, const glm::vec3& bbMin, const glm::vec3& bbMax);
+
+//squared distance from point to box, lower bound of the hit distance of every ray starting at the point
+float pointAABBDistanceSquared(const glm::vec3& p, const glm::vec3& bbMin, const glm::vec3& bbMax);
+
+void traverseBVHNode(const TriangleBVH& bvh, const uint32_t nodeIndex, const glm::vec3& origin,
+    const std::vector<glm::vec3>& directions, const glm::vec3* inverseDirections,
+    const uint16_t* activeRays, const size_t activeRayCount, std::vector<RayHit>* inOutHits);
+
+// ---- implementation ----
+
+TriangleBVH buildTriangleBVH(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices) {
+
+    std::vector<BVHBuildTriangle> triangles;
+    triangles.reserve(indices.size() / 3);
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        BVHBuildTriangle t;
+        t.v0 = positions[indices[i]];
+        t.v1 = positions[indices[i + 1]];
+        t.v2 = positions[indices[i + 2]];
+        t.N = glm::normalize(glm::cross(t.v0 - t.v2, t.v0 - t.v1));
+        t.bbMin = glm::min(glm::min(t.v0, t.v1), t.v2);
+        t.bbMax = glm::max(glm::max(t.v0, t.v1), t.v2);
+        t.centroid = (t.bbMin + t.bbMax) * 0.5f;
+        triangles.push_back(t);
+    }
+
+    TriangleBVH bvh;
+    bvh.nodes.reserve(2 * triangles.size() / trianglePacketWidth + 1);
+    bvh.nodes.push_back(BVHNode());
+    buildBVHNode(0, 0, (uint32_t)triangles.size(), 0, &triangles, &bvh);
+    computeBVHDipoles(&bvh);
+    return bvh;
+}
+
+void buildBVHNode(const uint32_t nodeIndex, const uint32_t begin, const uint32_t end, const int depth,
+    std::vector<BVHBuildTriangle>* triangles, TriangleBVH* bvh) {
+
+    std::vector<BVHBuildTriangle>& tris = *triangles;
+
+    glm::vec3 bbMin = glm::vec3(std::numeric_limits<float>::infinity());
+    glm::vec3 bbMax = glm::vec3(-std::numeric_limits<float>::infinity());
+    glm::vec3 centroidMin = bbMin;
+    glm::vec3 centroidMax = bbMax;
+    for (uint32_t i = begin; i < end; i++) {
+        bbMin = glm::min(bbMin, tris[i].bbMin);
+        bbMax = glm::max(bbMax, tris[i].bbMax);
+        centroidMin = glm::min(centroidMin, tris[i].centroid);
+        centroidMax = glm::max(centroidMax, tris[i].centroid);
+    }
+    bvh->nodes[nodeIndex].bbMin = bbMin;
+    bvh->nodes[nodeIndex].bbMax = bbMax;
+
+    const uint32_t triangleCount = end - begin;
+    if (triangleCount <= trianglePacketWidth || depth >= bvhMaxDepth) {
+        makeBVHLeaf(nodeIndex, begin, end, tris, bvh);
+        return;
+    }
+
+    //find cheapest split plane between bins over all axes
+    const float parentArea = halfSurfaceArea(bbMin, bbMax);
+    float bestCost = std::numeric_limits<float>::infinity();
+    int bestAxis = -1;
+    int bestSplit = 0;  //bins below are left
+
+    for (int axis = 0; axis < 3; axis++) {
+        const float extent = centroidMax[axis] - centroidMin[axis];
+        if (extent <= 0.f) {
+            continue;
+        }
+        const float binScale = bvhBinCount / extent;
+        std::array<BVHBin, bvhBinCount> bins;
+        for (uint32_t i = begin; i < end; i++) {
+            const int binIndex = std::min((int)((tris[i].centroid[axis] - centroidMin[axis]) * binScale), bvhBinCount - 1);
+            bins[binIndex].bbMin = glm::min(bins[binIndex].bbMin, tris[i].bbMin);
+            bins[binIndex].bbMax = glm::max(bins[binIndex].bbMax, tris[i].bbMax);
+            bins[binIndex].triangleCount++;
+        }
+
+        //sweep from the right to get cost of right sides, then from the left to evaluate all splits
+        std::array<float, bvhBinCount> rightCosts;
+        BVHBin right;
+        for (int split = bvhBinCount - 1; split > 0; split--) {
+            right.bbMin = glm::min(right.bbMin, bins[split].bbMin);
+            right.bbMax = glm::max(right.bbMax, bins[split].bbMax);
+            right.triangleCount += bins[split].triangleCount;
+            rightCosts[split] = right.triangleCount == 0 ? 0.f :
+                halfSurfaceArea(right.bbMin, right.bbMax) * packetCount(right.triangleCount);
+        }
+        BVHBin left;
+        for (int split = 1; split < bvhBinCount; split++) {
+            left.bbMin = glm::min(left.bbMin, bins[split - 1].bbMin);
+            left.bbMax = glm::max(left.bbMax, bins[split - 1].bbMax);
+            left.triangleCount += bins[split - 1].triangleCount;
+            if (left.triangleCount == 0 || left.triangleCount == triangleCount) {
+                continue;
+            }
+            const float cost = halfSurfaceArea(left.bbMin, left.bbMax) * packetCount(left.triangleCount) + rightCosts[split];
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestAxis = axis;
+                bestSplit = split;
+            }
+        }
+    }
+
+    //traversal step is assumed to cost as much as one packet intersection
+    const float leafCost = packetCount(triangleCount);
+    const float splitCost = 1.f + bestCost / parentArea;
+    const bool isSplitWorthIt = bestAxis >= 0 && (splitCost < leafCost || triangleCount > bvhMaxLeafTriangleCount);
+    if (!isSplitWorthIt) {
+        makeBVHLeaf(nodeIndex, begin, end, tris, bvh);
+        return;
+    }
+
+    const float binScale = bvhBinCount / (centroidMax[bestAxis] - centroidMin[bestAxis]);
+    const float centroidMinAxis = centroidMin[bestAxis];
+    const auto middleIterator = std::partition(tris.begin() + begin, tris.begin() + end,
+        [bestAxis, bestSplit, binScale, centroidMinAxis](const BVHBuildTriangle& t) {
+        const int binIndex = std::min((int)((t.centroid[bestAxis] - centroidMinAxis) * binScale), bvhBinCount - 1);
+        return binIndex < bestSplit;
+    });
+    const uint32_t middle = (uint32_t)(middleIterator - tris.begin());
+    assert(middle > begin && middle < end);
+
+    const uint32_t leftIndex = (uint32_t)bvh->nodes.size();
+    bvh->nodes.push_back(BVHNode());
+    bvh->nodes.push_back(BVHNode());
+    bvh->nodes[nodeIndex].firstIndex = leftIndex;
+    bvh->nodes[nodeIndex].triangleCount = 0;
+
+    buildBVHNode(leftIndex, begin, middle, depth + 1, triangles, bvh);
+    buildBVHNode(leftIndex + 1, middle, end, depth + 1, triangles, bvh);
+}
+
+void makeBVHLeaf(const uint32_t nodeIndex, const uint32_t begin, const uint32_t end,
+    const std::vector<BVHBuildTriangle>& triangles, TriangleBVH* bvh) {
+
+    TrianglePacketList leafPackets;
+    for (uint32_t i = begin; i < end; i++) {
+        addTriangleToPacketList(triangles[i].v0, triangles[i].v1, triangles[i].v2, triangles[i].N, &leafPackets);
+    }
+    BVHNode& node = bvh->nodes[nodeIndex];
+    node.firstIndex = (uint32_t)bvh->packets.size();
+    node.triangleCount = end - begin;
+    bvh->packets.insert(bvh->packets.end(), leafPackets.packets.begin(), leafPackets.packets.end());
+}
+
+float halfSurfaceArea(const glm::vec3& bbMin, const glm::vec3& bbMax) {
+    const glm::vec3 extent = bbMax - bbMin;
+    return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+}
+
+float packetCount(const uint32_t triangleCount) {
+    return (float)((triangleCount + trianglePacketWidth - 1) / trianglePacketWidth);
+}
+
+void traceRayStream(const TriangleBVH& bvh, const glm::vec3& origin, const std::vector<glm::vec3>& directions,
+    std::vector<RayHit>* inOutHits) {
+
+    assert(directions.size() <= maxRayStreamSize);
+    assert(inOutHits->size() == directions.size());
+    if (bvh.nodes.empty() || bvh.packets.empty()) {
+        return;
+    }
+
+    std::array<glm::vec3, maxRayStreamSize> inverseDirections;
+    for (size_t i = 0; i < directions.size(); i++) {
+        inverseDirections[i] = 1.f / directions[i];
+    }
+
+    //filter rays for the root, children are filtered by their parent
+    std::array<uint16_t, maxRayStreamSize> activeRays;
+    size_t activeRayCount = 0;
+    const BVHNode& root = bvh.nodes[0];
+    for (size_t i = 0; i < directions.size(); i++) {
+        const float entry = intersectRayAABB(origin, inverseDirections[i], root.bbMin, root.bbMax);
+        if (entry < (*inOutHits)[i].distance) {
+            activeRays[activeRayCount++] = (uint16_t)i;
+        }
+    }
+    if (activeRayCount > 0) {
+        traverseBVHNode(bvh, 0, origin, directions, inverseDirections.data(), activeRays.data(), activeRayCount, inOutHits);
+    }
+}
+
+void traverseBVHNode(const TriangleBVH& bvh, const uint32_t nodeIndex, const glm::vec3& origin,
+    const std::vector<glm::vec3>& directions, const glm::vec3* inverseDirections,
+    const uint16_t* activeRays, const size_t activeRayCount, std::vector<RayHit>* inOutHits) {
+
+    const BVHNode& node = bvh.nodes[nodeIndex];
+    std::vector<RayHit>& hits = *inOutHits;
+
+    if (node.triangleCount > 0) {
+        const uint32_t packetEnd = node.firstIndex + (uint32_t)packetCount(node.triangleCount);
+        //bounds are infinite, hits are only restricted to the triangles
+        const glm::vec3 boundsMin = glm::vec3(-std::numeric_limits<float>::infinity());
+        const glm::vec3 boundsMax = glm::vec3(std::numeric_limits<float>::infinity());
+        for (size_t i = 0; i < activeRayCount; i++) {
+            const uint16_t ray = activeRays[i];
+            for (uint32_t packetIndex = node.firstIndex; packetIndex < packetEnd; packetIndex++) {
+                float hitDistances[trianglePacketWidth];
+                uint32_t backfaceMask = 0;
+                uint32_t hitMask = intersectTrianglePacket(bvh.packets[packetIndex], origin, directions[ray],
+                    boundsMin, boundsMax, hitDistances, &backfaceMask);
+                while (hitMask != 0) {
+                    const int lane = std::countr_zero(hitMask);
+                    hitMask &= hitMask - 1;
+                    if (hitDistances[lane] < hits[ray].distance) {
+                        hits[ray].distance = hitDistances[lane];
+                        hits[ray].isBackface = (backfaceMask >> lane) & 1;
+                    }
+                }
+            }
+        }
+        return;
+    }
+
+    //near child first, as its hits can cull the far child
+    uint32_t childIndices[2] = { node.firstIndex, node.firstIndex + 1 };
+    const float distance0 = pointAABBDistanceSquared(origin, bvh.nodes[childIndices[0]].bbMin, bvh.nodes[childIndices[0]].bbMax);
+    const float distance1 = pointAABBDistanceSquared(origin, bvh.nodes[childIndices[1]].bbMin, bvh.nodes[childIndices[1]].bbMax);
+    if (distance1 < distance0) {
+        std::swap(childIndices[0], childIndices[1]);
+    }
+
+    for (const uint32_t childIndex : childIndices) {
+        const BVHNode& child = bvh.nodes[childIndex];
+        std::array<uint16_t, maxRayStreamSize> childRays;
+        size_t childRayCount = 0;
+        for (size_t i = 0; i < activeRayCount; i++) {
+            const uint16_t ray = activeRays[i];
+            const float entry = intersectRayAABB(origin, inverseDirections[ray], child.bbMin, child.bbMax);
+            if (entry < hits[ray].distance) {
+                childRays[childRayCount++] = ray;
+            }
+        }
+        if (childRayCount > 0) {
+            traverseBVHNode(bvh, childIndex, origin, directions, inverseDirections, childRays.data(), childRayCount, inOutHits);
+        }
+    }
+}
+
+void computeBVHDipoles(TriangleBVH* bvh) {
+    bvh->dipoles.resize(bvh->nodes.size());
+    std::vector<float> nodeAreas(bvh->nodes.size(), 0.f);
+    for (size_t i = bvh->nodes.size(); i-- > 0;) {
+        const BVHNode& node = bvh->nodes[i];
+        BVHDipole& dipole = bvh->dipoles[i];
+
+        float area = 0.f;
+        glm::vec3 weightedCenterSum = glm::vec3(0.f);
+        dipole.areaNormal = glm::vec3(0.f);
+        if (node.triangleCount > 0) {
+            forEachLeafTriangle(*bvh, node, [&](const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2, const glm::vec3& N) {
+                const float triangleArea = 0.5f * glm::length(glm::cross(v1 - v0, v2 - v0));
+                if (!(triangleArea > 0.f)) {
+                    return; //degenerate triangles have an invalid normal and no influence
+                }
+                area += triangleArea;
+                weightedCenterSum += triangleArea * (v0 + v1 + v2) / 3.f;
+                dipole.areaNormal += triangleArea * N;
+            });
+        }
+        else {
+            //children were computed before, as they are stored after the parent
+            for (uint32_t child = node.firstIndex; child < node.firstIndex + 2; child++) {
+                area += nodeAreas[child];
+                weightedCenterSum += nodeAreas[child] * bvh->dipoles[child].center;
+                dipole.areaNormal += bvh->dipoles[child].areaNormal;
+            }
+        }
+        nodeAreas[i] = area;
+        dipole.center = area > 0.f ? weightedCenterSum / area : (node.bbMin + node.bbMax) * 0.5f;
+        const glm::vec3 furthestCorner = glm::max(glm::abs(node.bbMin - dipole.center), glm::abs(node.bbMax - dipole.center));
+        dipole.radius = glm::length(furthestCorner);
+    }
+}
+
+template<typename Function>
+void forEachLeafTriangle(const TriangleBVH& bvh, const BVHNode& leaf, const Function& function) {
+    for (uint32_t i = 0; i < leaf.triangleCount; i++) {
+        const TrianglePacket& packet = bvh.packets[leaf.firstIndex + i / trianglePacketWidth];
+        const uint32_t lane = i % trianglePacketWidth;
+        function(
+            glm::vec3(packet.v0[0][lane], packet.v0[1][lane], packet.v0[2][lane]),
+            glm::vec3(packet.v1[0][lane], packet.v1[1][lane], packet.v1[2][lane]),
+            glm::vec3(packet.v2[0][lane], packet.v2[1][lane], packet.v2[2][lane]),
+            glm::vec3(packet.N[0][lane], packet.N[1][lane], packet.N[2][lane]));
+    }
+}
+
+float computeClosestTriangleDistanceSquared(const TriangleBVH& bvh, const glm::vec3& p) {
+    float closest = std::numeric_limits<float>::infinity();
+    if (bvh.packets.empty()) {
+        return closest;
+    }
+    //nodes with box distance, depth first with near child on top
+    struct StackEntry {
+        uint32_t nodeIndex;
+        float distanceSquared;
+    };
+    std::array<StackEntry, bvhMaxDepth + 2> stack;
+    int stackSize = 0;
+    stack[stackSize++] = { 0, pointAABBDistanceSquared(p, bvh.nodes[0].bbMin, bvh.nodes[0].bbMax) };
+
+    while (stackSize > 0) {
+        const StackEntry entry = stack[--stackSize];
+        if (entry.distanceSquared >= closest) {
+            continue;
+        }
+        const BVHNode& node = bvh.nodes[entry.nodeIndex];
+        if (node.triangleCount > 0) {
+            forEachLeafTriangle(bvh, node, [&](const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2, const glm::vec3&) {
+                closest = glm::min(closest, pointTriangleDistanceSquared(p, v0, v1, v2));
+            });
+            continue;
+        }
+        StackEntry near = { node.firstIndex, 0.f };
+        StackEntry far = { node.firstIndex + 1, 0.f };
+        near.distanceSquared = pointAABBDistanceSquared(p, bvh.nodes[near.nodeIndex].bbMin, bvh.nodes[near.nodeIndex].bbMax);
+        far.distanceSquared = pointAABBDistanceSquared(p, bvh.nodes[far.nodeIndex].bbMin, bvh.nodes[far.nodeIndex].bbMax);
+        if (far.distanceSquared < near.distanceSquared) {
+            std::swap(near, far);
+        }
+        //the far child of every level is pushed at most once, so depth bounds the stack size
+        stack[stackSize++] = far;
+        stack[stackSize++] = near;
+    }
+    return closest;
+}
+
+float computeWindingNumber(const TriangleBVH& bvh, const glm::vec3& p) {
+    if (bvh.packets.empty()) {
+        return 0.f;
+    }
+    const float pi = 3.14159265f;
+    float solidAngle = 0.f;
+
+    std::array<uint32_t, bvhMaxDepth + 2> stack;
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize > 0) {
+        const uint32_t nodeIndex = stack[--stackSize];
+        const BVHNode& node = bvh.nodes[nodeIndex];
+        const BVHDipole& dipole = bvh.dipoles[nodeIndex];
+
+        const glm::vec3 toCenter = dipole.center - p;
+        const float distance = glm::length(toCenter);
+        if (distance > windingNumberAccuracy * dipole.radius) {
+            //first order far field: solid angle of all triangles is about dot(areaNormal, c - p) / |c - p|^3
+            solidAngle += glm::dot(dipole.areaNormal, toCenter) / (distance * distance * distance);
+        }
+        else if (node.triangleCount > 0) {
+            forEachLeafTriangle(bvh, node, [&](const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2, const glm::vec3&) {
+                solidAngle += triangleSolidAngle(p, v0, v1, v2);
+            });
+        }
+        else {
+            stack[stackSize++] = node.firstIndex;
+            stack[stackSize++] = node.firstIndex + 1;
+        }
+    }
+    return solidAngle / (4.f * pi);
+}
+
+float pointTriangleDistanceSquared(const glm::vec3& p, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c) {
+    const glm::vec3 ab = b - a;
+    const glm::vec3 ac = c - a;
+    const glm::vec3 ap = p - a;
+
+    //vertex region a
+    const float d1 = glm::dot(ab, ap);
+    const float d2 = glm::dot(ac, ap);
+    if (d1 <= 0.f && d2 <= 0.f) {
+        return dot2(p - a);
+    }
+    //vertex region b
+    const glm::vec3 bp = p - b;
+    const float d3 = glm::dot(ab, bp);
+    const float d4 = glm::dot(ac, bp);
+    if (d3 >= 0.f && d4 <= d3) {
+        return dot2(p - b);
+    }
+    //edge region ab
+    const float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.f && d1 >= 0.f && d3 <= 0.f) {
+        const float v = d1 / (d1 - d3);
+        return dot2(p - (a + v * ab));
+    }
+    //vertex region c
+    const glm::vec3 cp = p - c;
+    const float d5 = glm::dot(ab, cp);
+    const float d6 = glm::dot(ac, cp);
+    if (d6 >= 0.f && d5 <= d6) {
+        return dot2(p - c);
+    }
+    //edge region ac
+    const float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.f && d2 >= 0.f && d6 <= 0.f) {
+        const float w = d2 / (d2 - d6);
+        return dot2(p - (a + w * ac));
+    }
+    //edge region bc
+    const float va = d3 * d6 - d5 * d4;
+    if (va <= 0.f && (d4 - d3) >= 0.f && (d5 - d6) >= 0.f) {
+        const float w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+        return dot2(p - (b + w * (c - b)));
+    }
+    //face region
+    const float denominator = va + vb + vc;
+    if (!(denominator != 0.f)) {
+        //degenerate triangle that isn't handled by the regions above, closest vertex is close enough
+        return glm::min(glm::min(dot2(p - a), dot2(p - b)), dot2(p - c));
+    }
+    const float v = vb / denominator;
+    const float w = vc / denominator;
+    return dot2(p - (a + ab * v + ac * w));
+}
+
+float triangleSolidAngle(const glm::vec3& p, const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2) {
+    //N = normalize(cross(v0 - v2, v0 - v1)) is counter clockwise for the order v0, v2, v1
+    const glm::vec3 a = v0 - p;
+    const glm::vec3 b = v2 - p;
+    const glm::vec3 c = v1 - p;
+    const float la = glm::length(a);
+    const float lb = glm::length(b);
+    const float lc = glm::length(c);
+    const float numerator = glm::dot(a, glm::cross(b, c));
+    const float denominator = la * lb * lc + glm::dot(a, b) * lc + glm::dot(b, c) * la + glm::dot(c, a) * lb;
+    return 2.f * atan2f(numerator, denominator);
+}
+
+//reference: "An Efficient and Robust Ray-Box Intersection Algorithm", Williams et al.
+float intersectRayAABB(const glm::vec3& origin, const glm::vec3& inverseDirection, const glm::vec3& bbMin, const glm::vec3& bbMax) {
+    const glm::vec3 t0 = (bbMin - origin) * inverseDirection;
+    const glm::vec3 t1 = (bbMax - origin) * inverseDirection;
+    const glm::vec3 tNear = glm::min(t0, t1);
+    const glm::vec3 tFar = glm::max(t0, t1);
+    const float entry = glm::max(glm::max(tNear.x, tNear.y), tNear.z);
+    const float exit = glm::min(glm::min(tFar.x, tFar.y), tFar.z);
+    //hits behind the origin are ignored, so a box behind the origin is missed
+    const bool isHit = exit >= glm::max(entry, 0.f);
+    return isHit ? entry : std::numeric_limits<float>::infinity();
+}
+
+float pointAABBDistanceSquared(const glm::vec3& p, const glm::vec3& bbMin, const glm::vec3& bbMax) {
+    const glm::vec3 closest = glm::clamp(p, bbMin, bbMax);
+    return dot2(p - closest);
+}
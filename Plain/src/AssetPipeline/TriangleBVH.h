@@ -0,0 +1,53 @@
+#pragma once
+#include "pch.h"
+#include "TrianglePacket.h"
+
+//32 byte node, children of inner nodes are stored next to each other
+struct BVHNode {
+    glm::vec3 bbMin;
+    uint32_t firstIndex = 0;    //left child for inner nodes, first packet for leaves
+    glm::vec3 bbMax;
+    uint32_t triangleCount = 0; //zero for inner nodes, packets of a leaf are full except the last one
+};
+
+//far field approximation of the triangles below a node, used for winding numbers
+struct BVHDipole {
+    glm::vec3 center;       //area weighted triangle centroid
+    float radius = 0.f;     //distance from center to furthest bounding box corner
+    glm::vec3 areaNormal;   //sum of triangle normals weighted by area
+};
+
+//root is node zero, dipoles are indexed like nodes
+struct TriangleBVH {
+    std::vector<BVHNode> nodes;
+    std::vector<BVHDipole> dipoles;
+    std::vector<TrianglePacket> packets;
+};
+
+struct RayHit {
+    float distance = std::numeric_limits<float>::infinity();
+    bool isBackface = false;
+};
+
+//rays traced together must not exceed this count
+const size_t maxRayStreamSize = 256;
+
+//built using binned surface area heuristic, leaves contain triangle packets
+//reference: "On fast Construction of SAH-based Bounding Volume Hierarchies", Wald
+TriangleBVH buildTriangleBVH(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices);
+
+//finds closest hit of all rays, which share the origin, such as the rays of one SDF texel
+//the stream is traversed once, every node filters the rays intersecting it and passes them on to its children
+//rays are only updated if a closer hit is found
+void traceRayStream(const TriangleBVH& bvh, const glm::vec3& origin, const std::vector<glm::vec3>& directions,
+    std::vector<RayHit>* inOutHits);
+
+//exact squared distance to the closest triangle, infinity if there are no triangles
+//nodes are visited near first and skipped if their box is further away than the closest triangle found so far
+float computeClosestTriangleDistanceSquared(const TriangleBVH& bvh, const glm::vec3& p);
+
+//generalized winding number, close to one inside and zero outside of closed meshes, fractional for open meshes
+//triangles are oriented like the normals used for ray casting, which point outwards
+//nodes far away compared to their size are approximated by their dipole, near triangles use the exact solid angle
+//reference: "Fast Winding Numbers for Soups and Clouds", Barill et al.
+float computeWindingNumber(const TriangleBVH& bvh, const glm::vec3& p);
@@ -0,0 +1,327 @@
+#include "pch.h"
+#include "TrianglePacket.h"
+
+#if defined(__AVX2__)
+#define TRIANGLE_PACKET_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TRIANGLE_PACKET_SSE
+#include <emmintrin.h>
+#endif
+
+// ---- private function declarations ----
+
+void writePacketLane(const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2, const glm::vec3& N,
+    const uint32_t lane, TrianglePacket* packet);
+
+#if defined(TRIANGLE_PACKET_AVX2)
+
+//dot(a, b) = (a.x * b.x + a.y * b.y) + a.z * b.z
+__m256 dot(const __m256 ax, const __m256 ay, const __m256 az, const __m256 bx, const __m256 by, const __m256 bz);
+
+//dot(N, cross(c, edge))
+__m256 dotNCross(const float N[3][trianglePacketWidth], const __m256 cx, const __m256 cy, const __m256 cz,
+    const float edge[3][trianglePacketWidth]);
+
+#elif defined(TRIANGLE_PACKET_SSE)
+
+const uint32_t sseWidth = 4;
+
+//dot(a, b) = (a.x * b.x + a.y * b.y) + a.z * b.z
+__m128 dot(const __m128 ax, const __m128 ay, const __m128 az, const __m128 bx, const __m128 by, const __m128 bz);
+
+//dot(N, cross(c, edge)), offset selects the half of the packet
+__m128 dotNCross(const float N[3][trianglePacketWidth], const __m128 cx, const __m128 cy, const __m128 cz,
+    const float edge[3][trianglePacketWidth], const uint32_t offset);
+
+#endif
+
+// ---- implementation ----
+
+void addTriangleToPacketList(const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2, const glm::vec3& N,
+    TrianglePacketList* list) {
+
+    const uint32_t lane = list->triangleCount % trianglePacketWidth;
+    if (lane == 0) {
+        //zero initialized, so unused lanes have a zero normal
+        list->packets.push_back(TrianglePacket{});
+    }
+    writePacketLane(v0, v1, v2, N, lane, &list->packets.back());
+    list->triangleCount++;
+}
+
+void addTriangleToArray(const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2, const glm::vec3& N,
+    TriangleArray* triangles) {
+    for (int component = 0; component < 3; component++) {
+        triangles->v0[component].push_back(v0[component]);
+        triangles->v1[component].push_back(v1[component]);
+        triangles->v2[component].push_back(v2[component]);
+        triangles->N[component].push_back(N[component]);
+    }
+    triangles->triangleCount++;
+}
+
+void writePacketLane(const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2, const glm::vec3& N,
+    const uint32_t lane, TrianglePacket* packet) {
+
+    const glm::vec3 edge0 = v1 - v0;
+    const glm::vec3 edge1 = v2 - v1;
+    const glm::vec3 edge2 = v0 - v2;
+
+    for (int component = 0; component < 3; component++) {
+        packet->v0[component][lane] = v0[component];
+        packet->v1[component][lane] = v1[component];
+        packet->v2[component][lane] = v2[component];
+        packet->edge0[component][lane] = edge0[component];
+        packet->edge1[component][lane] = edge1[component];
+        packet->edge2[component][lane] = edge2[component];
+        packet->N[component][lane] = N[component];
+    }
+    packet->D[lane] = glm::dot(N, v0);
+}
+
+//operations mirror the order of glm::dot and glm::cross, so results are identical to the scalar version
+//no fused multiply add is used, as it changes rounding
+
+#if defined(TRIANGLE_PACKET_AVX2)
+
+__m256 dot(const __m256 ax, const __m256 ay, const __m256 az, const __m256 bx, const __m256 by, const __m256 bz) {
+    return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ax, bx), _mm256_mul_ps(ay, by)), _mm256_mul_ps(az, bz));
+}
+
+__m256 dotNCross(const float N[3][trianglePacketWidth], const __m256 cx, const __m256 cy, const __m256 cz,
+    const float edge[3][trianglePacketWidth]) {
+    const __m256 ex = _mm256_load_ps(edge[0]);
+    const __m256 ey = _mm256_load_ps(edge[1]);
+    const __m256 ez = _mm256_load_ps(edge[2]);
+    const __m256 crossX = _mm256_sub_ps(_mm256_mul_ps(cy, ez), _mm256_mul_ps(ey, cz));
+    const __m256 crossY = _mm256_sub_ps(_mm256_mul_ps(cz, ex), _mm256_mul_ps(ez, cx));
+    const __m256 crossZ = _mm256_sub_ps(_mm256_mul_ps(cx, ey), _mm256_mul_ps(ex, cy));
+    return dot(_mm256_load_ps(N[0]), _mm256_load_ps(N[1]), _mm256_load_ps(N[2]), crossX, crossY, crossZ);
+}
+
+uint32_t intersectTrianglePacket(const TrianglePacket& packet, const glm::vec3& rayOrigin, const glm::vec3& rayDirection,
+    const glm::vec3& cellMin, const glm::vec3& cellMax, float outHitDistances[trianglePacketWidth], uint32_t* outBackfaceMask) {
+
+    const __m256 ox = _mm256_set1_ps(rayOrigin.x);
+    const __m256 oy = _mm256_set1_ps(rayOrigin.y);
+    const __m256 oz = _mm256_set1_ps(rayOrigin.z);
+    const __m256 dx = _mm256_set1_ps(rayDirection.x);
+    const __m256 dy = _mm256_set1_ps(rayDirection.y);
+    const __m256 dz = _mm256_set1_ps(rayDirection.z);
+
+    const __m256 Nx = _mm256_load_ps(packet.N[0]);
+    const __m256 Ny = _mm256_load_ps(packet.N[1]);
+    const __m256 Nz = _mm256_load_ps(packet.N[2]);
+
+    const __m256 NoR = dot(Nx, Ny, Nz, dx, dy, dz);
+    //not less, instead of greater equal, so NaN isn't rejected, like the scalar test
+    const __m256 absNoR = _mm256_andnot_ps(_mm256_set1_ps(-0.f), NoR);
+    __m256 isHit = _mm256_cmp_ps(absNoR, _mm256_set1_ps(0.0001f), _CMP_NLT_UQ);
+
+    const __m256 t = _mm256_div_ps(_mm256_sub_ps(_mm256_load_ps(packet.D), dot(Nx, Ny, Nz, ox, oy, oz)), NoR);
+    isHit = _mm256_and_ps(isHit, _mm256_cmp_ps(t, _mm256_setzero_ps(), _CMP_NLT_UQ));
+
+    const __m256 px = _mm256_add_ps(ox, _mm256_mul_ps(dx, t));
+    const __m256 py = _mm256_add_ps(oy, _mm256_mul_ps(dy, t));
+    const __m256 pz = _mm256_add_ps(oz, _mm256_mul_ps(dz, t));
+
+    const __m256 d0 = dotNCross(packet.N,
+        _mm256_sub_ps(px, _mm256_load_ps(packet.v0[0])),
+        _mm256_sub_ps(py, _mm256_load_ps(packet.v0[1])),
+        _mm256_sub_ps(pz, _mm256_load_ps(packet.v0[2])), packet.edge0);
+    const __m256 d1 = dotNCross(packet.N,
+        _mm256_sub_ps(px, _mm256_load_ps(packet.v1[0])),
+        _mm256_sub_ps(py, _mm256_load_ps(packet.v1[1])),
+        _mm256_sub_ps(pz, _mm256_load_ps(packet.v1[2])), packet.edge1);
+    const __m256 d2 = dotNCross(packet.N,
+        _mm256_sub_ps(px, _mm256_load_ps(packet.v2[0])),
+        _mm256_sub_ps(py, _mm256_load_ps(packet.v2[1])),
+        _mm256_sub_ps(pz, _mm256_load_ps(packet.v2[2])), packet.edge2);
+    const __m256 zero = _mm256_setzero_ps();
+    isHit = _mm256_and_ps(isHit, _mm256_cmp_ps(d0, zero, _CMP_GE_OQ));
+    isHit = _mm256_and_ps(isHit, _mm256_cmp_ps(d1, zero, _CMP_GE_OQ));
+    isHit = _mm256_and_ps(isHit, _mm256_cmp_ps(d2, zero, _CMP_GE_OQ));
+
+    //discard hits in other cells
+    isHit = _mm256_and_ps(isHit, _mm256_cmp_ps(px, _mm256_set1_ps(cellMax.x), _CMP_LE_OQ));
+    isHit = _mm256_and_ps(isHit, _mm256_cmp_ps(px, _mm256_set1_ps(cellMin.x), _CMP_GE_OQ));
+    isHit = _mm256_and_ps(isHit, _mm256_cmp_ps(py, _mm256_set1_ps(cellMax.y), _CMP_LE_OQ));
+    isHit = _mm256_and_ps(isHit, _mm256_cmp_ps(py, _mm256_set1_ps(cellMin.y), _CMP_GE_OQ));
+    isHit = _mm256_and_ps(isHit, _mm256_cmp_ps(pz, _mm256_set1_ps(cellMax.z), _CMP_LE_OQ));
+    isHit = _mm256_and_ps(isHit, _mm256_cmp_ps(pz, _mm256_set1_ps(cellMin.z), _CMP_GE_OQ));
+
+    _mm256_storeu_ps(outHitDistances, t);
+    *outBackfaceMask = (uint32_t)_mm256_movemask_ps(_mm256_cmp_ps(NoR, zero, _CMP_GT_OQ));
+    return (uint32_t)_mm256_movemask_ps(isHit);
+}
+
+void gatherTrianglePacket(const TriangleArray& triangles, const uint32_t* indices, const uint32_t count,
+    TrianglePacket* outPacket) {
+
+    assert(count <= trianglePacketWidth);
+    //masked lanes are neither loaded nor gathered, so indices past count don't have to exist
+    const __m256i laneMask = _mm256_cmpgt_epi32(_mm256_set1_epi32((int)count), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    const __m256i laneIndices = _mm256_maskload_epi32((const int*)indices, laneMask);
+    const __m256 gatherMask = _mm256_castsi256_ps(laneMask);
+    const __m256 zero = _mm256_setzero_ps();
+
+    __m256 v0[3], v1[3], v2[3], N[3];
+    for (int component = 0; component < 3; component++) {
+        v0[component] = _mm256_mask_i32gather_ps(zero, triangles.v0[component].data(), laneIndices, gatherMask, 4);
+        v1[component] = _mm256_mask_i32gather_ps(zero, triangles.v1[component].data(), laneIndices, gatherMask, 4);
+        v2[component] = _mm256_mask_i32gather_ps(zero, triangles.v2[component].data(), laneIndices, gatherMask, 4);
+        N[component] = _mm256_mask_i32gather_ps(zero, triangles.N[component].data(), laneIndices, gatherMask, 4);
+
+        _mm256_store_ps(outPacket->v0[component], v0[component]);
+        _mm256_store_ps(outPacket->v1[component], v1[component]);
+        _mm256_store_ps(outPacket->v2[component], v2[component]);
+        _mm256_store_ps(outPacket->N[component], N[component]);
+        _mm256_store_ps(outPacket->edge0[component], _mm256_sub_ps(v1[component], v0[component]));
+        _mm256_store_ps(outPacket->edge1[component], _mm256_sub_ps(v2[component], v1[component]));
+        _mm256_store_ps(outPacket->edge2[component], _mm256_sub_ps(v0[component], v2[component]));
+    }
+    _mm256_store_ps(outPacket->D, dot(N[0], N[1], N[2], v0[0], v0[1], v0[2]));
+}
+
+#elif defined(TRIANGLE_PACKET_SSE)
+
+__m128 dot(const __m128 ax, const __m128 ay, const __m128 az, const __m128 bx, const __m128 by, const __m128 bz) {
+    return _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_mul_ps(az, bz));
+}
+
+__m128 dotNCross(const float N[3][trianglePacketWidth], const __m128 cx, const __m128 cy, const __m128 cz,
+    const float edge[3][trianglePacketWidth], const uint32_t offset) {
+    const __m128 ex = _mm_load_ps(edge[0] + offset);
+    const __m128 ey = _mm_load_ps(edge[1] + offset);
+    const __m128 ez = _mm_load_ps(edge[2] + offset);
+    const __m128 crossX = _mm_sub_ps(_mm_mul_ps(cy, ez), _mm_mul_ps(ey, cz));
+    const __m128 crossY = _mm_sub_ps(_mm_mul_ps(cz, ex), _mm_mul_ps(ez, cx));
+    const __m128 crossZ = _mm_sub_ps(_mm_mul_ps(cx, ey), _mm_mul_ps(ex, cy));
+    return dot(_mm_load_ps(N[0] + offset), _mm_load_ps(N[1] + offset), _mm_load_ps(N[2] + offset),
+        crossX, crossY, crossZ);
+}
+
+uint32_t intersectTrianglePacket(const TrianglePacket& packet, const glm::vec3& rayOrigin, const glm::vec3& rayDirection,
+    const glm::vec3& cellMin, const glm::vec3& cellMax, float outHitDistances[trianglePacketWidth], uint32_t* outBackfaceMask) {
+
+    const __m128 ox = _mm_set1_ps(rayOrigin.x);
+    const __m128 oy = _mm_set1_ps(rayOrigin.y);
+    const __m128 oz = _mm_set1_ps(rayOrigin.z);
+    const __m128 dx = _mm_set1_ps(rayDirection.x);
+    const __m128 dy = _mm_set1_ps(rayDirection.y);
+    const __m128 dz = _mm_set1_ps(rayDirection.z);
+    const __m128 zero = _mm_setzero_ps();
+
+    uint32_t hitMask = 0;
+    uint32_t backfaceMask = 0;
+    for (uint32_t offset = 0; offset < trianglePacketWidth; offset += sseWidth) {
+        const __m128 Nx = _mm_load_ps(packet.N[0] + offset);
+        const __m128 Ny = _mm_load_ps(packet.N[1] + offset);
+        const __m128 Nz = _mm_load_ps(packet.N[2] + offset);
+
+        const __m128 NoR = dot(Nx, Ny, Nz, dx, dy, dz);
+        //not less, instead of greater equal, so NaN isn't rejected, like the scalar test
+        const __m128 absNoR = _mm_andnot_ps(_mm_set1_ps(-0.f), NoR);
+        __m128 isHit = _mm_cmpnlt_ps(absNoR, _mm_set1_ps(0.0001f));
+
+        const __m128 t = _mm_div_ps(_mm_sub_ps(_mm_load_ps(packet.D + offset), dot(Nx, Ny, Nz, ox, oy, oz)), NoR);
+        isHit = _mm_and_ps(isHit, _mm_cmpnlt_ps(t, zero));
+
+        const __m128 px = _mm_add_ps(ox, _mm_mul_ps(dx, t));
+        const __m128 py = _mm_add_ps(oy, _mm_mul_ps(dy, t));
+        const __m128 pz = _mm_add_ps(oz, _mm_mul_ps(dz, t));
+
+        const __m128 d0 = dotNCross(packet.N,
+            _mm_sub_ps(px, _mm_load_ps(packet.v0[0] + offset)),
+            _mm_sub_ps(py, _mm_load_ps(packet.v0[1] + offset)),
+            _mm_sub_ps(pz, _mm_load_ps(packet.v0[2] + offset)), packet.edge0, offset);
+        const __m128 d1 = dotNCross(packet.N,
+            _mm_sub_ps(px, _mm_load_ps(packet.v1[0] + offset)),
+            _mm_sub_ps(py, _mm_load_ps(packet.v1[1] + offset)),
+            _mm_sub_ps(pz, _mm_load_ps(packet.v1[2] + offset)), packet.edge1, offset);
+        const __m128 d2 = dotNCross(packet.N,
+            _mm_sub_ps(px, _mm_load_ps(packet.v2[0] + offset)),
+            _mm_sub_ps(py, _mm_load_ps(packet.v2[1] + offset)),
+            _mm_sub_ps(pz, _mm_load_ps(packet.v2[2] + offset)), packet.edge2, offset);
+        isHit = _mm_and_ps(isHit, _mm_cmpge_ps(d0, zero));
+        isHit = _mm_and_ps(isHit, _mm_cmpge_ps(d1, zero));
+        isHit = _mm_and_ps(isHit, _mm_cmpge_ps(d2, zero));
+
+        //discard hits in other cells
+        isHit = _mm_and_ps(isHit, _mm_cmple_ps(px, _mm_set1_ps(cellMax.x)));
+        isHit = _mm_and_ps(isHit, _mm_cmpge_ps(px, _mm_set1_ps(cellMin.x)));
+        isHit = _mm_and_ps(isHit, _mm_cmple_ps(py, _mm_set1_ps(cellMax.y)));
+        isHit = _mm_and_ps(isHit, _mm_cmpge_ps(py, _mm_set1_ps(cellMin.y)));
+        isHit = _mm_and_ps(isHit, _mm_cmple_ps(pz, _mm_set1_ps(cellMax.z)));
+        isHit = _mm_and_ps(isHit, _mm_cmpge_ps(pz, _mm_set1_ps(cellMin.z)));
+
+        _mm_storeu_ps(outHitDistances + offset, t);
+        backfaceMask |= (uint32_t)_mm_movemask_ps(_mm_cmpgt_ps(NoR, zero)) << offset;
+        hitMask |= (uint32_t)_mm_movemask_ps(isHit) << offset;
+    }
+    *outBackfaceMask = backfaceMask;
+    return hitMask;
+}
+
+#else
+
+//scalar fallback for platforms without SSE
+uint32_t intersectTrianglePacket(const TrianglePacket& packet, const glm::vec3& rayOrigin, const glm::vec3& rayDirection,
+    const glm::vec3& cellMin, const glm::vec3& cellMax, float outHitDistances[trianglePacketWidth], uint32_t* outBackfaceMask) {
+
+    uint32_t hitMask = 0;
+    uint32_t backfaceMask = 0;
+    for (uint32_t lane = 0; lane < trianglePacketWidth; lane++) {
+        const glm::vec3 N = glm::vec3(packet.N[0][lane], packet.N[1][lane], packet.N[2][lane]);
+        const float NoR = glm::dot(N, rayDirection);
+        backfaceMask |= (NoR > 0.f ? 1u : 0u) << lane;
+        if (std::abs(NoR) < 0.0001f) {
+            continue; //ray parallel to triangle
+        }
+        const float t = (packet.D[lane] - glm::dot(N, rayOrigin)) / NoR;
+        outHitDistances[lane] = t;
+        if (t < 0.f) {
+            continue; //intersection in wrong direction
+        }
+        const glm::vec3 p = rayOrigin + rayDirection * t;
+        const glm::vec3 C0 = p - glm::vec3(packet.v0[0][lane], packet.v0[1][lane], packet.v0[2][lane]);
+        const glm::vec3 C1 = p - glm::vec3(packet.v1[0][lane], packet.v1[1][lane], packet.v1[2][lane]);
+        const glm::vec3 C2 = p - glm::vec3(packet.v2[0][lane], packet.v2[1][lane], packet.v2[2][lane]);
+        const glm::vec3 edge0 = glm::vec3(packet.edge0[0][lane], packet.edge0[1][lane], packet.edge0[2][lane]);
+        const glm::vec3 edge1 = glm::vec3(packet.edge1[0][lane], packet.edge1[1][lane], packet.edge1[2][lane]);
+        const glm::vec3 edge2 = glm::vec3(packet.edge2[0][lane], packet.edge2[1][lane], packet.edge2[2][lane]);
+        const bool isInsideTriangle =
+            glm::dot(N, glm::cross(C0, edge0)) >= 0.f &&
+            glm::dot(N, glm::cross(C1, edge1)) >= 0.f &&
+            glm::dot(N, glm::cross(C2, edge2)) >= 0.f;
+        const bool isInCell =
+            p.x <= cellMax.x && p.x >= cellMin.x &&
+            p.y <= cellMax.y && p.y >= cellMin.y &&
+            p.z <= cellMax.z && p.z >= cellMin.z;
+        hitMask |= (isInsideTriangle && isInCell ? 1u : 0u) << lane;
+    }
+    *outBackfaceMask = backfaceMask;
+    return hitMask;
+}
+
+#endif
+
+#if !defined(TRIANGLE_PACKET_AVX2)
+
+void gatherTrianglePacket(const TriangleArray& triangles, const uint32_t* indices, const uint32_t count,
+    TrianglePacket* outPacket) {
+
+    assert(count <= trianglePacketWidth);
+    *outPacket = TrianglePacket{};
+    for (uint32_t lane = 0; lane < count; lane++) {
+        const uint32_t t = indices[lane];
+        writePacketLane(
+            glm::vec3(triangles.v0[0][t], triangles.v0[1][t], triangles.v0[2][t]),
+            glm::vec3(triangles.v1[0][t], triangles.v1[1][t], triangles.v1[2][t]),
+            glm::vec3(triangles.v2[0][t], triangles.v2[1][t], triangles.v2[2][t]),
+            glm::vec3(triangles.N[0][t], triangles.N[1][t], triangles.N[2][t]), lane, outPacket);
+    }
+}
+
+#endif
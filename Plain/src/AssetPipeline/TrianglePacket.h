@@ -0,0 +1,55 @@
+#pragma once
+#include "pch.h"
+
+//number of triangles intersected at once, one AVX register of floats
+const uint32_t trianglePacketWidth = 8;
+
+//triangles stored as structure of arrays, so a ray can be intersected with a whole packet using SIMD
+//edges and plane distance are precomputed, as they are needed for every ray
+//unused lanes have a zero normal, so they are treated as parallel to every ray and never hit
+struct alignas(32) TrianglePacket {
+    float v0[3][trianglePacketWidth];
+    float v1[3][trianglePacketWidth];
+    float v2[3][trianglePacketWidth];
+    float edge0[3][trianglePacketWidth];    //v1 - v0
+    float edge1[3][trianglePacketWidth];    //v2 - v1
+    float edge2[3][trianglePacketWidth];    //v0 - v2
+    float N[3][trianglePacketWidth];
+    float D[trianglePacketWidth];           //dot(N, v0)
+};
+
+struct TrianglePacketList {
+    std::vector<TrianglePacket> packets;
+    uint32_t triangleCount = 0;
+};
+
+//triangles stored as structure of arrays, indexed by triangle
+//used if triangles are referenced from several places, such as overlapping grid cells, so each one is only stored once
+//edges and plane distance are not stored, they are computed when gathering a packet
+struct TriangleArray {
+    std::vector<float> v0[3];
+    std::vector<float> v1[3];
+    std::vector<float> v2[3];
+    std::vector<float> N[3];
+    uint32_t triangleCount = 0;
+};
+
+//fills the next free lane, adds a packet if all are used
+void addTriangleToPacketList(const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2, const glm::vec3& N,
+    TrianglePacketList* list);
+
+void addTriangleToArray(const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2, const glm::vec3& N,
+    TriangleArray* triangles);
+
+//first count lanes are filled with the indexed triangles, count must not exceed the packet width
+//packet is identical to adding the triangles to a packet list in the same order, unused lanes have a zero normal
+//uses AVX2 gathers if compiled with it
+void gatherTrianglePacket(const TriangleArray& triangles, const uint32_t* indices, const uint32_t count,
+    TrianglePacket* outPacket);
+
+//lane i of the returned mask is set if ray hits triangle i within [cellMin, cellMax], with hit distance outHitDistances[i]
+//lane i of outBackfaceMask is set if triangle i faces away from the ray
+//results are bit identical to intersecting the triangles one by one with scalar math
+//uses AVX2 if compiled with it, SSE otherwise
+uint32_t intersectTrianglePacket(const TrianglePacket& packet, const glm::vec3& rayOrigin, const glm::vec3& rayDirection,
+    const glm::vec3& cellMin, const glm::vec3& cellMax, float outHitDistances[trianglePacketWidth], uint32_t* outBackfaceMask);
@@ -4,15 +4,31 @@
 #include "Common/MeshProcessing.h"
 #include "Utilities/DirectoryUtils.h"
 #include "SceneSDF.h"
+#include "SDFBakeCache.h"
+#include "MeshOptimisation.h"
+#include "MeshSimplification.h"
 #include "ImageIO.h"
 #include "sdfUtilities.h"
 #include "JobSystem.h"
+#include "TaskGraph.h"
 
 //expected command line arguments:
 //argv[0] = executablePath
 //argv[1] = .obj scene file path
+//argv[2] = job trace file path, optional, tracing is disabled if not set or empty
+//argv[3] = SDF bake method, optional, uses exact if not set
+//  "exact" = closest triangle distance with winding number sign
+//  "bvh"   = ray casting with BVH
+//  "grid"  = ray casting with uniform grid
+//argv[4] = SDF atlas format, optional, uses half if not set
+//  "half"  = 16 bit float
+//  "snorm" = 8 bit snorm, half the size of float
+//  "bc4"   = BC4 compressed, a quarter of the size of float
 struct CommandLineSettings {
     std::string modelFilePath;
+    std::string traceFilePath;
+    SDFBakeMethod sdfBakeMethod = SDFBakeMethod::ClosestPointWindingNumber;
+    SDFAtlasFormat sdfAtlasFormat = SDFAtlasFormat::Float16;
 };
 
 CommandLineSettings parseCommandLineArguments(const int argc, char* argv[]) {
@@ -23,15 +39,74 @@ CommandLineSettings parseCommandLineArguments(const int argc, char* argv[]) {
         std::cout << "Missing command line parameter, scene file path not set\n";
     }
     settings.modelFilePath = argv[1];
+    if (argc >= 3) {
+        settings.traceFilePath = argv[2];
+    }
+    if (argc >= 4) {
+        const std::string bakeMethod = argv[3];
+        if (bakeMethod == "grid") {
+            settings.sdfBakeMethod = SDFBakeMethod::UniformGridRays;
+        }
+        else if (bakeMethod == "bvh") {
+            settings.sdfBakeMethod = SDFBakeMethod::BVHRays;
+        }
+        else if (bakeMethod != "exact") {
+            std::cout << "Unknown SDF bake method '" << bakeMethod << "', using exact\n";
+        }
+    }
+    if (argc >= 5) {
+        const std::string atlasFormat = argv[4];
+        if (atlasFormat == "snorm") {
+            settings.sdfAtlasFormat = SDFAtlasFormat::SNorm8;
+        }
+        else if (atlasFormat == "bc4") {
+            settings.sdfAtlasFormat = SDFAtlasFormat::BC4;
+        }
+        else if (atlasFormat != "half") {
+            std::cout << "Unknown SDF atlas format '" << atlasFormat << "', using half\n";
+        }
+    }
     return settings;
 }
 
+//bakes SDF texture and writes it as soon as the bake is finished
+//waiting for the bake suspends the coroutine, so no worker is blocked
+//cache entry is set after writing, so it only refers to complete textures
+//quantization error is reported to judge if the atlas format is precise enough for the mesh
+JobSystem::CoroutineJob bakeAndWriteSDFTexture(const MeshData& mesh, const AxisAlignedBoundingBox meshBB,
+    const SDFBakeMethod bakeMethod, const SDFAtlasFormat atlasFormat, const uint64_t bakeHash, SDFBakeCache* bakeCache) {
+    SparseSDFTextures sdf;
+    JobSystem::Counter bakeFinished;
+    JobSystem::addCoroutineJob(computeMeshSDFTextureAsync(mesh, meshBB, &sdf, bakeMethod, atlasFormat), &bakeFinished,
+        JobSystem::JobPriority::Low, "Bake SDF texture");
+    co_await bakeFinished;
+
+    const std::filesystem::path sdfTexturePath = mesh.texturePaths.sdfTexturePath;
+    //create directory if it doesn't exist
+    const fs::path sdfTextureDirectory = sdfTexturePath.parent_path();
+    if (!fs::exists(sdfTextureDirectory)) {
+        std::error_code error; //directory may be created by another job at the same time
+        fs::create_directories(sdfTextureDirectory, error);
+    }
+    writeDDSFile(sdfTexturePath, sdf.atlasDescription, sdf.atlasData);
+    writeDDSFile(mesh.texturePaths.sdfIndirectionTexturePath, sdf.indirectionDescription, sdf.indirectionData);
+    setSDFBakeCacheEntry(bakeCache, sdfTexturePath, bakeHash);
+
+    const size_t totalBrickCount = sdf.indirectionData.size() / (4 * sizeof(uint16_t));
+    std::cout << "Saved SDF texture: " + sdfTexturePath.string() + ", bricks stored: "
+        + std::to_string(sdf.storedBrickCount) + "/" + std::to_string(totalBrickCount)
+        + ", atlas size: " + std::to_string(sdf.atlasData.size() / 1024) + "KB"
+        + ", quantization error max/rms in texels: " + std::to_string(sdf.maxQuantizationError)
+        + "/" + std::to_string(sdf.rmsQuantizationError) + "\n";
+}
+
 int main(const int argc, char* argv[]) {
 
     CommandLineSettings settings = parseCommandLineArguments(argc, argv);
 
     DirectoryUtils::init();
     JobSystem::initJobSystem();
+    JobSystem::setTracingEnabled(!settings.traceFilePath.empty());
 
     std::filesystem::path binaryPathRelative =  settings.modelFilePath;
     binaryPathRelative.replace_extension("plain");
@@ -39,33 +114,89 @@ int main(const int argc, char* argv[]) {
     Scene scene;
     std::cout << "Input model: " << settings.modelFilePath << "\n";
     if (loadModelGLTF(settings.modelFilePath, &scene)) {
-        std::vector<AxisAlignedBoundingBox> AABBList = AABBListFromMeshes(scene.meshes);
+        //done first, as packing and SDF baking depend on triangle and vertex order
+        const MeshOrderStatistics orderStatisticsBefore = computeMeshOrderStatistics(scene.meshes);
+        optimiseMeshOrder(&scene.meshes);
+        printMeshOrderStatistics(orderStatisticsBefore, computeMeshOrderStatistics(scene.meshes));
+
+        const std::vector<AxisAlignedBoundingBox> AABBList = AABBListFromMeshes(scene.meshes);
+
+        //generating levels of detail, packing and saving the binary scene is expressed as a task graph, it overlaps with SDF baking
+        //levels of detail are only written to MeshData::lods, SDF baking only reads the full detail mesh
+        JobSystem::TaskGraph taskGraph;
+
         SceneBinary sceneBinary;
         sceneBinary.objects = scene.objects;
-        sceneBinary.meshes = meshesToBinary(scene.meshes, AABBList);
-        std::cout << "Sucessfully converted model to binary format\n";
-        saveBinaryScene(binaryPathRelative, sceneBinary);
-        std::cout << "Saved binary file: " << binaryPathRelative << "\n";
+
+        const JobSystem::TaskHandle lodTask = taskGraph.addTask([&scene](int) {
+            generateMeshLods(&scene.meshes);
+            printMeshLodStatistics(scene.meshes);
+        }, JobSystem::JobPriority::Low, "Generate mesh levels of detail");
+
+        const JobSystem::TaskHandle packingTask = taskGraph.addTask([&sceneBinary, &scene, &AABBList](int) {
+            sceneBinary.meshes = meshesToBinary(scene.meshes, AABBList);
+            std::cout << "Sucessfully converted model to binary format\n";
+        }, JobSystem::JobPriority::Low, "Pack binary scene");
+
+        const JobSystem::TaskHandle savingTask = taskGraph.addTask([&sceneBinary, &binaryPathRelative](int) {
+            saveBinaryScene(binaryPathRelative, sceneBinary);
+            std::cout << "Saved binary file: " << binaryPathRelative << "\n";
+        }, JobSystem::JobPriority::Low, "Save binary scene");
+        taskGraph.addDependency(lodTask, packingTask);
+        taskGraph.addDependency(packingTask, savingTask);
 
         std::cout << "Computing signed distance fields...\n";
-        const SceneSDFTextures sceneSDFTextures = computeSceneSDFTextures(scene.meshes, AABBList);
+        const std::chrono::system_clock::time_point startTime = std::chrono::system_clock::now();
 
-        assert(sceneSDFTextures.descriptions.size() == scene.meshes.size());
-        assert(sceneSDFTextures.descriptions.size() == sceneSDFTextures.data.size());
+        taskGraph.run();
 
-        for (size_t i = 0; i < sceneSDFTextures.descriptions.size(); i++) {
-            const std::filesystem::path sdfTexturePath = scene.meshes[i].texturePaths.sdfTexturePath;
-            if (sdfTexturePath.empty()) {
+        //meshes whose inputs didn't change since the last bake are skipped
+        //all SDF textures of a model are in the same directory, so one cache is enough
+        const std::vector<size_t> bakeOrder = computeSDFBakeOrder(scene.meshes, AABBList);
+        SDFBakeCache bakeCache;
+        if (!bakeOrder.empty()) {
+            loadSDFBakeCache(scene.meshes[bakeOrder.front()].texturePaths.sdfTexturePath.parent_path(), &bakeCache);
+        }
+        std::vector<size_t> meshesToBake;
+        std::vector<uint64_t> bakeHashes;
+        for (const size_t i : bakeOrder) {
+            const MeshData& mesh = scene.meshes[i];
+            const uint64_t bakeHash = computeSDFBakeHash(mesh, AABBList[i], settings.sdfBakeMethod, settings.sdfAtlasFormat);
+            if (isSDFTextureCached(bakeCache, mesh.texturePaths, bakeHash)) {
                 continue;
             }
-            //create directory if it doesn't exist
-            const fs::path sdfTextureDirectory = sdfTexturePath.parent_path();
-            if (!fs::exists(sdfTextureDirectory)) {
-                fs::create_directories(sdfTextureDirectory);
+            removeSDFBakeCacheEntry(&bakeCache, mesh.texturePaths.sdfTexturePath);
+            meshesToBake.push_back(i);
+            bakeHashes.push_back(bakeHash);
+        }
+        std::cout << "Skipping " << bakeOrder.size() - meshesToBake.size() << " unchanged SDF textures, baking "
+            << meshesToBake.size() << "\n";
+
+        //writing is high priority, so finished textures are saved and freed before further bakes are started
+        JobSystem::Counter sdfTexturesFinished;
+        if (!meshesToBake.empty()) {
+            //saved before baking, so textures of an interrupted run are not considered valid
+            saveSDFBakeCache(bakeCache);
+            for (size_t i = 0; i < meshesToBake.size(); i++) {
+                const size_t meshIndex = meshesToBake[i];
+                JobSystem::addCoroutineJob(bakeAndWriteSDFTexture(scene.meshes[meshIndex], AABBList[meshIndex],
+                    settings.sdfBakeMethod, settings.sdfAtlasFormat, bakeHashes[i], &bakeCache),
+                    &sdfTexturesFinished, JobSystem::JobPriority::High, "Bake and write SDF texture");
             }
-            writeDDSFile(sdfTexturePath, sceneSDFTextures.descriptions[i], sceneSDFTextures.data[i]);
-            std::cout << "Saved SDF texture: "<< sdfTexturePath << "\n";
         }
+
+        taskGraph.wait();
+        JobSystem::waitOnCounter(sdfTexturesFinished);
+        if (!meshesToBake.empty()) {
+            saveSDFBakeCache(bakeCache);
+        }
+
+        const std::chrono::duration<double> processingTime = std::chrono::system_clock::now() - startTime;
+        std::cout << "Processing time: " << processingTime.count() << "s\n";
+    }
+    if (JobSystem::isTracingEnabled() && JobSystem::writeTraceFile(settings.traceFilePath)) {
+        std::cout << "Saved job trace: " << settings.traceFilePath << "\n";
     }
+    JobSystem::shutdownJobSystem();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,114 @@
+#include "pch.h"
+#include "BenchmarkUtilities.h"
+#include "Common/JobSystem.h"
+#include "Common/TypeConversion.h"
+
+// ---- private function declarations ----
+
+//adds quotes and escapes quotes and backslashes
+std::string toJsonString(const std::string& value);
+
+void writeJsonObject(std::ofstream& file, const JsonObject& object);
+
+// ---- implementation ----
+
+BenchmarkSettings parseBenchmarkArguments(const int argc, char* argv[], const int firstArgument) {
+    BenchmarkSettings settings;
+    settings.workerCount = parseIntArgument(argc, argv, firstArgument, "worker count", 0);
+    settings.resultFilePath = parseStringArgument(argc, argv, firstArgument + 1);
+    return settings;
+}
+
+int parseIntArgument(const int argc, char* argv[], const int index, const std::string& argumentName, const int defaultValue) {
+    if (index >= argc) {
+        return defaultValue;
+    }
+    int value = 0;
+    if (!charArrayToInt(argv[index], &value)) {
+        std::cout << "Failed to parse command line argument " << argumentName << ", using default value\n";
+        return defaultValue;
+    }
+    return value;
+}
+
+std::string parseStringArgument(const int argc, char* argv[], const int index) {
+    if (index >= argc) {
+        return "";
+    }
+    return argv[index];
+}
+
+void JsonObject::addString(const std::string& name, const std::string& value) {
+    fields.push_back({ name, toJsonString(value) });
+}
+
+void JsonObject::addNumber(const std::string& name, const double value) {
+    std::ostringstream stream;
+    stream << value;
+    fields.push_back({ name, stream.str() });
+}
+
+void JsonObject::addInteger(const std::string& name, const int64_t value) {
+    fields.push_back({ name, std::to_string(value) });
+}
+
+void JsonObject::addBool(const std::string& name, const bool value) {
+    fields.push_back({ name, value ? "true" : "false" });
+}
+
+void JsonObject::addUVec3(const std::string& name, const glm::uvec3& value) {
+    fields.push_back({ name, "[" + std::to_string(value.x) + ", " + std::to_string(value.y) + ", " + std::to_string(value.z) + "]" });
+}
+
+bool writeBenchmarkResultFile(const std::filesystem::path& path, const JsonObject& fields, const std::vector<JsonArray>& arrays) {
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+    file << "{\n    \"workerCount\": " << JobSystem::getWorkerCount();
+    for (const auto& [name, value] : fields.fields) {
+        file << ",\n    " << toJsonString(name) << ": " << value;
+    }
+    for (const JsonArray& array : arrays) {
+        file << ",\n    " << toJsonString(array.name) << ": [";
+        for (size_t i = 0; i < array.objects.size(); i++) {
+            file << (i == 0 ? "\n        " : ",\n        ");
+            writeJsonObject(file, array.objects[i]);
+        }
+        file << "\n    ]";
+    }
+    file << "\n}\n";
+    return file.good();
+}
+
+void saveBenchmarkResults(const std::filesystem::path& path, const JsonObject& fields, const std::vector<JsonArray>& arrays) {
+    if (path.empty()) {
+        return;
+    }
+    if (writeBenchmarkResultFile(path, fields, arrays)) {
+        std::cout << "Saved benchmark results: " << path.string() << "\n";
+    }
+    else {
+        std::cout << "Failed to write benchmark results: " << path.string() << "\n";
+    }
+}
+
+std::string toJsonString(const std::string& value) {
+    std::string result = "\"";
+    for (const char c : value) {
+        if (c == '"' || c == '\\') {
+            result += '\\';
+        }
+        result += c;
+    }
+    result += '"';
+    return result;
+}
+
+void writeJsonObject(std::ofstream& file, const JsonObject& object) {
+    file << "{";
+    for (size_t i = 0; i < object.fields.size(); i++) {
+        file << (i == 0 ? "" : ", ") << toJsonString(object.fields[i].first) << ": " << object.fields[i].second;
+    }
+    file << "}";
+}
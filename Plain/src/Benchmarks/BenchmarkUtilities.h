@@ -0,0 +1,61 @@
+#pragma once
+#include "pch.h"
+
+#include <algorithm>
+#include <limits>
+
+//harness shared by all benchmark executables
+//benchmark specific measurement and validation stays in the benchmark's main
+
+//command line arguments shared by all benchmarks, benchmark specific arguments may come before them:
+//argv[firstArgument]     = worker count, optional, uses one worker per hardware thread if not set
+//argv[firstArgument + 1] = json result file path, optional, results are only printed if not set
+struct BenchmarkSettings {
+    int workerCount = 0;
+    std::string resultFilePath;
+};
+
+BenchmarkSettings parseBenchmarkArguments(const int argc, char* argv[], const int firstArgument = 1);
+
+//returns defaultValue if argument is not set or can't be parsed, argumentName is used for the error message
+int parseIntArgument(const int argc, char* argv[], const int index, const std::string& argumentName, const int defaultValue);
+
+//returns an empty string if argument is not set
+std::string parseStringArgument(const int argc, char* argv[], const int index);
+
+//runs function repeatedly, returns the time of the fastest run in seconds
+template<typename Function>
+double measureFastest(const int repetitionCount, const Function& function) {
+    double fastest = std::numeric_limits<double>::max();
+    for (int i = 0; i < repetitionCount; i++) {
+        const std::chrono::system_clock::time_point startTime = std::chrono::system_clock::now();
+        function();
+        const std::chrono::duration<double> time = std::chrono::system_clock::now() - startTime;
+        fastest = std::min(fastest, time.count());
+    }
+    return fastest;
+}
+
+//flat json object, values are formatted when added and written in the order they were added
+struct JsonObject {
+    void addString(const std::string& name, const std::string& value);
+    void addNumber(const std::string& name, const double value);
+    void addInteger(const std::string& name, const int64_t value);
+    void addBool(const std::string& name, const bool value);
+    void addUVec3(const std::string& name, const glm::uvec3& value);
+
+    //name and formatted value
+    std::vector<std::pair<std::string, std::string>> fields;
+};
+
+struct JsonArray {
+    std::string name;
+    std::vector<JsonObject> objects;
+};
+
+//top level object starts with the job system's worker count, followed by fields and then arrays
+//returns false if file could not be written
+bool writeBenchmarkResultFile(const std::filesystem::path& path, const JsonObject& fields, const std::vector<JsonArray>& arrays);
+
+//writes result file if path is not empty and prints if it succeeded
+void saveBenchmarkResults(const std::filesystem::path& path, const JsonObject& fields, const std::vector<JsonArray>& arrays);
@@ -0,0 +1,244 @@
+#include "pch.h"
+#include "Common/CompressedTypes.h"
+#include "Common/JobSystem.h"
+#include "Benchmarks/BenchmarkUtilities.h"
+
+#include <atomic>
+#include <random>
+
+//batch conversions must match the single value versions for every input, so all 2^32 float bit patterns are compared
+struct ValidationResult {
+    std::string name;
+    uint64_t testedCount = 0;
+    uint64_t mismatchCount = 0;
+    uint32_t firstMismatchBits = 0;     //input bit pattern of the first mismatch found, not necessarily the smallest
+};
+
+//fastest of all repetitions
+struct ThroughputResult {
+    std::string name;
+    size_t valueCount = 0;
+    double scalarTime = 0.0;
+    double batchTime = 0.0;
+    double scalarValuesPerSecond = 0.0;
+    double batchValuesPerSecond = 0.0;
+};
+
+float floatFromBits(const uint32_t bits) {
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+//every chunk converts a contiguous range of bit patterns with the batch function and compares against the scalar one
+//returns the number of mismatches, outFirstMismatchBits is only written if there is one
+using ChunkComparison = std::function<size_t(const uint64_t firstBits, const size_t count, uint32_t* outFirstMismatchBits)>;
+
+ValidationResult validateAllFloats(const std::string& name, const ChunkComparison& compareChunk) {
+    const size_t chunkSize = 4096;
+    const uint64_t valueCount = uint64_t(1) << 32;
+    const size_t chunkCount = valueCount / chunkSize;
+
+    std::atomic<uint64_t> mismatchCount = 0;
+    std::atomic<uint32_t> firstMismatchBits = 0;
+    JobSystem::parallelFor(0, chunkCount, 256,
+        [&compareChunk, &mismatchCount, &firstMismatchBits](const size_t rangeBegin, const size_t rangeEnd, int) {
+        for (size_t chunk = rangeBegin; chunk < rangeEnd; chunk++) {
+            uint32_t chunkFirstMismatchBits = 0;
+            const size_t chunkMismatchCount = compareChunk(uint64_t(chunk) * chunkSize, chunkSize, &chunkFirstMismatchBits);
+            if (chunkMismatchCount > 0 && mismatchCount.fetch_add(chunkMismatchCount) == 0) {
+                firstMismatchBits = chunkFirstMismatchBits;
+            }
+        }
+    });
+
+    ValidationResult result;
+    result.name = name;
+    result.testedCount = valueCount;
+    result.mismatchCount = mismatchCount;
+    result.firstMismatchBits = firstMismatchBits;
+    return result;
+}
+
+size_t compareHalfChunk(const uint64_t firstBits, const size_t count, uint32_t* outFirstMismatchBits) {
+    std::vector<float> values(count);
+    for (size_t i = 0; i < count; i++) {
+        values[i] = floatFromBits(uint32_t(firstBits + i));
+    }
+    std::vector<uint16_t> halfs(count);
+    floatsToHalf(values, halfs);
+    size_t mismatchCount = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (halfs[i] != glm::packHalf1x16(values[i]) && mismatchCount++ == 0) {
+            *outFirstMismatchBits = uint32_t(firstBits + i);
+        }
+    }
+    return mismatchCount;
+}
+
+//every value is used in all components, with different signs and scales, so the lane shuffles are validated as well
+size_t compareR10G10B10A2Chunk(const uint64_t firstBits, const size_t count, uint32_t* outFirstMismatchBits) {
+    std::vector<glm::vec3> vectors(count);
+    for (size_t i = 0; i < count; i++) {
+        const float f = floatFromBits(uint32_t(firstBits + i));
+        vectors[i] = glm::vec3(f, -f, f * 0.5f);
+    }
+    std::vector<NormalizedR10G10B10A2> packed(count);
+    vec3sToNormalizedR10B10G10A2(vectors, packed);
+    size_t mismatchCount = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (packed[i].value != vec3ToNormalizedR10B10G10A2(vectors[i]).value && mismatchCount++ == 0) {
+            *outFirstMismatchBits = uint32_t(firstBits + i);
+        }
+    }
+    return mismatchCount;
+}
+
+//every half value except NaN must survive conversion to float and back
+//NaN payloads are not guaranteed to survive the conversion to float, depending on platform
+ValidationResult validateHalfRoundTrip() {
+    std::vector<uint16_t> originalHalfs;
+    std::vector<float> values;
+    for (uint32_t i = 0; i <= std::numeric_limits<uint16_t>::max(); i++) {
+        const bool isNaN = (i & 0x7fff) > 0x7c00;
+        if (!isNaN) {
+            originalHalfs.push_back((uint16_t)i);
+            values.push_back(glm::unpackHalf1x16((uint16_t)i));
+        }
+    }
+    std::vector<uint16_t> halfs(values.size());
+    floatsToHalf(values, halfs);
+
+    ValidationResult result;
+    result.name = "Half round trip";
+    result.testedCount = halfs.size();
+    for (size_t i = 0; i < halfs.size(); i++) {
+        if (halfs[i] != originalHalfs[i]) {
+            if (result.mismatchCount == 0) {
+                result.firstMismatchBits = originalHalfs[i];
+            }
+            result.mismatchCount++;
+        }
+    }
+    return result;
+}
+
+//values in typical attribute range, single threaded
+std::vector<ThroughputResult> measureThroughput(const size_t valueCount, const int repetitionCount) {
+    std::mt19937 randomEngine(12345);
+    std::uniform_real_distribution<float> distribution(-1.f, 1.f);
+
+    std::vector<float> values(valueCount);
+    for (float& value : values) {
+        value = distribution(randomEngine);
+    }
+    std::vector<glm::vec3> vectors(valueCount);
+    for (glm::vec3& vector : vectors) {
+        vector = glm::vec3(distribution(randomEngine), distribution(randomEngine), distribution(randomEngine));
+    }
+    std::vector<uint16_t> halfs(valueCount);
+    std::vector<NormalizedR10G10B10A2> packed(valueCount);
+
+    std::vector<ThroughputResult> results(2);
+    results[0].name = "Half";
+    results[0].scalarTime = measureFastest(repetitionCount, [&]() {
+        for (size_t i = 0; i < valueCount; i++) {
+            halfs[i] = glm::packHalf1x16(values[i]);
+        }
+    });
+    results[0].batchTime = measureFastest(repetitionCount, [&]() {
+        floatsToHalf(values, halfs);
+    });
+
+    results[1].name = "R10G10B10A2";
+    results[1].scalarTime = measureFastest(repetitionCount, [&]() {
+        for (size_t i = 0; i < valueCount; i++) {
+            packed[i] = vec3ToNormalizedR10B10G10A2(vectors[i]);
+        }
+    });
+    results[1].batchTime = measureFastest(repetitionCount, [&]() {
+        vec3sToNormalizedR10B10G10A2(vectors, packed);
+    });
+
+    for (ThroughputResult& result : results) {
+        result.valueCount = valueCount;
+        result.scalarValuesPerSecond = valueCount / result.scalarTime;
+        result.batchValuesPerSecond = valueCount / result.batchTime;
+    }
+    return results;
+}
+
+void printValidationResult(const ValidationResult& result) {
+    std::cout << result.name << ": " << result.testedCount << " values tested, ";
+    if (result.mismatchCount == 0) {
+        std::cout << "batch matches scalar\n";
+    }
+    else {
+        std::cout << result.mismatchCount << " MISMATCHES, first found at bit pattern 0x"
+            << std::hex << result.firstMismatchBits << std::dec << "\n";
+    }
+}
+
+void printThroughputResult(const ThroughputResult& result) {
+    std::cout << result.name << " (" << result.valueCount << " values): scalar "
+        << result.scalarValuesPerSecond / 1000000.0 << "M values/s, batch "
+        << result.batchValuesPerSecond / 1000000.0 << "M values/s, speedup "
+        << result.scalarTime / result.batchTime << "x\n";
+}
+
+JsonObject toJsonObject(const ValidationResult& result) {
+    JsonObject object;
+    object.addString("name", result.name);
+    object.addInteger("testedCount", result.testedCount);
+    object.addInteger("mismatchCount", result.mismatchCount);
+    return object;
+}
+
+JsonObject toJsonObject(const ThroughputResult& result) {
+    JsonObject object;
+    object.addString("name", result.name);
+    object.addInteger("valueCount", result.valueCount);
+    object.addNumber("scalarValuesPerSecond", result.scalarValuesPerSecond);
+    object.addNumber("batchValuesPerSecond", result.batchValuesPerSecond);
+    return object;
+}
+
+int main(const int argc, char* argv[]) {
+
+    //expected command line arguments:
+    //argv[0] = executablePath
+    //argv[1] = worker count, optional, uses one worker per hardware thread if not set
+    //argv[2] = json result file path, optional, results are only printed if not set
+    const BenchmarkSettings settings = parseBenchmarkArguments(argc, argv);
+    JobSystem::JobSystemConfig jobSystemConfig;
+    jobSystemConfig.workerCount = (unsigned int)std::max(settings.workerCount, 0);
+    JobSystem::initJobSystem(jobSystemConfig);
+
+    std::cout << "Validating batch conversions with " << JobSystem::getWorkerCount() << " workers\n";
+    std::vector<ValidationResult> validationResults;
+    validationResults.push_back(validateAllFloats("Half", compareHalfChunk));
+    printValidationResult(validationResults.back());
+    validationResults.push_back(validateAllFloats("R10G10B10A2", compareR10G10B10A2Chunk));
+    printValidationResult(validationResults.back());
+    validationResults.push_back(validateHalfRoundTrip());
+    printValidationResult(validationResults.back());
+
+    const size_t throughputValueCount = 1 << 24;
+    const int repetitionCount = 5;
+    const std::vector<ThroughputResult> throughputResults = measureThroughput(throughputValueCount, repetitionCount);
+    for (const ThroughputResult& result : throughputResults) {
+        printThroughputResult(result);
+    }
+
+    JsonArray validationArray = { "validation", {} };
+    for (const ValidationResult& result : validationResults) {
+        validationArray.objects.push_back(toJsonObject(result));
+    }
+    JsonArray throughputArray = { "throughput", {} };
+    for (const ThroughputResult& result : throughputResults) {
+        throughputArray.objects.push_back(toJsonObject(result));
+    }
+    saveBenchmarkResults(settings.resultFilePath, JsonObject(), { validationArray, throughputArray });
+    JobSystem::shutdownJobSystem();
+    return 0;
+}
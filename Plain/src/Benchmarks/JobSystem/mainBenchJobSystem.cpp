@@ -0,0 +1,246 @@
+#include "pch.h"
+#include "Common/JobSystem.h"
+#include "Benchmarks/BenchmarkUtilities.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <thread>
+
+//global allocation count, used to verify that adding and running jobs doesn't allocate
+std::atomic<uint64_t> g_allocationCount = 0;
+
+void* operator new(size_t size) {
+    g_allocationCount.fetch_add(1, std::memory_order_relaxed);
+    void* memory = std::malloc(size == 0 ? 1 : size);
+    if (memory == nullptr) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+    std::free(memory);
+}
+
+struct BenchmarkResult {
+    double time = 0.0;
+    uint64_t allocationCount = 0;
+};
+
+//fastest of all repetitions, used for printing and json output
+struct NamedResult {
+    std::string name;
+    int jobCount = 0;
+    int iterationCount = 0;  //timed iterations within one run, latency is time per iteration
+    BenchmarkResult result;
+};
+
+//expected command line arguments:
+//argv[0] = executablePath
+//argv[1] = worker count, optional, uses one worker per hardware thread if not set
+//argv[2] = pin workers, optional, 1 pins every worker to a single hardware thread
+//argv[3] = json result file path, optional, results are only printed if not set
+struct CommandLineSettings {
+    int workerCount = 0;
+    bool pinWorkers = false;
+    std::string resultFilePath;
+};
+
+CommandLineSettings parseCommandLineArguments(const int argc, char* argv[]) {
+    CommandLineSettings settings;
+    settings.workerCount = parseIntArgument(argc, argv, 1, "worker count", 0);
+    settings.pinWorkers = parseIntArgument(argc, argv, 2, "pin workers", 0) != 0;
+    settings.resultFilePath = parseStringArgument(argc, argv, 3);
+    return settings;
+}
+
+//jobs are added by the main thread
+BenchmarkResult measureEmptyJobsFromMainThread(const int jobCount) {
+    JobSystem::Counter counter;
+    const uint64_t allocationCountStart = g_allocationCount.load();
+    const std::chrono::system_clock::time_point startTime = std::chrono::system_clock::now();
+
+    for (int i = 0; i < jobCount; i++) {
+        JobSystem::addJob([](int) {}, &counter);
+    }
+    JobSystem::waitOnCounter(counter);
+
+    const std::chrono::duration<double> time = std::chrono::system_clock::now() - startTime;
+    BenchmarkResult result;
+    result.time = time.count();
+    result.allocationCount = g_allocationCount.load() - allocationCountStart;
+    return result;
+}
+
+//jobs are added by a single job running on a worker, other workers have to steal them
+BenchmarkResult measureEmptyJobsFromWorker(const int jobCount) {
+    JobSystem::Counter counter;
+    const uint64_t allocationCountStart = g_allocationCount.load();
+    const std::chrono::system_clock::time_point startTime = std::chrono::system_clock::now();
+
+    JobSystem::addJob([jobCount, &counter](int) {
+        for (int i = 0; i < jobCount; i++) {
+            JobSystem::addJob([](int) {}, &counter);
+        }
+    }, &counter);
+    JobSystem::waitOnCounter(counter);
+
+    const std::chrono::duration<double> time = std::chrono::system_clock::now() - startTime;
+    BenchmarkResult result;
+    result.time = time.count();
+    result.allocationCount = g_allocationCount.load() - allocationCountStart;
+    return result;
+}
+
+//main thread repeatedly adds a small batch of jobs and waits on their counter
+//measures the round trip of waking workers and seeing the counter reach zero, like recording a frame
+BenchmarkResult measureFanOutFanIn(const int fanOut, const int iterationCount) {
+    const uint64_t allocationCountStart = g_allocationCount.load();
+    const std::chrono::system_clock::time_point startTime = std::chrono::system_clock::now();
+
+    for (int iteration = 0; iteration < iterationCount; iteration++) {
+        JobSystem::Counter counter;
+        for (int i = 0; i < fanOut; i++) {
+            JobSystem::addJob([](int) {}, &counter);
+        }
+        JobSystem::waitOnCounter(counter);
+    }
+
+    const std::chrono::duration<double> time = std::chrono::system_clock::now() - startTime;
+    BenchmarkResult result;
+    result.time = time.count();
+    result.allocationCount = g_allocationCount.load() - allocationCountStart;
+    return result;
+}
+
+//threads that aren't workers add jobs at the same time, so they contend on the submission queue
+//each submitter waits on its own counter, time is measured from the start signal until all submitters finished
+//creating and joining the submitter threads is not measured, but its allocations are counted
+BenchmarkResult measureProducerContention(const int submitterCount, const int jobsPerSubmitter) {
+    std::atomic<bool> isStarted = false;
+    std::vector<std::thread> submitters;
+    submitters.reserve(submitterCount);
+    std::atomic<int> finishedCount = 0;
+    const uint64_t allocationCountStart = g_allocationCount.load();
+
+    for (int submitterIndex = 0; submitterIndex < submitterCount; submitterIndex++) {
+        submitters.emplace_back([&isStarted, &finishedCount, jobsPerSubmitter]() {
+            while (!isStarted.load()) {
+                std::this_thread::yield();
+            }
+            JobSystem::Counter counter;
+            for (int i = 0; i < jobsPerSubmitter; i++) {
+                JobSystem::addJob([](int) {}, &counter);
+            }
+            JobSystem::waitOnCounter(counter);
+            finishedCount.fetch_add(1);
+        });
+    }
+
+    const std::chrono::system_clock::time_point startTime = std::chrono::system_clock::now();
+    isStarted.store(true);
+    while (finishedCount.load() < submitterCount) {
+        std::this_thread::yield();
+    }
+    const std::chrono::duration<double> time = std::chrono::system_clock::now() - startTime;
+
+    for (std::thread& submitter : submitters) {
+        submitter.join();
+    }
+    BenchmarkResult result;
+    result.time = time.count();
+    result.allocationCount = g_allocationCount.load() - allocationCountStart;
+    return result;
+}
+
+//runs benchmark repeatedly and keeps the fastest run, allocations are the ones of the same run
+template<typename Benchmark>
+NamedResult runBenchmark(const std::string& name, const int jobCount, const int iterationCount,
+    const int repetitionCount, const Benchmark& benchmark) {
+    //first run to warm up threads and let queues and job pools grow
+    benchmark();
+
+    NamedResult named;
+    named.name = name;
+    named.jobCount = jobCount;
+    named.iterationCount = iterationCount;
+    for (int i = 0; i < repetitionCount; i++) {
+        const BenchmarkResult result = benchmark();
+        if (i == 0 || result.time < named.result.time) {
+            named.result = result;
+        }
+    }
+    return named;
+}
+
+void printResult(const NamedResult& named) {
+    const BenchmarkResult& result = named.result;
+    std::cout << named.name << ": " << named.jobCount / result.time / 1000000.0 << " million jobs/s (" << result.time << "s), "
+        << result.time / named.iterationCount * 1000000.0 << "us per iteration, "
+        << (double)result.allocationCount / named.jobCount << " allocations per job\n";
+}
+
+JsonObject toJsonObject(const NamedResult& named) {
+    const BenchmarkResult& result = named.result;
+    JsonObject object;
+    object.addString("name", named.name);
+    object.addInteger("jobCount", named.jobCount);
+    object.addInteger("iterationCount", named.iterationCount);
+    object.addNumber("timeSeconds", result.time);
+    object.addNumber("jobsPerSecond", named.jobCount / result.time);
+    object.addNumber("latencyMicroseconds", result.time / named.iterationCount * 1000000.0);
+    object.addNumber("allocationsPerJob", (double)result.allocationCount / named.jobCount);
+    return object;
+}
+
+int main(const int argc, char* argv[]) {
+
+    const CommandLineSettings settings = parseCommandLineArguments(argc, argv);
+    JobSystem::JobSystemConfig jobSystemConfig;
+    jobSystemConfig.workerCount = (unsigned int)std::max(settings.workerCount, 0);
+    jobSystemConfig.pinWorkers = settings.pinWorkers;
+    JobSystem::initJobSystem(jobSystemConfig);
+
+    const int jobCount = 1000000;
+    const int repetitionCount = 5;
+
+    const int fanOut = 16;
+    const int fanOutIterationCount = 10000;
+
+    const int jobsPerSubmitter = 100000;
+    const std::array<int, 3> submitterCounts = { 1, 4, 16 };
+
+    std::vector<NamedResult> results;
+    results.push_back(runBenchmark("Empty jobs added from main thread", jobCount, 1, repetitionCount, [jobCount]() {
+        return measureEmptyJobsFromMainThread(jobCount);
+    }));
+    results.push_back(runBenchmark("Empty jobs added from worker", jobCount, 1, repetitionCount, [jobCount]() {
+        return measureEmptyJobsFromWorker(jobCount);
+    }));
+    results.push_back(runBenchmark("Fan out and in of " + std::to_string(fanOut) + " jobs", fanOut * fanOutIterationCount,
+        fanOutIterationCount, repetitionCount, [fanOut, fanOutIterationCount]() {
+        return measureFanOutFanIn(fanOut, fanOutIterationCount);
+    }));
+    for (const int submitterCount : submitterCounts) {
+        results.push_back(runBenchmark("Empty jobs added from " + std::to_string(submitterCount) + " submitter threads",
+            submitterCount * jobsPerSubmitter, 1, repetitionCount, [submitterCount, jobsPerSubmitter]() {
+            return measureProducerContention(submitterCount, jobsPerSubmitter);
+        }));
+    }
+
+    for (const NamedResult& result : results) {
+        printResult(result);
+    }
+    JsonArray resultArray = { "results", {} };
+    for (const NamedResult& result : results) {
+        resultArray.objects.push_back(toJsonObject(result));
+    }
+    saveBenchmarkResults(settings.resultFilePath, JsonObject(), { resultArray });
+    JobSystem::shutdownJobSystem();
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,207 @@
+#include "pch.h"
+#include "Common/MeshProcessing.h"
+#include "Common/JobSystem.h"
+#include "Benchmarks/BenchmarkUtilities.h"
+
+#include <random>
+
+//synthetic scene, attribute values don't influence packing speed, only vertex and mesh count do
+struct TestScene {
+    std::string name;
+    std::vector<MeshData> meshes;
+    std::vector<AxisAlignedBoundingBox> AABBList;
+    size_t vertexCount = 0;
+};
+
+//fastest of all repetitions
+struct PackingBenchmarkResult {
+    std::string sceneName;
+    std::string packerName;
+    size_t meshCount = 0;
+    size_t vertexCount = 0;
+    double time = 0.0;
+    double verticesPerSecond = 0.0;
+    bool matchesReference = false;
+};
+
+MeshData createRandomMesh(const size_t vertexCount, std::mt19937& randomEngine) {
+    std::uniform_real_distribution<float> positionDistribution(-100.f, 100.f);
+    std::uniform_real_distribution<float> uvDistribution(-2.f, 2.f);
+    std::uniform_real_distribution<float> directionDistribution(-1.f, 1.f);
+    const auto randomDirection = [&]() {
+        const glm::vec3 v = glm::vec3(
+            directionDistribution(randomEngine),
+            directionDistribution(randomEngine),
+            directionDistribution(randomEngine));
+        return glm::length(v) > 0.001f ? glm::normalize(v) : glm::vec3(0.f, 1.f, 0.f);
+    };
+
+    MeshData mesh;
+    mesh.positions.resize(vertexCount);
+    mesh.uvs.resize(vertexCount);
+    mesh.normals.resize(vertexCount);
+    mesh.tangents.resize(vertexCount);
+    mesh.bitangents.resize(vertexCount);
+    for (size_t i = 0; i < vertexCount; i++) {
+        mesh.positions[i] = glm::vec3(
+            positionDistribution(randomEngine),
+            positionDistribution(randomEngine),
+            positionDistribution(randomEngine));
+        mesh.uvs[i] = glm::vec2(uvDistribution(randomEngine), uvDistribution(randomEngine));
+        mesh.normals[i] = randomDirection();
+        mesh.tangents[i] = randomDirection();
+        mesh.bitangents[i] = randomDirection();
+    }
+    //one triangle per three vertices, index count only decides between 16 and 32 bit indices
+    mesh.indices.resize(vertexCount / 3 * 3);
+    for (size_t i = 0; i < mesh.indices.size(); i++) {
+        mesh.indices[i] = (uint32_t)i;
+    }
+    return mesh;
+}
+
+TestScene createTestScene(const std::string& name, const size_t meshCount, const size_t verticesPerMesh) {
+    std::mt19937 randomEngine(12345);
+    TestScene scene;
+    scene.name = name;
+    scene.meshes.reserve(meshCount);
+    for (size_t i = 0; i < meshCount; i++) {
+        scene.meshes.push_back(createRandomMesh(verticesPerMesh, randomEngine));
+    }
+    scene.AABBList = AABBListFromMeshes(scene.meshes);
+    scene.vertexCount = meshCount * verticesPerMesh;
+    return scene;
+}
+
+//previous packer, kept as reference for output and speed
+//serial, every byte is pushed back individually into a vector that isn't reserved
+std::vector<std::vector<uint8_t>> packScenePerByte(const TestScene& scene) {
+    std::vector<std::vector<uint8_t>> vertexBuffers;
+    for (const MeshData& mesh : scene.meshes) {
+        std::vector<uint8_t> vertexBuffer;
+        const auto pushBytes = [&vertexBuffer](const void* data, const size_t size) {
+            for (size_t i = 0; i < size; i++) {
+                vertexBuffer.push_back(((uint8_t*)data)[i]);
+            }
+        };
+        for (size_t i = 0; i < mesh.positions.size(); i++) {
+            pushBytes(&mesh.positions[i].x, sizeof(float));
+            pushBytes(&mesh.positions[i].y, sizeof(float));
+            pushBytes(&mesh.positions[i].z, sizeof(float));
+
+            const auto uHalf = glm::packHalf(glm::vec1(mesh.uvs[i].x));
+            pushBytes(&uHalf, sizeof(uHalf));
+            const auto vHalf = glm::packHalf(glm::vec1(mesh.uvs[i].y));
+            pushBytes(&vHalf, sizeof(vHalf));
+
+            const NormalizedR10G10B10A2 normalCompressed = vec3ToNormalizedR10B10G10A2(mesh.normals[i]);
+            pushBytes(&normalCompressed, sizeof(normalCompressed));
+            const NormalizedR10G10B10A2 tangentCompressed = vec3ToNormalizedR10B10G10A2(mesh.tangents[i]);
+            pushBytes(&tangentCompressed, sizeof(tangentCompressed));
+            const NormalizedR10G10B10A2 bitangentCompressed = vec3ToNormalizedR10B10G10A2(mesh.bitangents[i]);
+            pushBytes(&bitangentCompressed, sizeof(bitangentCompressed));
+        }
+        vertexBuffers.push_back(std::move(vertexBuffer));
+    }
+    return vertexBuffers;
+}
+
+//bulk packer on the calling thread only, isolates the gain of struct writes from the gain of parallelism
+std::vector<std::vector<uint8_t>> packSceneSerial(const TestScene& scene) {
+    std::vector<std::vector<uint8_t>> vertexBuffers(scene.meshes.size());
+    for (size_t i = 0; i < scene.meshes.size(); i++) {
+        const MeshData& mesh = scene.meshes[i];
+        vertexBuffers[i].resize(mesh.positions.size() * sizeof(PackedVertex));
+        packVertices(mesh, 0, mesh.positions.size(), (PackedVertex*)vertexBuffers[i].data());
+    }
+    return vertexBuffers;
+}
+
+//also packs index buffers, so it does slightly more work than the other packers
+std::vector<std::vector<uint8_t>> packSceneParallel(const TestScene& scene) {
+    std::vector<MeshBinary> meshesBinary = meshesToBinary(scene.meshes, scene.AABBList);
+    std::vector<std::vector<uint8_t>> vertexBuffers;
+    vertexBuffers.reserve(meshesBinary.size());
+    for (MeshBinary& meshBinary : meshesBinary) {
+        vertexBuffers.push_back(std::move(meshBinary.vertexBuffer));
+    }
+    return vertexBuffers;
+}
+
+using ScenePacker = std::function<std::vector<std::vector<uint8_t>>(const TestScene& scene)>;
+
+PackingBenchmarkResult runBenchmark(const TestScene& scene, const std::string& packerName, const ScenePacker& packer,
+    const std::vector<std::vector<uint8_t>>& reference, const int repetitionCount) {
+
+    PackingBenchmarkResult result;
+    result.sceneName = scene.name;
+    result.packerName = packerName;
+    result.meshCount = scene.meshes.size();
+    result.vertexCount = scene.vertexCount;
+    //packers are deterministic, so only the output of the last repetition is compared
+    std::vector<std::vector<uint8_t>> vertexBuffers;
+    result.time = measureFastest(repetitionCount, [&]() {
+        vertexBuffers = packer(scene);
+    });
+    result.matchesReference = vertexBuffers == reference;
+    result.verticesPerSecond = result.vertexCount / result.time;
+    return result;
+}
+
+void printResult(const PackingBenchmarkResult& result) {
+    std::cout << result.sceneName << " (" << result.meshCount << " meshes, " << result.vertexCount << " vertices), "
+        << result.packerName << ": " << result.time * 1000.0 << "ms, "
+        << result.verticesPerSecond / 1000000.0 << "M vertices/s"
+        << (result.matchesReference ? "" : ", OUTPUT DOES NOT MATCH REFERENCE") << "\n";
+}
+
+JsonObject toJsonObject(const PackingBenchmarkResult& result) {
+    JsonObject object;
+    object.addString("scene", result.sceneName);
+    object.addString("packer", result.packerName);
+    object.addInteger("meshCount", result.meshCount);
+    object.addInteger("vertexCount", result.vertexCount);
+    object.addNumber("timeSeconds", result.time);
+    object.addNumber("verticesPerSecond", result.verticesPerSecond);
+    object.addBool("matchesReference", result.matchesReference);
+    return object;
+}
+
+int main(const int argc, char* argv[]) {
+
+    //expected command line arguments:
+    //argv[0] = executablePath
+    //argv[1] = worker count, optional, uses one worker per hardware thread if not set
+    //argv[2] = json result file path, optional, results are only printed if not set
+    const BenchmarkSettings settings = parseBenchmarkArguments(argc, argv);
+    JobSystem::JobSystemConfig jobSystemConfig;
+    jobSystemConfig.workerCount = (unsigned int)std::max(settings.workerCount, 0);
+    JobSystem::initJobSystem(jobSystemConfig);
+
+    const int repetitionCount = 5;
+
+    //one mesh only benefits from splitting into vertex ranges, many small meshes from packing meshes in parallel
+    std::vector<TestScene> scenes;
+    scenes.push_back(createTestScene("Single large mesh", 1, 4000000));
+    scenes.push_back(createTestScene("Many small meshes", 4000, 1000));
+
+    std::cout << "Packing vertices with " << JobSystem::getWorkerCount() << " workers\n";
+    std::vector<PackingBenchmarkResult> results;
+    for (const TestScene& scene : scenes) {
+        const std::vector<std::vector<uint8_t>> reference = packScenePerByte(scene);
+        results.push_back(runBenchmark(scene, "per byte", packScenePerByte, reference, repetitionCount));
+        printResult(results.back());
+        results.push_back(runBenchmark(scene, "bulk serial", packSceneSerial, reference, repetitionCount));
+        printResult(results.back());
+        results.push_back(runBenchmark(scene, "bulk parallel", packSceneParallel, reference, repetitionCount));
+        printResult(results.back());
+    }
+
+    JsonArray resultArray = { "results", {} };
+    for (const PackingBenchmarkResult& result : results) {
+        resultArray.objects.push_back(toJsonObject(result));
+    }
+    saveBenchmarkResults(settings.resultFilePath, JsonObject(), { resultArray });
+    JobSystem::shutdownJobSystem();
+    return 0;
+}
@@ -0,0 +1,425 @@
+#include "pch.h"
+#include "AssetPipeline/SceneSDF.h"
+#include "Common/JobSystem.h"
+#include "Common/sdfUtilities.h"
+#include "Utilities/MathUtils.h"
+#include "Benchmarks/BenchmarkUtilities.h"
+
+#include <functional>
+#include <random>
+
+//procedural mesh, closed meshes have a defined inside, so the sign of the baked distance is validated
+struct TestMesh {
+    std::string name;
+    MeshData mesh;
+    AxisAlignedBoundingBox boundingBox;
+    bool isClosed = true;
+};
+
+struct SDFBenchmarkResult {
+    std::string meshName;
+    size_t triangleCount = 0;
+    glm::uvec3 resolution = glm::uvec3(0);  //effective texel resolution
+    size_t storedTexelCount = 0;
+    double bakeTime = 0.0;
+    double texelsPerSecondPerThread = 0.0;
+
+    //baked compared to reference distance at sampled texels, in texels
+    float maxError = 0.f;
+    float meanError = 0.f;
+    size_t sampleCount = 0;
+    size_t signErrorCount = 0;
+};
+
+//expected command line arguments:
+//argv[0] = executablePath
+//argv[1] = SDF bake method, optional, uses exact if not set
+//  "exact" = closest triangle distance with winding number sign
+//  "bvh"   = ray casting with BVH
+//  "grid"  = ray casting with uniform grid
+//argv[2] = worker count, optional, uses one worker per hardware thread if not set
+//argv[3] = json result file path, optional, results are only printed if not set
+struct CommandLineSettings {
+    SDFBakeMethod sdfBakeMethod = SDFBakeMethod::ClosestPointWindingNumber;
+    std::string sdfBakeMethodName = "exact";
+    BenchmarkSettings benchmark;
+};
+
+CommandLineSettings parseCommandLineArguments(const int argc, char* argv[]) {
+    CommandLineSettings settings;
+    if (argc < 2) {
+        return settings;
+    }
+    const std::string bakeMethod = argv[1];
+    if (bakeMethod == "grid") {
+        settings.sdfBakeMethod = SDFBakeMethod::UniformGridRays;
+        settings.sdfBakeMethodName = bakeMethod;
+    }
+    else if (bakeMethod == "bvh") {
+        settings.sdfBakeMethod = SDFBakeMethod::BVHRays;
+        settings.sdfBakeMethodName = bakeMethod;
+    }
+    else if (bakeMethod != "exact") {
+        std::cout << "Unknown SDF bake method '" << bakeMethod << "', using exact\n";
+    }
+    settings.benchmark = parseBenchmarkArguments(argc, argv, 2);
+    return settings;
+}
+
+//grid of (uCount + 1) x (vCount + 1) vertices, parameters are in range [0:1]
+//triangles face outwards if u goes around the up axis and v from top to bottom, like sphere coordinates
+MeshData createParametricMesh(const uint32_t uCount, const uint32_t vCount,
+    const std::function<glm::vec3(float u, float v)>& surface) {
+
+    MeshData mesh;
+    for (uint32_t v = 0; v <= vCount; v++) {
+        for (uint32_t u = 0; u <= uCount; u++) {
+            mesh.positions.push_back(surface(u / float(uCount), v / float(vCount)));
+        }
+    }
+    const auto vertexIndex = [uCount](const uint32_t u, const uint32_t v) {
+        return v * (uCount + 1) + u;
+    };
+    for (uint32_t v = 0; v < vCount; v++) {
+        for (uint32_t u = 0; u < uCount; u++) {
+            const uint32_t i00 = vertexIndex(u, v);
+            const uint32_t i10 = vertexIndex(u + 1, v);
+            const uint32_t i01 = vertexIndex(u, v + 1);
+            const uint32_t i11 = vertexIndex(u + 1, v + 1);
+            mesh.indices.insert(mesh.indices.end(), { i00, i01, i10, i10, i01, i11 });
+        }
+    }
+    return mesh;
+}
+
+MeshData createBoxMesh(const glm::vec3& halfExtents) {
+    MeshData mesh;
+    for (uint32_t corner = 0; corner < 8; corner++) {
+        const glm::vec3 sign = glm::vec3(corner & 1 ? 1.f : -1.f, corner & 2 ? 1.f : -1.f, corner & 4 ? 1.f : -1.f);
+        mesh.positions.push_back(sign * halfExtents);
+    }
+    //corners of each face, counter clockwise seen from outside
+    const std::array<glm::uvec4, 6> faces = {
+        glm::uvec4(0, 4, 6, 2), glm::uvec4(1, 3, 7, 5),
+        glm::uvec4(0, 1, 5, 4), glm::uvec4(2, 6, 7, 3),
+        glm::uvec4(0, 2, 3, 1), glm::uvec4(4, 5, 7, 6) };
+    //asset pipeline meshes are clockwise seen from outside
+    for (const glm::uvec4& face : faces) {
+        mesh.indices.insert(mesh.indices.end(), { face.x, face.z, face.y, face.x, face.w, face.z });
+    }
+    return mesh;
+}
+
+AxisAlignedBoundingBox computeMeshBoundingBox(const MeshData& mesh) {
+    AxisAlignedBoundingBox bb;
+    bb.min = glm::vec3(std::numeric_limits<float>::max());
+    bb.max = glm::vec3(std::numeric_limits<float>::lowest());
+    for (const glm::vec3& p : mesh.positions) {
+        bb.min = glm::min(bb.min, p);
+        bb.max = glm::max(bb.max, p);
+    }
+    return bb;
+}
+
+//all meshes are centered at the origin and have a bounding box extent of about size
+//texel size of the bake is fixed, so size selects the resolution
+std::vector<TestMesh> createTestMeshes(const float size) {
+    const float pi = 3.14159265f;
+    std::vector<TestMesh> meshes;
+
+    const float sphereRadius = 0.5f * size;
+    meshes.push_back(TestMesh{ "Sphere", createParametricMesh(64, 32, [sphereRadius, pi](const float u, const float v) {
+        const float phi = u * 2.f * pi;
+        const float theta = v * pi;
+        return sphereRadius * glm::vec3(sinf(theta) * cosf(phi), cosf(theta), sinf(theta) * sinf(phi));
+    }) });
+
+    const float torusRadius = 0.35f * size;
+    const float torusTubeRadius = 0.15f * size;
+    meshes.push_back(TestMesh{ "Torus", createParametricMesh(96, 32, [torusRadius, torusTubeRadius, pi](const float u, const float v) {
+        const float phi = u * 2.f * pi;
+        const float theta = v * 2.f * pi;
+        const float ringDistance = torusRadius + torusTubeRadius * cosf(theta);
+        return glm::vec3(ringDistance * cosf(phi), -torusTubeRadius * sinf(theta), ringDistance * sinf(phi));
+    }) });
+
+    //single sided, so there is no inside and only the distance is validated
+    meshes.push_back(TestMesh{ "Open plane", createParametricMesh(16, 16, [size](const float u, const float v) {
+        return size * glm::vec3(u - 0.5f, 0.f, v - 0.5f);
+    }) });
+    meshes.back().isClosed = false;
+
+    //closed box thinner than a texel, where the sign is hard to get right
+    const float wallThickness = 0.05f;
+    meshes.push_back(TestMesh{ "Thin wall", createBoxMesh(glm::vec3(0.5f * size, 0.5f * size, 0.5f * wallThickness)) });
+
+    //stands in for a scanned model, dense bumpy surface with many small triangles
+    const float scanRadius = 0.45f * size;
+    meshes.push_back(TestMesh{ "High poly scan", createParametricMesh(512, 256, [scanRadius, pi](const float u, const float v) {
+        const float phi = u * 2.f * pi;
+        const float theta = v * pi;
+        const float bumps = 0.05f * sinf(7.f * phi) * sinf(5.f * theta) + 0.02f * sinf(23.f * phi) * sinf(19.f * theta);
+        return scanRadius * (1.f + bumps) * glm::vec3(sinf(theta) * cosf(phi), cosf(theta), sinf(theta) * sinf(phi));
+    }) });
+
+    for (TestMesh& testMesh : meshes) {
+        testMesh.boundingBox = computeMeshBoundingBox(testMesh.mesh);
+    }
+    return meshes;
+}
+
+//reference: "Real-Time Collision Detection", Ericson, section 5.1.5
+glm::vec3 closestPointOnTriangle(const glm::vec3& p, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c) {
+    const glm::vec3 ab = b - a;
+    const glm::vec3 ac = c - a;
+    const glm::vec3 ap = p - a;
+    const float d1 = glm::dot(ab, ap);
+    const float d2 = glm::dot(ac, ap);
+    if (d1 <= 0.f && d2 <= 0.f) {
+        return a;
+    }
+    const glm::vec3 bp = p - b;
+    const float d3 = glm::dot(ab, bp);
+    const float d4 = glm::dot(ac, bp);
+    if (d3 >= 0.f && d4 <= d3) {
+        return b;
+    }
+    const float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.f && d1 >= 0.f && d3 <= 0.f) {
+        return a + d1 / (d1 - d3) * ab;
+    }
+    const glm::vec3 cp = p - c;
+    const float d5 = glm::dot(ab, cp);
+    const float d6 = glm::dot(ac, cp);
+    if (d6 >= 0.f && d5 <= d6) {
+        return c;
+    }
+    const float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.f && d2 >= 0.f && d6 <= 0.f) {
+        return a + d2 / (d2 - d6) * ac;
+    }
+    const float va = d3 * d6 - d5 * d4;
+    if (va <= 0.f && (d4 - d3) >= 0.f && (d5 - d6) >= 0.f) {
+        return b + (d4 - d3) / ((d4 - d3) + (d5 - d6)) * (c - b);
+    }
+    //degenerate triangles end up here with a zero denominator
+    const float denominator = va + vb + vc;
+    if (denominator == 0.f) {
+        return a;
+    }
+    const float v = vb / denominator;
+    const float w = vc / denominator;
+    return a + ab * v + ac * w;
+}
+
+//brute force over all triangles, independent of the acceleration structures used by the baker
+//sign is taken from the exact generalized winding number, positive distance if the mesh is open
+float computeReferenceDistance(const TestMesh& testMesh, const glm::vec3& p) {
+    const MeshData& mesh = testMesh.mesh;
+    float closestDistanceSquared = std::numeric_limits<float>::infinity();
+    double solidAngleSum = 0.0;
+    for (size_t i = 0; i < mesh.indices.size(); i += 3) {
+        const glm::vec3 v0 = mesh.positions[mesh.indices[i]];
+        const glm::vec3 v1 = mesh.positions[mesh.indices[i + 1]];
+        const glm::vec3 v2 = mesh.positions[mesh.indices[i + 2]];
+        closestDistanceSquared = glm::min(closestDistanceSquared, dot2(p - closestPointOnTriangle(p, v0, v1, v2)));
+
+        if (testMesh.isClosed) {
+            //reference: "The Solid Angle of a Plane Triangle", Van Oosterom and Strackee
+            const glm::dvec3 a = glm::dvec3(v0) - glm::dvec3(p);
+            const glm::dvec3 b = glm::dvec3(v1) - glm::dvec3(p);
+            const glm::dvec3 c = glm::dvec3(v2) - glm::dvec3(p);
+            const double lengthA = glm::length(a);
+            const double lengthB = glm::length(b);
+            const double lengthC = glm::length(c);
+            const double numerator = glm::dot(a, glm::cross(b, c));
+            const double denominator = lengthA * lengthB * lengthC + glm::dot(a, b) * lengthC
+                + glm::dot(b, c) * lengthA + glm::dot(c, a) * lengthB;
+            solidAngleSum += 2.0 * std::atan2(numerator, denominator);
+        }
+    }
+    const float distance = std::sqrt(closestDistanceSquared);
+    //triangles face outwards, which results in a negative winding number with this solid angle orientation
+    const double windingNumber = -solidAngleSum / (4.0 * 3.14159265358979);
+    return windingNumber > 0.5 ? -distance : distance;
+}
+
+//compares stored atlas texels to the reference distance, atlas must be 16 bit float
+void measureSDFError(const TestMesh& testMesh, const SparseSDFTextures& sdf, const size_t maxSampleCount,
+    SDFBenchmarkResult* outResult) {
+
+    assert(sdf.atlasDescription.format == ImageFormat::R16_sFloat);
+    const glm::uvec3 brickGridResolution = glm::uvec3(sdf.indirectionDescription.width,
+        sdf.indirectionDescription.height, sdf.indirectionDescription.depth);
+    const glm::uvec3 atlasResolution = glm::uvec3(sdf.atlasDescription.width,
+        sdf.atlasDescription.height, sdf.atlasDescription.depth);
+
+    //texels are placed on the bounding box border, like the baker does
+    const AxisAlignedBoundingBox paddedBB = padSDFBoundingBox(testMesh.boundingBox);
+    const glm::vec3 texelSize = (paddedBB.max - paddedBB.min) / glm::vec3(brickGridResolution * (sdfBrickSize - 1));
+    const float texelSizeMax = glm::max(glm::max(texelSize.x, texelSize.y), texelSize.z);
+
+    struct Sample {
+        glm::vec3 position;
+        float bakedDistance;
+    };
+    std::vector<Sample> samples;
+    const size_t storedTexelCount = sdf.storedBrickCount * sdfBrickSize * sdfBrickSize * sdfBrickSize;
+    //fixed seed, so every run validates the same texels
+    std::mt19937 randomGenerator(0);
+    std::uniform_int_distribution<size_t> texelDistribution(0, storedTexelCount == 0 ? 0 : storedTexelCount - 1);
+    const bool useAllTexels = storedTexelCount <= maxSampleCount;
+
+    std::vector<glm::uvec3> storedBricks;
+    std::vector<glm::uvec3> atlasBricks;
+    std::vector<float> decodeScales;
+    for (uint32_t z = 0; z < brickGridResolution.z; z++) {
+        for (uint32_t y = 0; y < brickGridResolution.y; y++) {
+            for (uint32_t x = 0; x < brickGridResolution.x; x++) {
+                const size_t indirectionIndex = x + y * brickGridResolution.x + z * brickGridResolution.x * brickGridResolution.y;
+                glm::u16vec4 packed;
+                memcpy(&packed, sdf.indirectionData.data() + indirectionIndex * sizeof(packed), sizeof(packed));
+                const glm::vec4 indirection = glm::unpackHalf(packed);
+                if (indirection.x >= 0.f) {
+                    storedBricks.push_back(glm::uvec3(x, y, z));
+                    atlasBricks.push_back(glm::uvec3(indirection));
+                    decodeScales.push_back(indirection.w);
+                }
+            }
+        }
+    }
+
+    const size_t sampleCount = useAllTexels ? storedTexelCount : maxSampleCount;
+    samples.reserve(sampleCount);
+    for (size_t i = 0; i < sampleCount; i++) {
+        const size_t texel = useAllTexels ? i : texelDistribution(randomGenerator);
+        const size_t brick = texel / (sdfBrickSize * sdfBrickSize * sdfBrickSize);
+        const uint32_t texelInBrick = uint32_t(texel % (sdfBrickSize * sdfBrickSize * sdfBrickSize));
+        const glm::uvec3 local = glm::uvec3(texelInBrick % sdfBrickSize, (texelInBrick / sdfBrickSize) % sdfBrickSize,
+            texelInBrick / (sdfBrickSize * sdfBrickSize));
+
+        const glm::uvec3 atlasTexel = atlasBricks[brick] * sdfBrickSize + local;
+        const size_t atlasIndex = atlasTexel.x + atlasTexel.y * size_t(atlasResolution.x)
+            + atlasTexel.z * size_t(atlasResolution.x) * atlasResolution.y;
+        uint16_t packed;
+        memcpy(&packed, sdf.atlasData.data() + atlasIndex * sizeof(packed), sizeof(packed));
+
+        Sample sample;
+        sample.position = paddedBB.min + glm::vec3(storedBricks[brick] * (sdfBrickSize - 1) + local) * texelSize;
+        sample.bakedDistance = glm::unpackHalf1x16(packed) * decodeScales[brick];
+        samples.push_back(sample);
+    }
+
+    //reference is brute force, so it is computed in parallel
+    std::vector<float> referenceDistances(samples.size());
+    const size_t samplesPerJob = 64;
+    JobSystem::Counter referenceFinished;
+    for (size_t begin = 0; begin < samples.size(); begin += samplesPerJob) {
+        JobSystem::addJob([&testMesh, &samples, &referenceDistances, begin, samplesPerJob](int) {
+            const size_t end = glm::min(begin + samplesPerJob, samples.size());
+            for (size_t i = begin; i < end; i++) {
+                referenceDistances[i] = computeReferenceDistance(testMesh, samples[i].position);
+            }
+        }, &referenceFinished);
+    }
+    JobSystem::waitOnCounter(referenceFinished);
+
+    double errorSum = 0.0;
+    for (size_t i = 0; i < samples.size(); i++) {
+        const float baked = samples[i].bakedDistance;
+        const float reference = referenceDistances[i];
+        //open meshes have no inside, so only the distance is compared
+        const float error = testMesh.isClosed ? std::abs(baked - reference) : std::abs(std::abs(baked) - reference);
+        outResult->maxError = glm::max(outResult->maxError, error / texelSizeMax);
+        errorSum += error / texelSizeMax;
+
+        //texels closer to the surface than half a texel may flip sign due to rounding, which doesn't matter when sampling
+        const bool isSignWrong = testMesh.isClosed && (baked < 0.f) != (reference < 0.f);
+        if (isSignWrong && std::abs(reference) > 0.5f * texelSizeMax) {
+            outResult->signErrorCount++;
+        }
+    }
+    outResult->sampleCount = samples.size();
+    outResult->meanError = samples.empty() ? 0.f : float(errorSum / samples.size());
+}
+
+SDFBenchmarkResult runBenchmark(const TestMesh& testMesh, const SDFBakeMethod bakeMethod, const size_t maxSampleCount) {
+    SDFBenchmarkResult result;
+    result.meshName = testMesh.name;
+    result.triangleCount = testMesh.mesh.indices.size() / 3;
+
+    SparseSDFTextures sdf;
+    JobSystem::Counter bakeFinished;
+    const std::chrono::system_clock::time_point startTime = std::chrono::system_clock::now();
+    JobSystem::addCoroutineJob(computeMeshSDFTextureAsync(testMesh.mesh, testMesh.boundingBox, &sdf, bakeMethod,
+        SDFAtlasFormat::Float16), &bakeFinished);
+    JobSystem::waitOnCounter(bakeFinished);
+    const std::chrono::duration<double> bakeTime = std::chrono::system_clock::now() - startTime;
+
+    const glm::uvec3 brickGridResolution = glm::uvec3(sdf.indirectionDescription.width,
+        sdf.indirectionDescription.height, sdf.indirectionDescription.depth);
+    result.resolution = brickGridResolution * (sdfBrickSize - 1) + 1u;
+    result.storedTexelCount = sdf.storedBrickCount * sdfBrickSize * sdfBrickSize * sdfBrickSize;
+    result.bakeTime = bakeTime.count();
+    result.texelsPerSecondPerThread = result.storedTexelCount / result.bakeTime / JobSystem::getWorkerCount();
+
+    measureSDFError(testMesh, sdf, maxSampleCount, &result);
+    return result;
+}
+
+void printResult(const SDFBenchmarkResult& result) {
+    std::cout << result.meshName << " (" << result.triangleCount << " triangles), resolution "
+        << result.resolution.x << "x" << result.resolution.y << "x" << result.resolution.z << ": "
+        << result.bakeTime << "s, " << result.texelsPerSecondPerThread / 1000.0 << "k texels/s per thread, "
+        << "error max/mean in texels: " << result.maxError << "/" << result.meanError
+        << ", sign errors: " << result.signErrorCount << "/" << result.sampleCount << "\n";
+}
+
+JsonObject toJsonObject(const SDFBenchmarkResult& result) {
+    JsonObject object;
+    object.addString("mesh", result.meshName);
+    object.addInteger("triangleCount", result.triangleCount);
+    object.addUVec3("resolution", result.resolution);
+    object.addInteger("storedTexelCount", result.storedTexelCount);
+    object.addNumber("bakeTimeSeconds", result.bakeTime);
+    object.addNumber("texelsPerSecondPerThread", result.texelsPerSecondPerThread);
+    object.addNumber("maxErrorTexels", result.maxError);
+    object.addNumber("meanErrorTexels", result.meanError);
+    object.addInteger("sampleCount", result.sampleCount);
+    object.addInteger("signErrorCount", result.signErrorCount);
+    return object;
+}
+
+int main(const int argc, char* argv[]) {
+
+    const CommandLineSettings settings = parseCommandLineArguments(argc, argv);
+    JobSystem::JobSystemConfig jobSystemConfig;
+    jobSystemConfig.workerCount = (unsigned int)std::max(settings.benchmark.workerCount, 0);
+    JobSystem::initJobSystem(jobSystemConfig);
+
+    //mesh sizes in world units, the baker targets a fixed texel size, so each size is a different resolution
+    const std::array<float, 3> meshSizes = { 2.f, 4.f, 8.f };
+
+    //reference is brute force over all triangles, so only a subset of texels is validated
+    const size_t maxSampleCount = 2048;
+
+    std::cout << "Baking SDFs using method '" << settings.sdfBakeMethodName << "' with "
+        << JobSystem::getWorkerCount() << " workers\n";
+    std::vector<SDFBenchmarkResult> results;
+    for (const float size : meshSizes) {
+        for (const TestMesh& testMesh : createTestMeshes(size)) {
+            results.push_back(runBenchmark(testMesh, settings.sdfBakeMethod, maxSampleCount));
+            printResult(results.back());
+        }
+    }
+
+    JsonObject fields;
+    fields.addString("bakeMethod", settings.sdfBakeMethodName);
+    JsonArray resultArray = { "results", {} };
+    for (const SDFBenchmarkResult& result : results) {
+        resultArray.objects.push_back(toJsonObject(result));
+    }
+    saveBenchmarkResults(settings.benchmark.resultFilePath, fields, { resultArray });
+    JobSystem::shutdownJobSystem();
+    return 0;
+}
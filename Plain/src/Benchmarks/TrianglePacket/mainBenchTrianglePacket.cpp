@@ -0,0 +1,410 @@
+#include "pch.h"
+#include "AssetPipeline/TrianglePacket.h"
+#include "Common/AABB.h"
+#include "Common/JobSystem.h"
+#include "Benchmarks/BenchmarkUtilities.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <random>
+
+//SDF bake rays are intersected with the triangles of a uniform grid cell or BVH leaf
+//the packet kernel must find the same closest hit as testing the triangles one by one, bit for bit
+//so baked SDFs don't change depending on the instruction set the pipeline is compiled with
+
+struct TriangleInfo {
+    glm::vec3 v0;
+    glm::vec3 v1;
+    glm::vec3 v2;
+    glm::vec3 N;
+};
+
+//triangles of one cell, stored in every layout that is compared
+struct TestCell {
+    std::vector<TriangleInfo> triangles;
+    TrianglePacketList packetList;
+    TriangleArray triangleArray;
+    std::vector<uint32_t> triangleIndices;
+};
+
+struct TestRay {
+    glm::vec3 origin;
+    glm::vec3 direction;
+};
+
+struct CellHit {
+    bool hitTriangle = false;
+    bool isBackfaceHit = false;
+    float closestHit = std::numeric_limits<float>::infinity();
+};
+
+struct ValidationResult {
+    std::string name;
+    uint64_t testedCount = 0;
+    uint64_t hitCount = 0;
+    uint64_t mismatchCount = 0;
+};
+
+//fastest of all repetitions
+struct ThroughputResult {
+    uint32_t trianglesPerCell = 0;
+    size_t rayCount = 0;
+    double scalarTime = 0.0;
+    double packetListTime = 0.0;
+    double gatheredPacketTime = 0.0;
+};
+
+//scalar loop the SDF baker used before triangle packets, kept as reference
+CellHit intersectCellScalar(const std::vector<TriangleInfo>& triangles, const TestRay& ray,
+    const glm::vec3& cellMin, const glm::vec3& cellMax) {
+
+    CellHit result;
+    for (const TriangleInfo& triangle : triangles) {
+
+        const float NoR = glm::dot(triangle.N, ray.direction);
+
+        if (std::abs(NoR) < 0.0001f) {
+            continue; //ray parallel to triangle
+        }
+
+        const float D = glm::dot(triangle.N, triangle.v0);
+
+        const float t = (D - glm::dot(triangle.N, ray.origin)) / NoR;
+
+        if (t < 0.f) {
+            continue; //intersection in wrong direction
+        }
+
+        const glm::vec3 edge0 = triangle.v1 - triangle.v0;
+        const glm::vec3 edge1 = triangle.v2 - triangle.v1;
+        const glm::vec3 edge2 = triangle.v0 - triangle.v2;
+
+        const glm::vec3 planeIntersection = ray.origin + ray.direction * t;
+
+        const glm::vec3 C0 = planeIntersection - triangle.v0;
+        const glm::vec3 C1 = planeIntersection - triangle.v1;
+        const glm::vec3 C2 = planeIntersection - triangle.v2;
+
+        const float d0 = glm::dot(triangle.N, cross(C0, edge0));
+        const float d1 = glm::dot(triangle.N, cross(C1, edge1));
+        const float d2 = glm::dot(triangle.N, cross(C2, edge2));
+
+        const bool isInsideTriangle =
+            d0 >= 0.f &&
+            d1 >= 0.f &&
+            d2 >= 0.f;
+
+        if (!isInsideTriangle) {
+            continue;
+        }
+
+        //discard hits in other cells
+        const glm::vec3 hitPos = ray.origin + t * ray.direction;
+        if (!isPointInAABB(hitPos, cellMin, cellMax)) {
+            continue;
+        }
+        result.hitTriangle = true;
+
+        if (t < result.closestHit) {
+            result.closestHit = t;
+            result.isBackfaceHit = glm::dot(ray.direction, triangle.N) > 0.f;
+        }
+    }
+    return result;
+}
+
+//lanes are visited in triangle order, like the baker does, so ties resolve like testing triangles one by one
+void resolvePacketHits(const TrianglePacket& packet, const TestRay& ray, const glm::vec3& cellMin, const glm::vec3& cellMax,
+    CellHit* inOutHit) {
+
+    float hitDistances[trianglePacketWidth];
+    uint32_t backfaceMask = 0;
+    uint32_t hitMask = intersectTrianglePacket(packet, ray.origin, ray.direction, cellMin, cellMax,
+        hitDistances, &backfaceMask);
+
+    inOutHit->hitTriangle |= hitMask != 0;
+    while (hitMask != 0) {
+        const int lane = std::countr_zero(hitMask);
+        hitMask &= hitMask - 1;
+        const float t = hitDistances[lane];
+        if (t < inOutHit->closestHit) {
+            inOutHit->closestHit = t;
+            inOutHit->isBackfaceHit = (backfaceMask >> lane) & 1;
+        }
+    }
+}
+
+//layout of BVH leaves
+CellHit intersectCellPacketList(const TestCell& cell, const TestRay& ray, const glm::vec3& cellMin, const glm::vec3& cellMax) {
+    CellHit result;
+    for (const TrianglePacket& packet : cell.packetList.packets) {
+        resolvePacketHits(packet, ray, cellMin, cellMax, &result);
+    }
+    return result;
+}
+
+//layout of the uniform grid, triangles are gathered into packets per ray
+CellHit intersectCellGathered(const TestCell& cell, const TestRay& ray, const glm::vec3& cellMin, const glm::vec3& cellMax) {
+    CellHit result;
+    const uint32_t triangleCount = (uint32_t)cell.triangleIndices.size();
+    for (uint32_t packetBegin = 0; packetBegin < triangleCount; packetBegin += trianglePacketWidth) {
+        TrianglePacket packet;
+        gatherTrianglePacket(cell.triangleArray, &cell.triangleIndices[packetBegin],
+            glm::min(triangleCount - packetBegin, trianglePacketWidth), &packet);
+        resolvePacketHits(packet, ray, cellMin, cellMax, &result);
+    }
+    return result;
+}
+
+bool areHitsIdentical(const CellHit& a, const CellHit& b) {
+    if (a.hitTriangle != b.hitTriangle) {
+        return false;
+    }
+    if (!a.hitTriangle) {
+        return true;
+    }
+    return memcmp(&a.closestHit, &b.closestHit, sizeof(float)) == 0 && a.isBackfaceHit == b.isBackfaceHit;
+}
+
+//unit cell at the origin, triangles reach out of the cell like they do in a uniform grid
+//if isQuantized is set, positions and directions are on a coarse grid, which creates axis aligned triangles,
+//rays parallel to triangles, hits on triangle edges and on the cell border, where rounding differences would show
+TestCell createTestCell(const uint32_t triangleCount, const bool isQuantized, std::mt19937* randomEngine) {
+    std::uniform_real_distribution<float> distribution(-1.5f, 1.5f);
+    const auto randomPosition = [&]() {
+        const glm::vec3 p = glm::vec3(distribution(*randomEngine), distribution(*randomEngine), distribution(*randomEngine));
+        return isQuantized ? glm::round(p * 4.f) / 4.f : p;
+    };
+
+    TestCell cell;
+    for (uint32_t i = 0; i < triangleCount; i++) {
+        TriangleInfo triangle;
+        triangle.v0 = randomPosition();
+        triangle.v1 = randomPosition();
+        triangle.v2 = randomPosition();
+        //like the baker, clockwise triangles face outwards
+        const glm::vec3 N = cross(triangle.v0 - triangle.v2, triangle.v0 - triangle.v1);
+        if (dot(N, N) == 0.f) {
+            i--;
+            continue;
+        }
+        triangle.N = glm::normalize(N);
+        cell.triangles.push_back(triangle);
+        addTriangleToPacketList(triangle.v0, triangle.v1, triangle.v2, triangle.N, &cell.packetList);
+    }
+    //array order is shuffled, as grid cells reference triangles in mesh order, which differs from cell to cell
+    std::vector<uint32_t> arrayOrder(triangleCount);
+    for (uint32_t i = 0; i < triangleCount; i++) {
+        arrayOrder[i] = i;
+    }
+    std::shuffle(arrayOrder.begin(), arrayOrder.end(), *randomEngine);
+    cell.triangleIndices.resize(triangleCount);
+    for (uint32_t arrayIndex = 0; arrayIndex < triangleCount; arrayIndex++) {
+        const TriangleInfo& triangle = cell.triangles[arrayOrder[arrayIndex]];
+        addTriangleToArray(triangle.v0, triangle.v1, triangle.v2, triangle.N, &cell.triangleArray);
+        cell.triangleIndices[arrayOrder[arrayIndex]] = arrayIndex;
+    }
+    return cell;
+}
+
+TestRay createTestRay(const bool isQuantized, std::mt19937* randomEngine) {
+    std::uniform_real_distribution<float> originDistribution(-2.f, 2.f);
+    std::normal_distribution<float> directionDistribution;
+    TestRay ray;
+    ray.origin = glm::vec3(originDistribution(*randomEngine), originDistribution(*randomEngine),
+        originDistribution(*randomEngine));
+    if (isQuantized) {
+        ray.origin = glm::round(ray.origin * 4.f) / 4.f;
+    }
+    glm::vec3 direction;
+    do {
+        direction = glm::vec3(directionDistribution(*randomEngine), directionDistribution(*randomEngine),
+            directionDistribution(*randomEngine));
+        if (isQuantized) {
+            direction = glm::round(direction);
+        }
+    } while (dot(direction, direction) == 0.f);
+    ray.direction = glm::normalize(direction);
+    return ray;
+}
+
+//every cell is tested with several rays, the triangle count per cell varies up to several packets
+std::vector<ValidationResult> validatePacketKernel(const size_t cellCount, const size_t raysPerCell) {
+    const glm::vec3 cellMin = glm::vec3(-1.f);
+    const glm::vec3 cellMax = glm::vec3(1.f);
+    const uint32_t maxTrianglesPerCell = 4 * trianglePacketWidth + 3;
+
+    std::atomic<uint64_t> hitCount = 0;
+    std::atomic<uint64_t> packetListMismatchCount = 0;
+    std::atomic<uint64_t> gatheredMismatchCount = 0;
+    JobSystem::parallelFor(0, cellCount, 64,
+        [&](const size_t rangeBegin, const size_t rangeEnd, int) {
+        for (size_t cellIndex = rangeBegin; cellIndex < rangeEnd; cellIndex++) {
+            //seeded by cell, so results don't depend on the worker count
+            std::mt19937 randomEngine((uint32_t)cellIndex);
+            const bool isQuantized = cellIndex % 2 == 1;
+            const uint32_t triangleCount = 1 + uint32_t(cellIndex / 2 % maxTrianglesPerCell);
+            const TestCell cell = createTestCell(triangleCount, isQuantized, &randomEngine);
+
+            for (size_t i = 0; i < raysPerCell; i++) {
+                const TestRay ray = createTestRay(isQuantized, &randomEngine);
+                const CellHit reference = intersectCellScalar(cell.triangles, ray, cellMin, cellMax);
+                hitCount += reference.hitTriangle ? 1 : 0;
+                if (!areHitsIdentical(reference, intersectCellPacketList(cell, ray, cellMin, cellMax))) {
+                    packetListMismatchCount++;
+                }
+                if (!areHitsIdentical(reference, intersectCellGathered(cell, ray, cellMin, cellMax))) {
+                    gatheredMismatchCount++;
+                }
+            }
+        }
+    });
+
+    std::vector<ValidationResult> results(2);
+    results[0].name = "Packet list";
+    results[0].mismatchCount = packetListMismatchCount;
+    results[1].name = "Gathered packets";
+    results[1].mismatchCount = gatheredMismatchCount;
+    for (ValidationResult& result : results) {
+        result.testedCount = cellCount * raysPerCell;
+        result.hitCount = hitCount;
+    }
+    return results;
+}
+
+//single threaded, same cells and rays for every kernel
+ThroughputResult measureThroughput(const uint32_t trianglesPerCell, const size_t cellCount, const size_t raysPerCell,
+    const int repetitionCount) {
+
+    const glm::vec3 cellMin = glm::vec3(-1.f);
+    const glm::vec3 cellMax = glm::vec3(1.f);
+    std::mt19937 randomEngine(12345);
+    std::vector<TestCell> cells;
+    std::vector<TestRay> rays;
+    for (size_t i = 0; i < cellCount; i++) {
+        cells.push_back(createTestCell(trianglesPerCell, false, &randomEngine));
+    }
+    for (size_t i = 0; i < raysPerCell; i++) {
+        rays.push_back(createTestRay(false, &randomEngine));
+    }
+
+    //hit count is used, so the intersection is not optimized away
+    size_t hitCount = 0;
+    ThroughputResult result;
+    result.trianglesPerCell = trianglesPerCell;
+    result.rayCount = cellCount * raysPerCell;
+    result.scalarTime = measureFastest(repetitionCount, [&]() {
+        for (const TestCell& cell : cells) {
+            for (const TestRay& ray : rays) {
+                hitCount += intersectCellScalar(cell.triangles, ray, cellMin, cellMax).hitTriangle ? 1 : 0;
+            }
+        }
+    });
+    result.packetListTime = measureFastest(repetitionCount, [&]() {
+        for (const TestCell& cell : cells) {
+            for (const TestRay& ray : rays) {
+                hitCount += intersectCellPacketList(cell, ray, cellMin, cellMax).hitTriangle ? 1 : 0;
+            }
+        }
+    });
+    result.gatheredPacketTime = measureFastest(repetitionCount, [&]() {
+        for (const TestCell& cell : cells) {
+            for (const TestRay& ray : rays) {
+                hitCount += intersectCellGathered(cell, ray, cellMin, cellMax).hitTriangle ? 1 : 0;
+            }
+        }
+    });
+    if (hitCount == 0) {
+        std::cout << "No ray hit a triangle, throughput is not representative\n";
+    }
+    return result;
+}
+
+void printValidationResult(const ValidationResult& result) {
+    std::cout << result.name << ": " << result.testedCount << " rays tested, " << result.hitCount << " hits, ";
+    if (result.mismatchCount == 0) {
+        std::cout << "closest hits are bit identical to scalar\n";
+    }
+    else {
+        std::cout << result.mismatchCount << " MISMATCHES\n";
+    }
+}
+
+void printThroughputResult(const ThroughputResult& result) {
+    std::cout << result.trianglesPerCell << " triangles per cell (" << result.rayCount << " rays): scalar "
+        << result.rayCount / result.scalarTime / 1000000.0 << "M rays/s, packet list "
+        << result.rayCount / result.packetListTime / 1000000.0 << "M rays/s, gathered packets "
+        << result.rayCount / result.gatheredPacketTime / 1000000.0 << "M rays/s, speedup "
+        << result.scalarTime / result.packetListTime << "x/" << result.scalarTime / result.gatheredPacketTime << "x\n";
+}
+
+JsonObject toJsonObject(const ValidationResult& result) {
+    JsonObject object;
+    object.addString("name", result.name);
+    object.addInteger("testedCount", result.testedCount);
+    object.addInteger("hitCount", result.hitCount);
+    object.addInteger("mismatchCount", result.mismatchCount);
+    return object;
+}
+
+JsonObject toJsonObject(const ThroughputResult& result) {
+    JsonObject object;
+    object.addInteger("trianglesPerCell", result.trianglesPerCell);
+    object.addInteger("rayCount", result.rayCount);
+    object.addNumber("scalarRaysPerSecond", result.rayCount / result.scalarTime);
+    object.addNumber("packetListRaysPerSecond", result.rayCount / result.packetListTime);
+    object.addNumber("gatheredPacketRaysPerSecond", result.rayCount / result.gatheredPacketTime);
+    return object;
+}
+
+int main(const int argc, char* argv[]) {
+
+    //expected command line arguments:
+    //argv[0] = executablePath
+    //argv[1] = worker count, optional, uses one worker per hardware thread if not set
+    //argv[2] = json result file path, optional, results are only printed if not set
+    const BenchmarkSettings settings = parseBenchmarkArguments(argc, argv);
+    JobSystem::JobSystemConfig jobSystemConfig;
+    jobSystemConfig.workerCount = (unsigned int)std::max(settings.workerCount, 0);
+    JobSystem::initJobSystem(jobSystemConfig);
+
+#if defined(__AVX2__)
+    const std::string instructionSet = "AVX2";
+#elif defined(__SSE__) || defined(_M_X64)
+    const std::string instructionSet = "SSE";
+#else
+    const std::string instructionSet = "scalar";
+#endif
+    std::cout << "Validating " << instructionSet << " triangle packets with " << JobSystem::getWorkerCount() << " workers\n";
+    const size_t validationCellCount = 1 << 14;
+    const size_t validationRaysPerCell = 256;
+    const std::vector<ValidationResult> validationResults = validatePacketKernel(validationCellCount, validationRaysPerCell);
+    for (const ValidationResult& result : validationResults) {
+        printValidationResult(result);
+    }
+
+    //occupancies of typical uniform grid cells and BVH leaves
+    const std::array<uint32_t, 4> trianglesPerCell = { 4, 8, 16, 32 };
+    const size_t throughputRayCount = 1 << 20;
+    const size_t throughputCellCount = 256;
+    const int repetitionCount = 5;
+    std::vector<ThroughputResult> throughputResults;
+    for (const uint32_t triangleCount : trianglesPerCell) {
+        throughputResults.push_back(measureThroughput(triangleCount, throughputCellCount,
+            throughputRayCount / throughputCellCount, repetitionCount));
+        printThroughputResult(throughputResults.back());
+    }
+
+    JsonArray validationArray = { "validation", {} };
+    for (const ValidationResult& result : validationResults) {
+        validationArray.objects.push_back(toJsonObject(result));
+    }
+    JsonArray throughputArray = { "throughput", {} };
+    for (const ThroughputResult& result : throughputResults) {
+        throughputArray.objects.push_back(toJsonObject(result));
+    }
+    saveBenchmarkResults(settings.resultFilePath, JsonObject(), { validationArray, throughputArray });
+    JobSystem::shutdownJobSystem();
+    return 0;
+}
@@ -1,6 +1,25 @@
 #include "pch.h"
 #include "CompressedTypes.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define COMPRESSED_TYPES_SSE
+#include <emmintrin.h>
+#endif
+
+// ---- private function declarations ----
+
+#if defined(COMPRESSED_TYPES_SSE)
+//result is in the lower 16 bits of each lane
+__m128i floatsToHalfSSE(const __m128 values);
+
+//each component is in the lower 10 bits of each lane
+__m128i floatsToNormalized10BitSSE(const __m128 values);
+
+__m128i selectSSE(const __m128i mask, const __m128i a, const __m128i b);
+#endif
+
+// ---- implementation ----
+
 NormalizedUInt16 floatToNormalizedUInt16(const float f) {
     const float fClamped = glm::clamp(f, 0.f, 1.f);
     NormalizedUInt16 result;
@@ -40,4 +59,108 @@ NormalizedR10G10B10A2 vec3ToNormalizedR10B10G10A2(const glm::vec3& v) {
         result.value |= bits << ((2-i) * 10);
     }
     return result;
-}
\ No newline at end of file
+}
+
+void floatsToHalf(const std::span<const float> values, const std::span<uint16_t> outHalfs) {
+    assert(values.size() == outHalfs.size());
+    size_t i = 0;
+#if defined(COMPRESSED_TYPES_SSE)
+    for (; i + 8 <= values.size(); i += 8) {
+        const __m128i low  = floatsToHalfSSE(_mm_loadu_ps(&values[i]));
+        const __m128i high = floatsToHalfSSE(_mm_loadu_ps(&values[i + 4]));
+        //sign extend, so the signed saturation of the pack keeps all 16 bits
+        const __m128i lowExtended  = _mm_srai_epi32(_mm_slli_epi32(low, 16), 16);
+        const __m128i highExtended = _mm_srai_epi32(_mm_slli_epi32(high, 16), 16);
+        _mm_storeu_si128((__m128i*)&outHalfs[i], _mm_packs_epi32(lowExtended, highExtended));
+    }
+#endif
+    for (; i < values.size(); i++) {
+        outHalfs[i] = glm::packHalf1x16(values[i]);
+    }
+}
+
+void vec3sToNormalizedR10B10G10A2(const std::span<const glm::vec3> vectors, const std::span<NormalizedR10G10B10A2> outPacked) {
+    assert(vectors.size() == outPacked.size());
+    static_assert(sizeof(glm::vec3) == 3 * sizeof(float));
+    static_assert(sizeof(NormalizedR10G10B10A2) == sizeof(uint32_t));
+    size_t i = 0;
+#if defined(COMPRESSED_TYPES_SSE)
+    for (; i + 4 <= vectors.size(); i += 4) {
+        //four vectors are three registers: x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3
+        const float* source = &vectors[i].x;
+        const __m128 a = _mm_loadu_ps(source);
+        const __m128 b = _mm_loadu_ps(source + 4);
+        const __m128 c = _mm_loadu_ps(source + 8);
+
+        const __m128 bcX = _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2));
+        const __m128 x = _mm_shuffle_ps(a, bcX, _MM_SHUFFLE(2, 0, 3, 0));
+
+        const __m128 abY = _mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1));
+        const __m128 bcY = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3));
+        const __m128 y = _mm_shuffle_ps(abY, bcY, _MM_SHUFFLE(2, 0, 2, 0));
+
+        const __m128 abZ = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2));
+        const __m128 ccZ = _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0));
+        const __m128 z = _mm_shuffle_ps(abZ, ccZ, _MM_SHUFFLE(2, 0, 2, 0));
+
+        const __m128i packed = _mm_or_si128(
+            _mm_or_si128(
+                _mm_slli_epi32(floatsToNormalized10BitSSE(x), 20),
+                _mm_slli_epi32(floatsToNormalized10BitSSE(y), 10)),
+            floatsToNormalized10BitSSE(z));
+        _mm_storeu_si128((__m128i*)&outPacked[i], packed);
+    }
+#endif
+    for (; i < vectors.size(); i++) {
+        outPacked[i] = vec3ToNormalizedR10B10G10A2(vectors[i]);
+    }
+}
+
+#if defined(COMPRESSED_TYPES_SSE)
+__m128i floatsToHalfSSE(const __m128 values) {
+    const __m128i bits = _mm_castps_si128(values);
+    const __m128i sign = _mm_and_si128(_mm_srli_epi32(bits, 16), _mm_set1_epi32(0x8000));
+    const __m128i absBits = _mm_and_si128(bits, _mm_set1_epi32(0x7fffffff));
+
+    //normal: adding half of the dropped mantissa rounds ties up, a mantissa overflow carries into the exponent
+    const __m128i rounded = _mm_add_epi32(absBits, _mm_set1_epi32(0x1000));
+    const __m128i normal = _mm_srli_epi32(_mm_sub_epi32(rounded, _mm_set1_epi32((127 - 15) << 23)), 13);
+    const __m128i isNormal = _mm_cmpgt_epi32(absBits, _mm_set1_epi32(((127 - 15 + 1) << 23) - 1));
+    const __m128i isOverflow = _mm_cmpgt_epi32(rounded, _mm_set1_epi32(((127 + 16) << 23) - 1));
+
+    //denormal: value in units of the smallest half denormal, rounded up at 0.5
+    //scaling by a power of two and splitting into integer and fraction are exact, so there is no double rounding
+    const __m128 scaled = _mm_mul_ps(_mm_castsi128_ps(absBits), _mm_set1_ps(16777216.f)); //2^24
+    const __m128i truncated = _mm_cvttps_epi32(scaled);
+    const __m128 fraction = _mm_sub_ps(scaled, _mm_cvtepi32_ps(truncated));
+    const __m128i roundUp = _mm_castps_si128(_mm_cmpge_ps(fraction, _mm_set1_ps(0.5f)));
+    const __m128i denormal = _mm_sub_epi32(truncated, roundUp);  //mask is -1 where rounding up
+
+    //infinity keeps a zero mantissa, NaN keeps the upper mantissa bits and at least one set bit
+    const __m128i isInfOrNaN = _mm_cmpgt_epi32(absBits, _mm_set1_epi32(0x7f7fffff));
+    const __m128i isNaN = _mm_cmpgt_epi32(absBits, _mm_set1_epi32(0x7f800000));
+    const __m128i nanMantissa = _mm_srli_epi32(_mm_and_si128(absBits, _mm_set1_epi32(0x007fffff)), 13);
+    const __m128i nanMantissaIsZero = _mm_cmpeq_epi32(nanMantissa, _mm_setzero_si128());
+    const __m128i nanMinimumBit = _mm_and_si128(_mm_and_si128(isNaN, nanMantissaIsZero), _mm_set1_epi32(1));
+    const __m128i infinity = _mm_set1_epi32(0x7c00);
+    const __m128i infOrNaN = _mm_or_si128(_mm_or_si128(infinity, nanMantissa), nanMinimumBit);
+
+    __m128i result = selectSSE(isNormal, normal, denormal);
+    result = selectSSE(isOverflow, infinity, result);
+    result = selectSSE(isInfOrNaN, infOrNaN, result);
+    return _mm_or_si128(result, sign);
+}
+
+__m128i floatsToNormalized10BitSSE(const __m128 values) {
+    //same operations and order as vec3ToNormalizedR10B10G10A2, so results are identical
+    //min and max return the second operand if one is NaN, so NaN is passed on like by glm::clamp
+    const __m128 clamped = _mm_min_ps(_mm_set1_ps(1.f), _mm_max_ps(_mm_set1_ps(-1.f), values));
+    const __m128 remapped = _mm_add_ps(_mm_mul_ps(clamped, _mm_set1_ps(0.5f)), _mm_set1_ps(0.5f));
+    const __m128 scaled = _mm_add_ps(_mm_mul_ps(remapped, _mm_set1_ps(1021.f)), _mm_set1_ps(-510.f));
+    return _mm_and_si128(_mm_cvttps_epi32(scaled), _mm_set1_epi32(1023));
+}
+
+__m128i selectSSE(const __m128i mask, const __m128i a, const __m128i b) {
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+#endif
\ No newline at end of file
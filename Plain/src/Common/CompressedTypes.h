@@ -1,5 +1,6 @@
 #pragma once
 #include "pch.h"
+#include <span>
 
 //compressed types use structs for additional type safety
 
@@ -25,4 +26,14 @@ NormalizedInt16 floatToNormalizedInt16(const float f);
 
 //convert a float in range [-1, 1] to normalized format
 //corresponds to VK_FORMAT_A2R10G10B10_SNORM_PACK32
-NormalizedR10G10B10A2 vec3ToNormalizedR10B10G10A2(const glm::vec3& v);
\ No newline at end of file
+NormalizedR10G10B10A2 vec3ToNormalizedR10B10G10A2(const glm::vec3& v);
+
+//batch conversions produce the same bits as the single value versions, but convert four values at once using SSE2
+//input and output spans must have the same size
+
+//same result as glm::packHalf, which rounds ties away from zero
+//F16C hardware conversion rounds ties to even, so the conversion is done with integer operations instead
+void floatsToHalf(const std::span<const float> values, const std::span<uint16_t> outHalfs);
+
+//same result as vec3ToNormalizedR10B10G10A2
+void vec3sToNormalizedR10B10G10A2(const std::span<const glm::vec3> vectors, const std::span<NormalizedR10G10B10A2> outPacked);
\ No newline at end of file
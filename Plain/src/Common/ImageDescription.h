@@ -13,7 +13,7 @@ enum class ImageUsageFlags : uint32_t {
 ImageUsageFlags operator&(const ImageUsageFlags l, const ImageUsageFlags r);
 ImageUsageFlags operator|(const ImageUsageFlags l, const ImageUsageFlags r);
 
-enum class ImageFormat { R8, RG8, RGBA8, R16_sFloat, RG16_sFloat, RG32_sFloat, RG16_sNorm, RGBA16_sFloat, RGBA16_sNorm, RGBA32_sFloat, R11G11B10_uFloat, Depth16, Depth32, BC1, BC3, BC5, BGRA8_uNorm };
+enum class ImageFormat { R8, R8_sNorm, RG8, RGBA8, R16_sFloat, RG16_sFloat, RG32_sFloat, RG16_sNorm, RGBA16_sFloat, RGBA16_sNorm, RGBA32_sFloat, R11G11B10_uFloat, Depth16, Depth32, BC1, BC3, BC4_sNorm, BC5, BGRA8_uNorm };
 
 struct ImageDescription {
     uint32_t width = 1;
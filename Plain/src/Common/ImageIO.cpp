@@ -397,6 +397,15 @@ bool loadDDSFile(const std::filesystem::path& filename, ImageDescription* outDes
         if (headerDX10.dxgiFormat == DXGI_FORMAT_R16_FLOAT) {
             outDescription->format = ImageFormat::R16_sFloat;
         }
+        else if (headerDX10.dxgiFormat == DXGI_FORMAT_R16G16B16A16_FLOAT) {
+            outDescription->format = ImageFormat::RGBA16_sFloat;
+        }
+        else if (headerDX10.dxgiFormat == DXGI_FORMAT_R8_SNORM) {
+            outDescription->format = ImageFormat::R8_sNorm;
+        }
+        else if (headerDX10.dxgiFormat == DXGI_FORMAT_BC4_SNORM) {
+            outDescription->format = ImageFormat::BC4_sNorm;
+        }
         else {
             std::cout << "DDS unsupported texture format: " << filename << std::endl;
             return false;
@@ -533,6 +542,15 @@ void writeDDSFile(const std::filesystem::path& pathAbsolute, const ImageDescript
     else if (imageDescription.format == ImageFormat::R16_sFloat) {
         headerDX10.dxgiFormat = DXGI_FORMAT_R16_FLOAT;
     }
+    else if (imageDescription.format == ImageFormat::RGBA16_sFloat) {
+        headerDX10.dxgiFormat = DXGI_FORMAT_R16G16B16A16_FLOAT;
+    }
+    else if (imageDescription.format == ImageFormat::R8_sNorm) {
+        headerDX10.dxgiFormat = DXGI_FORMAT_R8_SNORM;
+    }
+    else if (imageDescription.format == ImageFormat::BC4_sNorm) {
+        headerDX10.dxgiFormat = DXGI_FORMAT_BC4_SNORM;
+    }
     else {
         throw("unsupported format");
     }
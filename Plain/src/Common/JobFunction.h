@@ -0,0 +1,111 @@
+#pragma once
+#include "pch.h"
+
+#include <type_traits>
+#include <utility>
+#include <new>
+#include <cstddef>
+
+namespace JobSystem {
+
+    //type erased function called with workerIndex, replaces std::function for jobs
+    //the function is stored inline, so creating, moving and destroying never allocates
+    //captures must fit into storageSize bytes, capture large objects by reference or pointer instead
+    class JobFunction {
+    public:
+        static constexpr size_t storageSize = 64;
+
+        JobFunction() = default;
+
+        template<typename Function,
+            typename = std::enable_if_t<!std::is_same_v<std::decay_t<Function>, JobFunction>>>
+        JobFunction(Function&& function) {
+            using StoredFunction = std::decay_t<Function>;
+            static_assert(sizeof(StoredFunction) <= storageSize,
+                "job function captures exceed inline storage, capture by reference or pointer instead");
+            static_assert(alignof(StoredFunction) <= alignof(std::max_align_t),
+                "job function alignment exceeds inline storage alignment");
+            static_assert(std::is_invocable_v<StoredFunction&, int>,
+                "job function must be callable with workerIndex");
+
+            new (m_storage) StoredFunction(std::forward<Function>(function));
+            m_invoke = &invokeStored<StoredFunction>;
+            m_moveAndDestroy = &moveAndDestroyStored<StoredFunction>;
+            m_destroy = &destroyStored<StoredFunction>;
+        }
+
+        JobFunction(JobFunction&& other) noexcept {
+            moveFrom(other);
+        }
+
+        JobFunction& operator=(JobFunction&& other) noexcept {
+            if (this != &other) {
+                reset();
+                moveFrom(other);
+            }
+            return *this;
+        }
+
+        JobFunction(const JobFunction&) = delete;
+        JobFunction& operator=(const JobFunction&) = delete;
+
+        ~JobFunction() {
+            reset();
+        }
+
+        void operator()(const int workerIndex) {
+            assert(m_invoke != nullptr);
+            m_invoke(m_storage, workerIndex);
+        }
+
+        //destroys stored function, afterwards isEmpty returns true
+        void reset() {
+            if (m_destroy != nullptr) {
+                m_destroy(m_storage);
+            }
+            m_invoke = nullptr;
+            m_moveAndDestroy = nullptr;
+            m_destroy = nullptr;
+        }
+
+        bool isEmpty() const {
+            return m_invoke == nullptr;
+        }
+
+    private:
+        template<typename StoredFunction>
+        static void invokeStored(void* storage, const int workerIndex) {
+            (*static_cast<StoredFunction*>(storage))(workerIndex);
+        }
+
+        template<typename StoredFunction>
+        static void moveAndDestroyStored(void* destination, void* source) {
+            StoredFunction* sourceFunction = static_cast<StoredFunction*>(source);
+            new (destination) StoredFunction(std::move(*sourceFunction));
+            sourceFunction->~StoredFunction();
+        }
+
+        template<typename StoredFunction>
+        static void destroyStored(void* storage) {
+            static_cast<StoredFunction*>(storage)->~StoredFunction();
+        }
+
+        //leaves other empty
+        void moveFrom(JobFunction& other) {
+            if (other.m_moveAndDestroy != nullptr) {
+                other.m_moveAndDestroy(m_storage, other.m_storage);
+            }
+            m_invoke = other.m_invoke;
+            m_moveAndDestroy = other.m_moveAndDestroy;
+            m_destroy = other.m_destroy;
+            other.m_invoke = nullptr;
+            other.m_moveAndDestroy = nullptr;
+            other.m_destroy = nullptr;
+        }
+
+        alignas(std::max_align_t) unsigned char m_storage[storageSize];
+        void (*m_invoke)(void* storage, const int workerIndex) = nullptr;
+        void (*m_moveAndDestroy)(void* destination, void* source) = nullptr;
+        void (*m_destroy)(void* storage) = nullptr;
+    };
+}
\ No newline at end of file
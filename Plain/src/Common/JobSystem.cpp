@@ -3,88 +3,821 @@
 
 #include <thread>
 #include <functional>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <iomanip>
 
-#include "FunctionRingbufferThreadsafe.h"
+#include "WorkStealingQueue.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <cstdio>
+#endif
 
 namespace JobSystem {
 
-    unsigned int g_threadCount;
+    struct JobPool;
+
+    struct Job {
+        JobFunction function;
+        Counter* counter = nullptr;
+        const char* label = nullptr;
+        JobPool* pool = nullptr;    //pool the job is returned to after running
+        Job* nextFree = nullptr;    //only used while job is in a free list
+    };
+
+    //jobs are allocated in blocks and reused
+    //only the owning thread allocates from a pool, but jobs can be run and freed by any worker
+    struct JobPool {
+        Job* freeList = nullptr;                    //only accessed by owning thread
+        std::atomic<Job*> returnedList = nullptr;   //jobs freed by other threads, taken as a whole by owning thread
+        std::vector<std::unique_ptr<Job[]>> blocks;
+    };
+
+    const size_t jobPoolBlockSize = 1024;
+
+    //pools are kept alive until program exit, as jobs may still be running when the owning thread exits
+    std::mutex g_jobPoolMutex;
+    std::vector<std::unique_ptr<JobPool>> g_jobPools;
+    thread_local JobPool* t_jobPool = nullptr;
+
+    unsigned int g_threadCount = 0;
+    std::vector<std::thread> g_workers;
+    std::atomic<bool> g_isShuttingDown = false;
+
+    //one queue per worker and priority, the last one belongs to the thread that called initJobSystem
+    //must not be resized after workers are started
+    const int64_t workerQueueInitialCapacity = 1024;
+    std::vector<std::unique_ptr<WorkStealingQueue>> g_workerQueues[jobPriorityCount];
+
+    //jobs added by threads that aren't workers
+    //ringbuffer that doubles its size when full, so steady state submission doesn't allocate
+    struct SubmissionQueue {
+        std::mutex mutex;
+        std::vector<Job*> jobs;
+        size_t head = 0;
+        std::atomic<int> size = 0; //allows checking for jobs without locking
+    };
+    SubmissionQueue g_submissionQueues[jobPriorityCount];
+
+    //idle workers sleep until jobs are added
+    //workers waiting on a counter sleep until jobs are added or a counter reaches zero
+    //threads that aren't workers can't run jobs, so they sleep until a counter reaches zero
+    std::atomic<int> g_pendingJobCount = 0;
+    std::atomic<int> g_sleepingWorkerCount = 0;
+    std::atomic<int> g_sleepingNonWorkerCount = 0;
+    std::mutex g_sleepMutex;
+    std::condition_variable g_workerWakeUpCondition;
+    std::condition_variable g_nonWorkerWakeUpCondition;
+
+    //coroutines suspended on a counter, resumed as jobs once the counter reached zero
+    //counters can't hold the list themselves, as a counter must not be accessed after it reached zero
+    struct WaitingCoroutine {
+        Counter* counter;
+        CoroutineJob::Handle handle;
+    };
+    std::mutex g_waitingCoroutineMutex;
+    std::vector<WaitingCoroutine> g_waitingCoroutines;
+    std::atomic<int> g_waitingCoroutineCount = 0; //allows checking for waiting coroutines without locking
+
+    //events of one worker, only written by the owning thread
+    //oldest events are overwritten once the buffer is full
+    struct TraceEvent {
+        const char* label;
+        int64_t beginTime;  //nanoseconds since g_traceStartTime
+        int64_t endTime;
+    };
+    struct TraceBuffer {
+        int workerIndex = 0;
+        std::vector<TraceEvent> events;
+        std::atomic<uint64_t> writtenCount = 0; //total events written, index is writtenCount % events.size()
+    };
 
-    const size_t jobBufferSize = 64;
-    FunctionRingbufferThreadsafe jobRingbuffer(jobBufferSize);
+    const size_t traceBufferCapacity = 65536;
+
+    //buffers are kept alive until program exit, like job pools
+    std::atomic<bool> g_tracingEnabled = false;
+    std::chrono::steady_clock::time_point g_traceStartTime;
+    std::mutex g_traceBufferMutex;
+    std::vector<std::unique_ptr<TraceBuffer>> g_traceBuffers;
+    thread_local TraceBuffer* t_traceBuffer = nullptr;
+
+    //-1 if thread is not a worker
+    thread_local int t_workerIndex = -1;
+
+    //state of xorshift random number generator, used to select steal victims
+    thread_local uint32_t t_randomState = 1;
+
+    //number of unsuccessful search rounds before worker goes to sleep
+    const int searchRoundsBeforeSleep = 64;
 
     //---- private function declarations ----
 
+    void workerMain(const int workerIndex);
+
+    //hardware threads the process may run on, restricted to NUMA node if not negative
+    //falls back to all hardware threads if the query fails
+    std::vector<int> getAvailableHardwareThreads(const int numaNode);
+
+    //restricts thread to run on the given hardware threads, returns false if not supported or failed
+    bool setThreadAffinity(std::thread& thread, const std::vector<int>& hardwareThreads);
+
+    //takes job from pool of calling thread, creates pool on first use
+    Job* allocateJob();
+
+    //returns job to pool it was allocated from, can be called from any thread
+    void freeJob(Job* job);
+
+    void pushSubmissionQueue(SubmissionQueue& queue, Job* job);
+
+    //returns nullptr if no job could be found
+    //searches high priority jobs first, then low priority jobs
+    Job* findJob(const int workerIndex);
+
+    //searches own queue, then submission queue, then steals from other workers
+    Job* findJobWithPriority(const int workerIndex, const JobPriority priority);
+    Job* popSubmissionQueue(SubmissionQueue& queue);
+    Job* stealFromRandomWorker(const int workerIndex, const JobPriority priority);
+    uint32_t nextRandomNumber();
+
+    //sleeps until jobs are pending or job system is shutting down
+    void waitForJobs();
+
+    //sleeps until jobs are pending or counter reached zero
+    void waitForJobsOrCounter(const Counter& counter);
+
+    //sleeps until counter reached zero, for threads that aren't workers
+    void waitForCounter(const Counter& counter);
+
+    //wakes one sleeping worker, if any
+    void notifyJobAdded();
+
+    //wakes all sleeping threads, if any, as any of them could be waiting on the counter
+    void notifyCounterZero();
+
+    //adds all waiting coroutines whose counter is zero as jobs
+    void resumeWaitingCoroutines();
+
+    void resumeCoroutineAsJob(const CoroutineJob::Handle handle);
+
+    void runJob(Job* job, const int workerIndex);
+
+    //nanoseconds since g_traceStartTime
+    int64_t getTraceTime();
+
+    //writes into buffer of calling thread, creates buffer on first use
+    void recordTraceEvent(const char* label, const int64_t beginTime, const int64_t endTime, const int workerIndex);
+
+    //escapes quotes, backslashes and control characters
+    void writeJSONString(std::ostream& stream, const char* string);
+
+    //adds upper halves of range as jobs until it is at most grainSize, then executes the remaining range
+    void parallelForRange(const size_t begin, const size_t end, const size_t grainSize,
+        const ParallelForFunction& function, const JobPriority priority, const char* label, Counter* counter,
+        const int workerIndex);
+
     //counter must not be nullptr
     void incrementCounter(Counter* counter);
 
     //counter must not be nullptr
-    //notifies counters zeroCondition if counter reaches zero
+    //wakes sleeping threads if counter reaches zero
     void decrementCounter(Counter* counter);
 
 
     //---- function implementations ----
 
-    void initJobSystem() {
+    void initJobSystem(const JobSystemConfig& config) {
+        assert(g_workers.empty());
+
+        const std::vector<int> hardwareThreads = getAvailableHardwareThreads(config.numaNode);
+        //at least one hardware thread is left for workers
+        const size_t reservedCount = std::min((size_t)config.reservedCoreCount, hardwareThreads.size() - 1);
+        const std::vector<int> workerHardwareThreads(hardwareThreads.begin() + reservedCount, hardwareThreads.end());
 
-        g_threadCount = std::thread::hardware_concurrency();
-        std::cout << "JobSystem thread count: " << g_threadCount << "\n\n";
+        g_threadCount = config.workerCount == 0 ? (unsigned int)workerHardwareThreads.size() : config.workerCount;
+        std::cout << "JobSystem thread count: " << g_threadCount << "\n";
+        std::cout << "JobSystem available hardware threads: " << hardwareThreads.size()
+            << ", reserved: " << reservedCount << "\n\n";
+        g_traceStartTime = std::chrono::steady_clock::now();
+        g_isShuttingDown.store(false);
+
+        //additional queue for calling thread
+        const unsigned int queueCount = g_threadCount + 1;
+        for (std::vector<std::unique_ptr<WorkStealingQueue>>& queues : g_workerQueues) {
+            queues.reserve(queueCount);
+            for (unsigned int workerIndex = 0; workerIndex < queueCount; workerIndex++) {
+                queues.push_back(std::make_unique<WorkStealingQueue>(workerQueueInitialCapacity));
+            }
+        }
+        t_workerIndex = (int)g_threadCount;
 
+        g_workers.reserve(g_threadCount);
         for (unsigned int workerIndex = 0; workerIndex < g_threadCount; workerIndex++) {
-            std::thread worker([workerIndex]() {
-                //function executed by worker
-                while (true) {
-                    std::function<void(int)> job = jobRingbuffer.popFront();
-                    job(workerIndex);
-                }
-            });
-            //let thread continue after worker goes out of scope
-            worker.detach();
+            g_workers.emplace_back(workerMain, (int)workerIndex);
+
+            std::vector<int> affinity;
+            if (workerIndex < config.workerAffinities.size() && config.workerAffinities[workerIndex] >= 0) {
+                affinity.push_back(config.workerAffinities[workerIndex]);
+            }
+            else if (config.pinWorkers) {
+                affinity.push_back(workerHardwareThreads[workerIndex % workerHardwareThreads.size()]);
+            }
+            else if (reservedCount > 0 || config.numaNode >= 0) {
+                affinity = workerHardwareThreads;
+            }
+            if (!affinity.empty() && !setThreadAffinity(g_workers.back(), affinity)) {
+                std::cout << "JobSystem failed to set affinity of worker " << workerIndex << "\n";
+            }
+        }
+    }
+
+    void shutdownJobSystem() {
+        assert(t_workerIndex == (int)g_threadCount);
+        assert(g_pendingJobCount.load() == 0);
+        {
+            //set under lock, so a worker that is about to sleep sees it or is notified
+            std::unique_lock uniqueLock(g_sleepMutex);
+            g_isShuttingDown.store(true);
+            g_workerWakeUpCondition.notify_all();
         }
+        for (std::thread& worker : g_workers) {
+            worker.join();
+        }
+        g_workers.clear();
+        for (std::vector<std::unique_ptr<WorkStealingQueue>>& queues : g_workerQueues) {
+            queues.clear();
+        }
+        t_workerIndex = -1;
+        g_threadCount = 0;
     }
 
-    void addJob(const std::function<void(int workerIndex)> job, Counter* counter) {
+    void addJob(JobFunction&& job, Counter* counter, const JobPriority priority, const char* label) {
         if (counter != nullptr) {
             incrementCounter(counter);
+        }
 
-            //add lambda that first executes job, then decrements counter
-            jobRingbuffer.add([job, counter](int workerIndex) {
-                job(workerIndex);
-                decrementCounter(counter);
-            });
+        Job* queuedJob = allocateJob();
+        queuedJob->function = std::move(job);
+        queuedJob->counter = counter;
+        queuedJob->label = label;
+
+        const int priorityIndex = (int)priority;
+        if (t_workerIndex >= 0) {
+            g_workerQueues[priorityIndex][t_workerIndex]->push(queuedJob);
         }
         else {
-            jobRingbuffer.add(job);
+            pushSubmissionQueue(g_submissionQueues[priorityIndex], queuedJob);
         }
+        g_pendingJobCount.fetch_add(1);
+        notifyJobAdded();
     }
 
-    void waitOnCounter(Counter& counter) {
-        std::unique_lock uniqueLock(counter.mutex);
-        if (counter.counter == 0) {
-            //counter already zero, do nothing
+    void parallelFor(const size_t begin, const size_t end, const size_t grainSize, const ParallelForFunction& function,
+        const JobPriority priority, const char* label) {
+        if (begin >= end) {
+            return;
+        }
+        const size_t grainSizeValid = std::max(grainSize, (size_t)1);
+        Counter counter;
+        if (t_workerIndex >= 0) {
+            parallelForRange(begin, end, grainSizeValid, function, priority, label, &counter, t_workerIndex);
         }
         else {
-            //counter not zero, wait
-            counter.zeroCondition.wait(uniqueLock);
+            addJob([begin, end, grainSizeValid, &function, priority, label, &counter](int workerIndex) {
+                parallelForRange(begin, end, grainSizeValid, function, priority, label, &counter, workerIndex);
+            }, &counter, priority, label);
+        }
+        waitOnCounter(counter);
+    }
+
+    void parallelForRange(const size_t begin, const size_t end, const size_t grainSize,
+        const ParallelForFunction& function, const JobPriority priority, const char* label, Counter* counter,
+        const int workerIndex) {
+
+        size_t rangeEnd = end;
+        while (rangeEnd - begin > grainSize) {
+            const size_t middle = begin + (rangeEnd - begin) / 2;
+            addJob([middle, rangeEnd, grainSize, &function, priority, label, counter](int jobWorkerIndex) {
+                parallelForRange(middle, rangeEnd, grainSize, function, priority, label, counter, jobWorkerIndex);
+            }, counter, priority, label);
+            rangeEnd = middle;
+        }
+        function(begin, rangeEnd, workerIndex);
+    }
+
+    void waitOnCounter(Counter& counter) {
+        const int workerIndex = t_workerIndex;
+        if (workerIndex < 0) {
+            //can't run jobs, just sleep
+            waitForCounter(counter);
+            return;
+        }
+        while (counter.counter.load(std::memory_order_acquire) != 0) {
+            //help instead of idling
+            Job* job = nullptr;
+            for (int round = 0; round < searchRoundsBeforeSleep && job == nullptr; round++) {
+                if (counter.counter.load(std::memory_order_acquire) == 0) {
+                    break;
+                }
+                job = findJob(workerIndex);
+                if (job == nullptr) {
+                    std::this_thread::yield();
+                }
+            }
+            if (job != nullptr) {
+                runJob(job, workerIndex);
+            }
+            else if (counter.counter.load(std::memory_order_acquire) != 0) {
+                waitForJobsOrCounter(counter);
+            }
+        }
+        //a job added notification may have woken this thread instead of an idle worker
+        //pass it on, so the job isn't left pending while workers sleep
+        if (g_pendingJobCount.load() > 0) {
+            notifyJobAdded();
         }
     }
 
     int getWorkerCount() {
-        return g_threadCount;
+        return (int)g_workerQueues[0].size();
+    }
+
+    void addCoroutineJob(CoroutineJob&& job, Counter* counter, const JobPriority priority, const char* label) {
+        const CoroutineJob::Handle handle = job.m_handle;
+        assert(handle);
+        job.m_handle = nullptr;
+
+        handle.promise().counter = counter;
+        handle.promise().priority = priority;
+        handle.promise().label = label;
+        if (counter != nullptr) {
+            incrementCounter(counter);
+        }
+        resumeCoroutineAsJob(handle);
+    }
+
+    bool CoroutineJob::CounterAwaiter::await_ready() const noexcept {
+        return counter.counter.load(std::memory_order_acquire) == 0;
+    }
+
+    bool CoroutineJob::CounterAwaiter::await_suspend(const Handle handle) noexcept {
+        std::unique_lock uniqueLock(g_waitingCoroutineMutex);
+        //waiting count is incremented before checking the counter, a decrement to zero either sees the count or is seen here
+        g_waitingCoroutineCount.fetch_add(1);
+        if (counter.counter.load() == 0) {
+            g_waitingCoroutineCount.fetch_sub(1);
+            return false;
+        }
+        WaitingCoroutine waiting;
+        waiting.counter = &counter;
+        waiting.handle = handle;
+        g_waitingCoroutines.push_back(waiting);
+        //coroutine may be resumed by another thread as soon as the lock is released, so the frame must not be accessed anymore
+        return true;
+    }
+
+    void CoroutineJob::FinalAwaiter::await_suspend(const Handle handle) noexcept {
+        Counter* counter = handle.promise().counter;
+        //destroyed first, as a thread waiting on the counter may free what the coroutine references
+        handle.destroy();
+        if (counter != nullptr) {
+            decrementCounter(counter);
+        }
+    }
+
+    void workerMain(const int workerIndex) {
+        t_workerIndex = workerIndex;
+        t_randomState = workerIndex + 1; //xorshift state must not be zero
+
+        while (!g_isShuttingDown.load()) {
+            Job* job = nullptr;
+            for (int round = 0; round < searchRoundsBeforeSleep && job == nullptr; round++) {
+                job = findJob(workerIndex);
+                if (job == nullptr) {
+                    std::this_thread::yield();
+                }
+            }
+            if (job == nullptr) {
+                waitForJobs();
+            }
+            else {
+                runJob(job, workerIndex);
+            }
+        }
+    }
+
+    std::vector<int> getAvailableHardwareThreads(const int numaNode) {
+        std::vector<int> hardwareThreads;
+#ifdef _WIN32
+        //only the first processor group is considered, so at most 64 hardware threads
+        DWORD_PTR mask = 0;
+        if (numaNode >= 0) {
+            GROUP_AFFINITY nodeAffinity;
+            if (GetNumaNodeProcessorMaskEx((USHORT)numaNode, &nodeAffinity) && nodeAffinity.Group == 0) {
+                mask = nodeAffinity.Mask;
+            }
+        }
+        else {
+            DWORD_PTR systemMask = 0;
+            if (!GetProcessAffinityMask(GetCurrentProcess(), &mask, &systemMask)) {
+                mask = 0;
+            }
+        }
+        for (int i = 0; i < (int)sizeof(mask) * 8; i++) {
+            if (mask & ((DWORD_PTR)1 << i)) {
+                hardwareThreads.push_back(i);
+            }
+        }
+#else
+        if (numaNode >= 0) {
+            //list of ranges such as "0-3,8-11"
+            std::ifstream file("/sys/devices/system/node/node" + std::to_string(numaNode) + "/cpulist");
+            std::string range;
+            while (std::getline(file, range, ',')) {
+                int first = 0;
+                int last = 0;
+                const int parsedCount = std::sscanf(range.c_str(), "%d-%d", &first, &last);
+                if (parsedCount == 1) {
+                    last = first;
+                }
+                for (int i = first; parsedCount >= 1 && i <= last; i++) {
+                    hardwareThreads.push_back(i);
+                }
+            }
+        }
+        else {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+                for (int i = 0; i < CPU_SETSIZE; i++) {
+                    if (CPU_ISSET(i, &set)) {
+                        hardwareThreads.push_back(i);
+                    }
+                }
+            }
+        }
+#endif
+        if (hardwareThreads.empty()) {
+            std::cout << "JobSystem failed to query available hardware threads, using all\n";
+            const int hardwareThreadCount = std::max((int)std::thread::hardware_concurrency(), 1);
+            for (int i = 0; i < hardwareThreadCount; i++) {
+                hardwareThreads.push_back(i);
+            }
+        }
+        return hardwareThreads;
+    }
+
+    bool setThreadAffinity(std::thread& thread, const std::vector<int>& hardwareThreads) {
+#ifdef _WIN32
+        DWORD_PTR mask = 0;
+        for (const int hardwareThread : hardwareThreads) {
+            if (hardwareThread >= 0 && hardwareThread < (int)sizeof(mask) * 8) {
+                mask |= (DWORD_PTR)1 << hardwareThread;
+            }
+        }
+        return mask != 0 && SetThreadAffinityMask(thread.native_handle(), mask) != 0;
+#else
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (const int hardwareThread : hardwareThreads) {
+            if (hardwareThread >= 0 && hardwareThread < CPU_SETSIZE) {
+                CPU_SET(hardwareThread, &set);
+            }
+        }
+        return CPU_COUNT(&set) > 0 && pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set) == 0;
+#endif
+    }
+
+    Job* allocateJob() {
+        JobPool* pool = t_jobPool;
+        if (pool == nullptr) {
+            std::unique_lock uniqueLock(g_jobPoolMutex);
+            g_jobPools.push_back(std::make_unique<JobPool>());
+            pool = g_jobPools.back().get();
+            t_jobPool = pool;
+        }
+        if (pool->freeList == nullptr) {
+            //acquire makes writes of the freeing threads visible
+            pool->freeList = pool->returnedList.exchange(nullptr, std::memory_order_acquire);
+        }
+        if (pool->freeList == nullptr) {
+            //all jobs in flight, pool grows to the peak number of jobs in flight and then stops allocating
+            pool->blocks.push_back(std::make_unique<Job[]>(jobPoolBlockSize));
+            Job* block = pool->blocks.back().get();
+            for (size_t i = 0; i < jobPoolBlockSize; i++) {
+                block[i].pool = pool;
+                block[i].nextFree = i + 1 < jobPoolBlockSize ? &block[i + 1] : nullptr;
+            }
+            pool->freeList = block;
+        }
+        Job* job = pool->freeList;
+        pool->freeList = job->nextFree;
+        job->nextFree = nullptr;
+        return job;
+    }
+
+    void freeJob(Job* job) {
+        JobPool* pool = job->pool;
+        if (pool == t_jobPool) {
+            job->nextFree = pool->freeList;
+            pool->freeList = job;
+            return;
+        }
+        //push onto returned list, no ABA problem as the owning thread only ever takes the whole list
+        Job* head = pool->returnedList.load(std::memory_order_relaxed);
+        do {
+            job->nextFree = head;
+        } while (!pool->returnedList.compare_exchange_weak(head, job, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    void pushSubmissionQueue(SubmissionQueue& queue, Job* job) {
+        std::unique_lock uniqueLock(queue.mutex);
+        const size_t capacity = queue.jobs.size();
+        const size_t size = (size_t)queue.size.load(std::memory_order_relaxed);
+        if (size == capacity) {
+            //full, unwrap into a buffer of twice the size
+            std::vector<Job*> grown(std::max(capacity * 2, (size_t)workerQueueInitialCapacity));
+            for (size_t i = 0; i < size; i++) {
+                grown[i] = queue.jobs[(queue.head + i) % capacity];
+            }
+            queue.jobs.swap(grown);
+            queue.head = 0;
+        }
+        queue.jobs[(queue.head + size) % queue.jobs.size()] = job;
+        queue.size.fetch_add(1, std::memory_order_release);
+    }
+
+    Job* findJob(const int workerIndex) {
+        Job* job = findJobWithPriority(workerIndex, JobPriority::High);
+        if (job == nullptr) {
+            job = findJobWithPriority(workerIndex, JobPriority::Low);
+        }
+        if (job != nullptr) {
+            g_pendingJobCount.fetch_sub(1);
+        }
+        return job;
+    }
+
+    Job* findJobWithPriority(const int workerIndex, const JobPriority priority) {
+        const int priorityIndex = (int)priority;
+        Job* job = g_workerQueues[priorityIndex][workerIndex]->pop();
+        if (job == nullptr) {
+            job = popSubmissionQueue(g_submissionQueues[priorityIndex]);
+        }
+        if (job == nullptr) {
+            job = stealFromRandomWorker(workerIndex, priority);
+        }
+        return job;
+    }
+
+    Job* popSubmissionQueue(SubmissionQueue& queue) {
+        if (queue.size.load(std::memory_order_acquire) == 0) {
+            return nullptr;
+        }
+        std::unique_lock uniqueLock(queue.mutex);
+        if (queue.size.load(std::memory_order_relaxed) == 0) {
+            return nullptr;
+        }
+        Job* job = queue.jobs[queue.head];
+        queue.head = (queue.head + 1) % queue.jobs.size();
+        queue.size.fetch_sub(1, std::memory_order_relaxed);
+        return job;
+    }
+
+    Job* stealFromRandomWorker(const int workerIndex, const JobPriority priority) {
+        const std::vector<std::unique_ptr<WorkStealingQueue>>& queues = g_workerQueues[(int)priority];
+        //visit every other worker once, starting at a random one
+        const int queueCount = (int)queues.size();
+        const int otherWorkerCount = queueCount - 1;
+        if (otherWorkerCount <= 0) {
+            return nullptr;
+        }
+        const int startOffset = (int)(nextRandomNumber() % otherWorkerCount);
+        for (int i = 0; i < otherWorkerCount; i++) {
+            //offset in range [1, queueCount-1], so own queue is skipped
+            const int offset = 1 + (startOffset + i) % otherWorkerCount;
+            const int victimIndex = (workerIndex + offset) % queueCount;
+            Job* job = queues[victimIndex]->steal();
+            if (job != nullptr) {
+                return job;
+            }
+        }
+        return nullptr;
+    }
+
+    //reference: "Xorshift RNGs", Marsaglia
+    uint32_t nextRandomNumber() {
+        uint32_t x = t_randomState;
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        t_randomState = x;
+        return x;
+    }
+
+    void waitForJobs() {
+        std::unique_lock uniqueLock(g_sleepMutex);
+        g_sleepingWorkerCount.fetch_add(1);
+        //checked under lock, so a job added after the check will notify after the wait started
+        g_workerWakeUpCondition.wait(uniqueLock, []() {
+            return g_pendingJobCount.load() > 0 || g_isShuttingDown.load();
+        });
+        g_sleepingWorkerCount.fetch_sub(1);
+    }
+
+    void waitForJobsOrCounter(const Counter& counter) {
+        std::unique_lock uniqueLock(g_sleepMutex);
+        g_sleepingWorkerCount.fetch_add(1);
+        //checked under lock, so a job added or counter reaching zero after the check will notify after the wait started
+        g_workerWakeUpCondition.wait(uniqueLock, [&counter]() {
+            return g_pendingJobCount.load() > 0 || counter.counter.load() == 0;
+        });
+        g_sleepingWorkerCount.fetch_sub(1);
+    }
+
+    void waitForCounter(const Counter& counter) {
+        std::unique_lock uniqueLock(g_sleepMutex);
+        g_sleepingNonWorkerCount.fetch_add(1);
+        g_nonWorkerWakeUpCondition.wait(uniqueLock, [&counter]() {
+            return counter.counter.load() == 0;
+        });
+        g_sleepingNonWorkerCount.fetch_sub(1);
+    }
+
+    void notifyJobAdded() {
+        //pending count is incremented before, so a worker that is about to sleep will see the job
+        if (g_sleepingWorkerCount.load() > 0) {
+            std::unique_lock uniqueLock(g_sleepMutex);
+            g_workerWakeUpCondition.notify_one();
+        }
+    }
+
+    void notifyCounterZero() {
+        //counter is decremented before, so a thread that is about to sleep will see it
+        if (g_sleepingWorkerCount.load() > 0) {
+            std::unique_lock uniqueLock(g_sleepMutex);
+            g_workerWakeUpCondition.notify_all();
+        }
+        if (g_sleepingNonWorkerCount.load() > 0) {
+            std::unique_lock uniqueLock(g_sleepMutex);
+            g_nonWorkerWakeUpCondition.notify_all();
+        }
+    }
+
+    void resumeWaitingCoroutines() {
+        if (g_waitingCoroutineCount.load() == 0) {
+            return;
+        }
+        std::unique_lock uniqueLock(g_waitingCoroutineMutex);
+        size_t i = 0;
+        while (i < g_waitingCoroutines.size()) {
+            //counters of waiting coroutines are alive, so checking them is safe
+            const WaitingCoroutine waiting = g_waitingCoroutines[i];
+            if (waiting.counter->counter.load() == 0) {
+                g_waitingCoroutines[i] = g_waitingCoroutines.back();
+                g_waitingCoroutines.pop_back();
+                g_waitingCoroutineCount.fetch_sub(1);
+                resumeCoroutineAsJob(waiting.handle);
+            }
+            else {
+                i++;
+            }
+        }
+    }
+
+    void resumeCoroutineAsJob(const CoroutineJob::Handle handle) {
+        //coroutine counts itself until it finished, so the resuming job has no counter
+        addJob([handle](int) {
+            handle.resume();
+        }, nullptr, handle.promise().priority, handle.promise().label);
+    }
+
+    void runJob(Job* job, const int workerIndex) {
+        if (g_tracingEnabled.load(std::memory_order_relaxed)) {
+            const int64_t beginTime = getTraceTime();
+            job->function(workerIndex);
+            //recorded before the counter is decremented, so the event is visible to the waiting thread
+            recordTraceEvent(job->label, beginTime, getTraceTime(), workerIndex);
+        }
+        else {
+            job->function(workerIndex);
+        }
+        //captures are destroyed before the counter is decremented, as they may reference the waiting thread's stack
+        job->function.reset();
+        if (job->counter != nullptr) {
+            decrementCounter(job->counter);
+        }
+        freeJob(job);
+    }
+
+    int64_t getTraceTime() {
+        const std::chrono::nanoseconds time = std::chrono::steady_clock::now() - g_traceStartTime;
+        return time.count();
+    }
+
+    void recordTraceEvent(const char* label, const int64_t beginTime, const int64_t endTime, const int workerIndex) {
+        TraceBuffer* buffer = t_traceBuffer;
+        if (buffer == nullptr) {
+            std::unique_ptr<TraceBuffer> newBuffer = std::make_unique<TraceBuffer>();
+            newBuffer->workerIndex = workerIndex;
+            newBuffer->events.resize(traceBufferCapacity);
+            buffer = newBuffer.get();
+            t_traceBuffer = buffer;
+            std::unique_lock uniqueLock(g_traceBufferMutex);
+            g_traceBuffers.push_back(std::move(newBuffer));
+        }
+        const uint64_t writtenCount = buffer->writtenCount.load(std::memory_order_relaxed);
+        TraceEvent& event = buffer->events[writtenCount % buffer->events.size()];
+        event.label = label;
+        event.beginTime = beginTime;
+        event.endTime = endTime;
+        buffer->writtenCount.store(writtenCount + 1, std::memory_order_release);
+    }
+
+    void setTracingEnabled(const bool enabled) {
+        g_tracingEnabled.store(enabled);
+    }
+
+    bool isTracingEnabled() {
+        return g_tracingEnabled.load();
+    }
+
+    void clearTrace() {
+        std::unique_lock uniqueLock(g_traceBufferMutex);
+        for (const std::unique_ptr<TraceBuffer>& buffer : g_traceBuffers) {
+            buffer->writtenCount.store(0);
+        }
+    }
+
+    bool writeTraceFile(const std::filesystem::path& path) {
+        std::ofstream file(path);
+        if (!file.is_open()) {
+            std::cout << "Failed to open trace file: " << path << "\n";
+            return false;
+        }
+        //reference: "Trace Event Format", Google
+        //complete events (ph X) with timestamps in microseconds, one thread per worker
+        file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        bool isFirstEvent = true;
+        std::unique_lock uniqueLock(g_traceBufferMutex);
+        for (const std::unique_ptr<TraceBuffer>& buffer : g_traceBuffers) {
+            file << (isFirstEvent ? "" : ",\n");
+            isFirstEvent = false;
+            file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << buffer->workerIndex
+                << ",\"args\":{\"name\":\"Worker " << buffer->workerIndex << "\"}}";
+
+            const uint64_t writtenCount = buffer->writtenCount.load(std::memory_order_acquire);
+            const uint64_t capacity = buffer->events.size();
+            const uint64_t firstEvent = writtenCount > capacity ? writtenCount - capacity : 0;
+            for (uint64_t i = firstEvent; i < writtenCount; i++) {
+                const TraceEvent& event = buffer->events[i % capacity];
+                file << ",\n{\"name\":";
+                writeJSONString(file, event.label == nullptr ? "Job" : event.label);
+                file << ",\"ph\":\"X\",\"pid\":0,\"tid\":" << buffer->workerIndex
+                    << ",\"ts\":" << event.beginTime / 1000 << "." << std::setw(3) << std::setfill('0') << event.beginTime % 1000
+                    << ",\"dur\":" << (event.endTime - event.beginTime) / 1000 << "." << std::setw(3)
+                    << (event.endTime - event.beginTime) % 1000 << std::setfill(' ') << "}";
+            }
+        }
+        file << "\n]}\n";
+        return file.good();
+    }
+
+    void writeJSONString(std::ostream& stream, const char* string) {
+        stream << '"';
+        for (const char* c = string; *c != '\0'; c++) {
+            if (*c == '"' || *c == '\\') {
+                stream << '\\' << *c;
+            }
+            else if ((unsigned char)*c < 0x20) {
+                stream << "\\u" << std::hex << std::setw(4) << std::setfill('0') << (int)*c << std::dec << std::setfill(' ');
+            }
+            else {
+                stream << *c;
+            }
+        }
+        stream << '"';
     }
 
     void incrementCounter(Counter* counter) {
         assert(counter != nullptr);
-        std::unique_lock uniqueLock(counter->mutex);
-        counter->counter++;
+        counter->counter.fetch_add(1);
     }
 
     void decrementCounter(Counter* counter) {
         assert(counter != nullptr);
-        std::unique_lock uniqueLock(counter->mutex);
-        counter->counter--;
-        if (counter->counter == 0) {
-            counter->zeroCondition.notify_all();
+        //counter must not be accessed after decrementing, as waiting thread may destroy it once zero is seen
+        const int previous = counter->counter.fetch_sub(1);
+        assert(previous > 0);
+        if (previous == 1) {
+            notifyCounterZero();
+            resumeWaitingCoroutines();
         }
     }
 }
\ No newline at end of file
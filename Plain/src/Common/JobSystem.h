@@ -3,7 +3,10 @@
 
 #include <thread>
 #include <functional>
-#include <mutex>
+#include <atomic>
+#include <coroutine>
+
+#include "JobFunction.h"
 
 namespace JobSystem {
 
@@ -11,16 +14,147 @@ namespace JobSystem {
     //threads can wait on a counter reaching zero
     //this allows to wait until all jobs associated with a counter being completed
     struct Counter {
-        int counter = 0;    //could use atomic, but std::condition_variable requires mutex anyways
-        std::mutex mutex;
-        std::condition_variable zeroCondition;
+        std::atomic<int> counter = 0;
+    };
+
+    //high priority is meant for frame critical work, low priority for background work such as asset processing
+    //workers only run low priority jobs if no high priority job can be found
+    enum class JobPriority { High = 0, Low = 1 };
+    const int jobPriorityCount = 2;
+
+    struct JobSystemConfig {
+        //zero creates one worker per available hardware thread that isn't reserved
+        unsigned int workerCount = 0;
+        //hardware threads kept free for the calling thread, a render thread or other processes
+        //the first available hardware threads are reserved, workers are pinned to the following ones
+        unsigned int reservedCoreCount = 0;
+        //pins every worker to a single hardware thread, assigned round robin after the reserved ones
+        bool pinWorkers = false;
+        //hardware thread per worker index, overrides pinWorkers for the listed workers, negative values leave a worker unpinned
+        std::vector<int> workerAffinities;
+        //restricts available hardware threads to the ones of a NUMA node, negative value uses all hardware threads
+        //unpinned workers are restricted to the whole node
+        int numaNode = -1;
     };
 
-    void initJobSystem();
+    //the calling thread is registered as an additional worker, it runs jobs while waiting on counters
+    //affinities are applied where supported by the platform, failures are reported but not fatal
+    void initJobSystem(const JobSystemConfig& config = JobSystemConfig());
+
+    //stops and joins all workers, the calling thread is unregistered as worker
+    //must be called from the thread that called initJobSystem, while no jobs are pending or running
+    //initJobSystem may be called again afterwards
+    void shutdownJobSystem();
+
     //executes job
     //increments counter before starting and decrements counter after finishing
-    void addJob(const std::function<void(int workerIndex)> job, Counter* counter);
+    //jobs added by a worker are pushed onto its own queue, from which idle workers steal
+    //jobs added by other threads are pushed onto a shared submission queue
+    //never waits, queues grow as needed
+    //jobs are taken from a per thread pool, so adding a job doesn't allocate once the pool is large enough
+    //label is shown in traces and must stay valid until the trace is written, typically a string literal
+    void addJob(JobFunction&& job, Counter* counter, const JobPriority priority = JobPriority::High,
+        const char* label = nullptr);
+
+    //function must be callable as function(int workerIndex), captures must fit into JobFunction::storageSize
+    template<typename Function>
+    void addJob(Function&& job, Counter* counter, const JobPriority priority = JobPriority::High,
+        const char* label = nullptr) {
+        addJob(JobFunction(std::forward<Function>(job)), counter, priority, label);
+    }
 
+    using ParallelForFunction = std::function<void(size_t rangeBegin, size_t rangeEnd, int workerIndex)>;
+
+    //calls function for index ranges covering [begin, end), each containing at most grainSize indices
+    //ranges are split in halves recursively, so idle workers can steal large ranges
+    //calling thread takes part if it is a worker, returns after all ranges are finished
+    void parallelFor(const size_t begin, const size_t end, const size_t grainSize, const ParallelForFunction& function,
+        const JobPriority priority = JobPriority::High, const char* label = nullptr);
+
+    //threads registered as workers run pending jobs until the counter reaches zero
+    //other threads sleep until the counter reaches zero
     void waitOnCounter(Counter& counter);
+
+    //number of distinct workerIndex values passed to jobs, including the thread that called initJobSystem
     int getWorkerCount();
+
+    //when enabled begin and end time, worker and label of every job are recorded
+    //events are stored in a ringbuffer per worker without locking, the oldest events are overwritten when full
+    //buffers are allocated by each worker when it records its first event
+    void setTracingEnabled(const bool enabled);
+    bool isTracingEnabled();
+
+    //discards recorded events, must only be called while no jobs are running
+    void clearTrace();
+
+    //writes recorded events in the chrome trace event json format, can be opened with chrome://tracing or ui.perfetto.dev
+    //must only be called while no jobs are running, returns false if file could not be written
+    bool writeTraceFile(const std::filesystem::path& path);
+
+    class CoroutineJob;
+
+    //starts coroutine as job with given priority, it is resumed with the same priority after suspending
+    //counter is incremented immediately and decremented once the coroutine finished, not when it first suspends
+    void addCoroutineJob(CoroutineJob&& job, Counter* counter, const JobPriority priority = JobPriority::High,
+        const char* label = nullptr);
+
+    //return type of coroutines that are run as jobs
+    //inside the coroutine "co_await counter;" suspends until the counter reaches zero, without blocking the worker
+    //the coroutine is then resumed as a new job, possibly on another worker
+    //I/O and other work can be awaited by running it as a job associated with a counter
+    //counters must stay alive while coroutines are waiting on them
+    class CoroutineJob {
+    public:
+        struct promise_type;
+        using Handle = std::coroutine_handle<promise_type>;
+
+        struct CounterAwaiter {
+            Counter& counter;
+            bool await_ready() const noexcept;
+            //returns false if counter reached zero in the meantime, then the coroutine continues immediately
+            bool await_suspend(const Handle handle) noexcept;
+            void await_resume() const noexcept {}
+        };
+
+        //destroys coroutine and then decrements its counter
+        struct FinalAwaiter {
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(const Handle handle) noexcept;
+            void await_resume() const noexcept {}
+        };
+
+        struct promise_type {
+            Counter* counter = nullptr;
+            JobPriority priority = JobPriority::High;
+            const char* label = nullptr;
+
+            CoroutineJob get_return_object() { return CoroutineJob(Handle::from_promise(*this)); }
+            //coroutine starts when added with addCoroutineJob
+            std::suspend_always initial_suspend() noexcept { return {}; }
+            FinalAwaiter final_suspend() noexcept { return {}; }
+            void return_void() {}
+            void unhandled_exception() { std::terminate(); }
+            CounterAwaiter await_transform(Counter& counter) { return CounterAwaiter{ counter }; }
+        };
+
+        CoroutineJob(CoroutineJob&& other) noexcept : m_handle(other.m_handle) {
+            other.m_handle = nullptr;
+        }
+        CoroutineJob(const CoroutineJob&) = delete;
+        CoroutineJob& operator=(const CoroutineJob&) = delete;
+        CoroutineJob& operator=(CoroutineJob&&) = delete;
+
+        //coroutines that were never added are destroyed with the CoroutineJob
+        ~CoroutineJob() {
+            if (m_handle) {
+                m_handle.destroy();
+            }
+        }
+
+    private:
+        explicit CoroutineJob(const Handle handle) : m_handle(handle) {}
+        Handle m_handle;
+
+        friend void addCoroutineJob(CoroutineJob&& job, Counter* counter, const JobPriority priority, const char* label);
+    };
 }
\ No newline at end of file
@@ -7,7 +7,14 @@ struct TexturePaths {
     std::filesystem::path albedoTexturePath;
     std::filesystem::path normalTexturePath;
     std::filesystem::path specularTexturePath;
-    std::filesystem::path sdfTexturePath;
+    std::filesystem::path sdfTexturePath;               //brick atlas of sparse SDF
+    std::filesystem::path sdfIndirectionTexturePath;    //brick indirection of sparse SDF
+};
+
+//coarser level of detail of a mesh, references the vertices of the full detail mesh
+struct MeshDataLod {
+    std::vector<uint32_t> indices;
+    float error = 0.f;  //approximate deviation from the full detail surface, in mesh local units
 };
 
 struct MeshData {
@@ -21,15 +28,43 @@ struct MeshData {
 
     TexturePaths texturePaths;
     glm::vec3 meanAlbedo = glm::vec3(0.5f);
+
+    std::vector<MeshDataLod> lods;  //ordered from fine to coarse, without the full detail level
+};
+
+//cluster of consecutive triangles, drawn as a range of the mesh index buffer
+//bounds are in mesh local space, so they can be culled per object transform
+struct Meshlet {
+    uint32_t                firstIndex = 0;
+    uint32_t                indexCount = 0;
+    AxisAlignedBoundingBox  boundingBox;
+    glm::vec3               sphereCenter = glm::vec3(0.f);
+    float                   sphereRadius = 0.f;
+    //cone containing all triangle normals, defined by winding as cross(p2 - p0, p1 - p0)
+    //all triangles are backfacing if dot(normalize(coneApex - viewPosition), coneAxis) >= coneCutoff
+    glm::vec3               coneApex = glm::vec3(0.f);
+    float                   coneCutoff = 1.f;   //sine of cone half angle, 1 if cone is too wide to ever be culled
+    glm::vec3               coneAxis = glm::vec3(0.f, 0.f, 1.f);
+};
+
+//level of detail as ranges of the index buffer and meshlets of a MeshBinary
+struct MeshLod {
+    uint32_t    firstIndex = 0;
+    uint32_t    indexCount = 0;
+    uint32_t    firstMeshlet = 0;
+    uint32_t    meshletCount = 0;
+    float       error = 0.f;    //approximate deviation from the full detail surface, in mesh local units
 };
 
 //formated to be consumed directly by render backend
 struct MeshBinary {
-    uint32_t                indexCount = 0;
+    uint32_t                indexCount = 0;     //of all levels of detail
     uint32_t                vertexCount = 0;
     AxisAlignedBoundingBox  boundingBox;
     TexturePaths            texturePaths;
     glm::vec3               meanAlbedo = glm::vec3(0.5f);
     std::vector<uint16_t>   indexBuffer;    //stored as 16 or 32 bit unsigned int
     std::vector<uint8_t>    vertexBuffer;
+    std::vector<Meshlet>    meshlets;       //cover the index buffer in order, without gaps
+    std::vector<MeshLod>    lods;           //ordered from fine to coarse, lods[0] is full detail
 };
\ No newline at end of file
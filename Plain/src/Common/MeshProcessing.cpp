@@ -1,6 +1,7 @@
 #include "pch.h"
 #include "MeshProcessing.h"
-#include "Common/CompressedTypes.h"
+#include "Common/JobSystem.h"
+#include "Common/Meshlets.h"
 
 std::vector<AxisAlignedBoundingBox> AABBListFromMeshes(const std::vector<MeshData>& meshes) {
     std::vector<AxisAlignedBoundingBox> AABBList;
@@ -11,103 +12,118 @@ std::vector<AxisAlignedBoundingBox> AABBListFromMeshes(const std::vector<MeshDat
     return AABBList;
 }
 
+//vertex ranges are packed as separate jobs, so a single large mesh doesn't serialize packing
+const size_t vertexPackingGrainSize = 16384;
+
+//attributes are converted in blocks using the batch conversions, then interleaved into the packed vertices
+const size_t vertexPackingBlockSize = 256;
+
+void packVertices(const MeshData& mesh, const size_t begin, const size_t end, PackedVertex* outVertices) {
+    assert(end <= mesh.positions.size());
+    static_assert(sizeof(glm::vec2) == 2 * sizeof(float));
+
+    std::array<uint16_t, 2 * vertexPackingBlockSize> uvHalfs;
+    std::array<NormalizedR10G10B10A2, vertexPackingBlockSize> normals;
+    std::array<NormalizedR10G10B10A2, vertexPackingBlockSize> tangents;
+    std::array<NormalizedR10G10B10A2, vertexPackingBlockSize> bitangents;
+
+    for (size_t blockBegin = begin; blockBegin < end; blockBegin += vertexPackingBlockSize) {
+        const size_t count = std::min(vertexPackingBlockSize, end - blockBegin);
+        floatsToHalf(std::span(&mesh.uvs[blockBegin].x, 2 * count), std::span(uvHalfs.data(), 2 * count));
+        vec3sToNormalizedR10B10G10A2(std::span(&mesh.normals[blockBegin], count), std::span(normals.data(), count));
+        vec3sToNormalizedR10B10G10A2(std::span(&mesh.tangents[blockBegin], count), std::span(tangents.data(), count));
+        vec3sToNormalizedR10B10G10A2(std::span(&mesh.bitangents[blockBegin], count), std::span(bitangents.data(), count));
+
+        for (size_t i = 0; i < count; i++) {
+            PackedVertex& vertex = outVertices[blockBegin - begin + i];
+            vertex.position     = mesh.positions[blockBegin + i];
+            vertex.uv           = uint32_t(uvHalfs[2 * i]) | (uint32_t(uvHalfs[2 * i + 1]) << 16);
+            vertex.normal       = normals[i];
+            vertex.tangent      = tangents[i];
+            vertex.bitangent    = bitangents[i];
+        }
+    }
+}
+
 std::vector<MeshBinary> meshesToBinary(const std::vector<MeshData>& meshes, const std::vector<AxisAlignedBoundingBox>& AABBList) {
     assert(meshes.size() == AABBList.size());
-    std::vector<MeshBinary> meshesBinary;
-    meshesBinary.reserve(meshes.size());
-
-    for (size_t meshIndex = 0; meshIndex < meshes.size(); meshIndex++) {
-        const MeshData& meshData = meshes[meshIndex];
-        MeshBinary meshBinary;
-        meshBinary.texturePaths = meshData.texturePaths;
-        meshBinary.boundingBox = AABBList[meshIndex];
-        meshBinary.meanAlbedo = meshData.meanAlbedo;
-
-        //index buffer
-        meshBinary.indexCount = (uint32_t)meshData.indices.size();
-        if (meshBinary.indexCount < std::numeric_limits<uint16_t>::max()) {
-            //half precision indices are enough
-            //calculate lower precision indices
-            meshBinary.indexBuffer.reserve(meshBinary.indexCount);
-            for (const auto index : meshData.indices) {
-                meshBinary.indexBuffer.push_back((uint16_t)index);
+    std::vector<MeshBinary> meshesBinary(meshes.size());
+
+    JobSystem::parallelFor(0, meshes.size(), 1, [&meshes, &AABBList, &meshesBinary](const size_t rangeBegin, const size_t rangeEnd, int) {
+        for (size_t meshIndex = rangeBegin; meshIndex < rangeEnd; meshIndex++) {
+            const MeshData& meshData = meshes[meshIndex];
+            MeshBinary& meshBinary = meshesBinary[meshIndex];
+            meshBinary.texturePaths = meshData.texturePaths;
+            meshBinary.boundingBox = AABBList[meshIndex];
+            meshBinary.meanAlbedo = meshData.meanAlbedo;
+
+            //index buffer, levels of detail are stored consecutively, starting with full detail
+            std::vector<const std::vector<uint32_t>*> lodIndices = { &meshData.indices };
+            for (const MeshDataLod& lod : meshData.lods) {
+                lodIndices.push_back(&lod.indices);
             }
-        }
-        else {
-            //copy full precision indices
-            const uint32_t entryPerIndex = 2; //two 16 bit entries needed for one 32 bit index
-            meshBinary.indexBuffer.resize((size_t)meshBinary.indexCount * (size_t)entryPerIndex);
-            const size_t copySize = sizeof(uint32_t) * meshBinary.indexCount;
-            memcpy(meshBinary.indexBuffer.data(), meshData.indices.data(), copySize);
-        }
-
-        //vertex buffer
-        assert(meshData.positions.size() == meshData.uvs.size());
-        assert(meshData.positions.size() == meshData.normals.size());
-        assert(meshData.positions.size() == meshData.tangents.size());
-        assert(meshData.positions.size() == meshData.bitangents.size());
-
-        meshBinary.vertexCount = (uint32_t)meshData.positions.size();
-
-        //precision and type must correspond to types in VertexInput.h
-        for (size_t i = 0; i < meshBinary.vertexCount; i++) {
-            //position
-            meshBinary.vertexBuffer.push_back(((uint8_t*)&meshData.positions[i].x)[0]);
-            meshBinary.vertexBuffer.push_back(((uint8_t*)&meshData.positions[i].x)[1]);
-            meshBinary.vertexBuffer.push_back(((uint8_t*)&meshData.positions[i].x)[2]);
-            meshBinary.vertexBuffer.push_back(((uint8_t*)&meshData.positions[i].x)[3]);
-
-            meshBinary.vertexBuffer.push_back(((uint8_t*)&meshData.positions[i].y)[0]);
-            meshBinary.vertexBuffer.push_back(((uint8_t*)&meshData.positions[i].y)[1]);
-            meshBinary.vertexBuffer.push_back(((uint8_t*)&meshData.positions[i].y)[2]);
-            meshBinary.vertexBuffer.push_back(((uint8_t*)&meshData.positions[i].y)[3]);
-
-            meshBinary.vertexBuffer.push_back(((uint8_t*)&meshData.positions[i].z)[0]);
-            meshBinary.vertexBuffer.push_back(((uint8_t*)&meshData.positions[i].z)[1]);
-            meshBinary.vertexBuffer.push_back(((uint8_t*)&meshData.positions[i].z)[2]);
-            meshBinary.vertexBuffer.push_back(((uint8_t*)&meshData.positions[i].z)[3]);
-
-            //uv stored as 16 bit signed float
-            const auto uHalf = glm::packHalf(glm::vec1(meshData.uvs[i].x));
-            meshBinary.vertexBuffer.push_back(((uint8_t*)&uHalf)[0]);
-            meshBinary.vertexBuffer.push_back(((uint8_t*)&uHalf)[1]);
-
-            const auto vHalf = glm::packHalf(glm::vec1(meshData.uvs[i].y));
-            meshBinary.vertexBuffer.push_back(((uint8_t*)&vHalf)[0]);
-            meshBinary.vertexBuffer.push_back(((uint8_t*)&vHalf)[1]);
-
-            //normal stored as 32 bit R10G10B10A2
-            {
-                const NormalizedR10G10B10A2 normalCompressed = vec3ToNormalizedR10B10G10A2(meshData.normals[i]);
-
-                meshBinary.vertexBuffer.push_back(((uint8_t*)&normalCompressed)[0]);
-                meshBinary.vertexBuffer.push_back(((uint8_t*)&normalCompressed)[1]);
-                meshBinary.vertexBuffer.push_back(((uint8_t*)&normalCompressed)[2]);
-                meshBinary.vertexBuffer.push_back(((uint8_t*)&normalCompressed)[3]);
+            meshBinary.indexCount = 0;
+            for (const std::vector<uint32_t>* indices : lodIndices) {
+                meshBinary.indexCount += (uint32_t)indices->size();
             }
-
-            //tangent stored as 32 bit R10G10B10A2
-            {
-                const NormalizedR10G10B10A2 tangentCompressed = vec3ToNormalizedR10B10G10A2(meshData.tangents[i]);
-
-                meshBinary.vertexBuffer.push_back(((uint8_t*)&tangentCompressed)[0]);
-                meshBinary.vertexBuffer.push_back(((uint8_t*)&tangentCompressed)[1]);
-                meshBinary.vertexBuffer.push_back(((uint8_t*)&tangentCompressed)[2]);
-                meshBinary.vertexBuffer.push_back(((uint8_t*)&tangentCompressed)[3]);
+            if (meshBinary.indexCount < std::numeric_limits<uint16_t>::max()) {
+                //half precision indices are enough
+                //calculate lower precision indices
+                meshBinary.indexBuffer.resize(meshBinary.indexCount);
+                size_t writeIndex = 0;
+                for (const std::vector<uint32_t>* indices : lodIndices) {
+                    for (const uint32_t index : *indices) {
+                        meshBinary.indexBuffer[writeIndex++] = (uint16_t)index;
+                    }
+                }
+            }
+            else {
+                //copy full precision indices
+                const uint32_t entryPerIndex = 2; //two 16 bit entries needed for one 32 bit index
+                meshBinary.indexBuffer.resize((size_t)meshBinary.indexCount * (size_t)entryPerIndex);
+                size_t writeEntry = 0;
+                for (const std::vector<uint32_t>* indices : lodIndices) {
+                    const size_t copySize = sizeof(uint32_t) * indices->size();
+                    memcpy(meshBinary.indexBuffer.data() + writeEntry, indices->data(), copySize);
+                    writeEntry += indices->size() * entryPerIndex;
+                }
             }
 
-            //bitangent stored as 32 bit R10G10B10A2
-            {
-                const NormalizedR10G10B10A2 bitangentCompressed = vec3ToNormalizedR10B10G10A2(meshData.bitangents[i]);
-
-                meshBinary.vertexBuffer.push_back(((uint8_t*)&bitangentCompressed)[0]);
-                meshBinary.vertexBuffer.push_back(((uint8_t*)&bitangentCompressed)[1]);
-                meshBinary.vertexBuffer.push_back(((uint8_t*)&bitangentCompressed)[2]);
-                meshBinary.vertexBuffer.push_back(((uint8_t*)&bitangentCompressed)[3]);
+            //vertex buffer
+            assert(meshData.positions.size() == meshData.uvs.size());
+            assert(meshData.positions.size() == meshData.normals.size());
+            assert(meshData.positions.size() == meshData.tangents.size());
+            assert(meshData.positions.size() == meshData.bitangents.size());
+
+            meshBinary.vertexCount = (uint32_t)meshData.positions.size();
+
+            //sized once, vertex ranges write disjoint parts of the buffer
+            meshBinary.vertexBuffer.resize((size_t)meshBinary.vertexCount * sizeof(PackedVertex));
+            PackedVertex* packedVertices = (PackedVertex*)meshBinary.vertexBuffer.data();
+
+            JobSystem::parallelFor(0, meshBinary.vertexCount, vertexPackingGrainSize,
+                [&meshData, packedVertices](const size_t vertexBegin, const size_t vertexEnd, int) {
+                packVertices(meshData, vertexBegin, vertexEnd, packedVertices + vertexBegin);
+            });
+
+            //meshlets are built per level, so every level can be culled and drawn on its own
+            uint32_t lodFirstIndex = 0;
+            for (size_t level = 0; level < lodIndices.size(); level++) {
+                MeshLod lod;
+                lod.firstIndex = lodFirstIndex;
+                lod.indexCount = (uint32_t)lodIndices[level]->size();
+                lod.firstMeshlet = (uint32_t)meshBinary.meshlets.size();
+                lod.error = level == 0 ? 0.f : meshData.lods[level - 1].error;
+
+                for (Meshlet meshlet : buildMeshlets(meshData.positions, *lodIndices[level])) {
+                    meshlet.firstIndex += lod.firstIndex;
+                    meshBinary.meshlets.push_back(meshlet);
+                }
+                lod.meshletCount = (uint32_t)meshBinary.meshlets.size() - lod.firstMeshlet;
+                meshBinary.lods.push_back(lod);
+                lodFirstIndex += lod.indexCount;
             }
         }
-        meshesBinary.push_back(meshBinary);
-    }
-
+    });
     return meshesBinary;
 }
\ No newline at end of file
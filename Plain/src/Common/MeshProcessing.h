@@ -1,6 +1,25 @@
 #pragma once
 #include "pch.h"
 #include "Common/MeshData.h"
+#include "Common/CompressedTypes.h"
+#include "Common/VertexInput.h"
+
+//vertex as stored in MeshBinary::vertexBuffer, precision and layout must correspond to types in VertexInput.h
+struct PackedVertex {
+    glm::vec3               position;
+    uint32_t                uv;         //two 16 bit floats, u in the lower bits
+    NormalizedR10G10B10A2   normal;
+    NormalizedR10G10B10A2   tangent;
+    NormalizedR10G10B10A2   bitangent;
+};
+static_assert(sizeof(PackedVertex) == getFullVertexFormatByteSize());
 
 std::vector<AxisAlignedBoundingBox> AABBListFromMeshes(const std::vector<MeshData>& meshes);
+
+//packs vertices [begin, end) of mesh into outVertices, which must have room for end - begin vertices
+void packVertices(const MeshData& mesh, const size_t begin, const size_t end, PackedVertex* outVertices);
+
+//meshes are packed in parallel using the job system, large meshes are additionally split into vertex ranges
+//meshlets are built from the index order, so triangles should be ordered for locality beforehand
+//levels of detail are appended to the index buffer after the full detail indices, each with its own meshlets
 std::vector<MeshBinary> meshesToBinary(const std::vector<MeshData>& meshes, const std::vector<AxisAlignedBoundingBox>& AABBList);
\ No newline at end of file
@@ -0,0 +1,148 @@
+#include "pch.h"
+#include "Meshlets.h"
+
+//---- private function declarations ----
+
+//computes bounds and normal cone of the triangles in the meshlet index range
+void computeMeshletBounds(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices, Meshlet* meshlet);
+
+//cones with a smaller minimum normal to axis dot product are not culled, close to 90 degrees the test becomes unstable
+const float meshletConeMinNormalDot = 0.1f;
+
+//---- implementation ----
+
+std::vector<Meshlet> buildMeshlets(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices) {
+    assert(indices.size() % 3 == 0);
+
+    std::vector<Meshlet> meshlets;
+
+    //stores for every vertex the index of the last meshlet using it, avoids clearing a set for every meshlet
+    const uint32_t noMeshlet = std::numeric_limits<uint32_t>::max();
+    std::vector<uint32_t> vertexLastMeshlet(positions.size(), noMeshlet);
+
+    Meshlet current;
+    uint32_t currentVertexCount = 0;
+    const auto closeCurrent = [&]() {
+        if (current.indexCount > 0) {
+            computeMeshletBounds(positions, indices, &current);
+            meshlets.push_back(current);
+        }
+        current = Meshlet();
+        current.firstIndex = meshlets.empty() ? 0 : meshlets.back().firstIndex + meshlets.back().indexCount;
+        currentVertexCount = 0;
+    };
+
+    for (size_t triangleBase = 0; triangleBase < indices.size(); triangleBase += 3) {
+        const uint32_t meshletIndex = (uint32_t)meshlets.size();
+
+        uint32_t newVertexCount = 0;
+        for (size_t i = 0; i < 3; i++) {
+            const uint32_t vertex = indices[triangleBase + i];
+            const bool isDuplicateInTriangle = (i > 0 && vertex == indices[triangleBase]) ||
+                (i > 1 && vertex == indices[triangleBase + 1]);
+            if (vertexLastMeshlet[vertex] != meshletIndex && !isDuplicateInTriangle) {
+                newVertexCount++;
+            }
+        }
+        const bool exceedsVertexLimit = currentVertexCount + newVertexCount > meshletMaxVertexCount;
+        const bool exceedsTriangleLimit = current.indexCount / 3 + 1 > meshletMaxTriangleCount;
+        if (exceedsVertexLimit || exceedsTriangleLimit) {
+            closeCurrent();
+        }
+
+        //closing changes the meshlet index, so vertices are counted again
+        const uint32_t currentMeshletIndex = (uint32_t)meshlets.size();
+        for (size_t i = 0; i < 3; i++) {
+            const uint32_t vertex = indices[triangleBase + i];
+            if (vertexLastMeshlet[vertex] != currentMeshletIndex) {
+                vertexLastMeshlet[vertex] = currentMeshletIndex;
+                currentVertexCount++;
+            }
+        }
+        current.indexCount += 3;
+    }
+    closeCurrent();
+    return meshlets;
+}
+
+//reference: "meshoptimizer", Arseny Kapoulkine, meshopt_computeClusterBounds
+void computeMeshletBounds(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices, Meshlet* meshlet) {
+    const uint32_t indexEnd = meshlet->firstIndex + meshlet->indexCount;
+
+    meshlet->boundingBox.min = glm::vec3(std::numeric_limits<float>::infinity());
+    meshlet->boundingBox.max = glm::vec3(-std::numeric_limits<float>::infinity());
+    for (uint32_t i = meshlet->firstIndex; i < indexEnd; i++) {
+        const glm::vec3 p = positions[indices[i]];
+        meshlet->boundingBox.min = glm::min(meshlet->boundingBox.min, p);
+        meshlet->boundingBox.max = glm::max(meshlet->boundingBox.max, p);
+    }
+
+    meshlet->sphereCenter = (meshlet->boundingBox.min + meshlet->boundingBox.max) * 0.5f;
+    meshlet->sphereRadius = 0.f;
+    for (uint32_t i = meshlet->firstIndex; i < indexEnd; i++) {
+        const glm::vec3 p = positions[indices[i]];
+        meshlet->sphereRadius = glm::max(meshlet->sphereRadius, glm::length(p - meshlet->sphereCenter));
+    }
+
+    //default cone is never culled
+    meshlet->coneApex = meshlet->sphereCenter;
+    meshlet->coneAxis = glm::vec3(0.f, 0.f, 1.f);
+    meshlet->coneCutoff = 1.f;
+
+    //normals are defined by winding, as that is what the rasterizer uses for backface culling
+    //with the camera conventions of the runtime a triangle faces the viewer if cross(p2 - p0, p1 - p0) points towards it
+    //this is the reverse of gltf, as the import flips the y-axis without changing the index order
+    //degenerate triangles are never rasterized, so they are skipped
+    std::vector<glm::vec3> normals;
+    normals.reserve(meshlet->indexCount / 3);
+    glm::vec3 normalSum = glm::vec3(0.f);
+    for (uint32_t i = meshlet->firstIndex; i < indexEnd; i += 3) {
+        const glm::vec3 p0 = positions[indices[i]];
+        const glm::vec3 p1 = positions[indices[i + 1]];
+        const glm::vec3 p2 = positions[indices[i + 2]];
+        const glm::vec3 n = glm::cross(p2 - p0, p1 - p0);
+        const float nLength = glm::length(n);
+        if (nLength > 0.f) {
+            normals.push_back(n / nLength);
+            normalSum += normals.back();
+        }
+        else {
+            normals.push_back(glm::vec3(0.f));
+        }
+    }
+
+    const float normalSumLength = glm::length(normalSum);
+    if (normalSumLength <= 0.f) {
+        return;
+    }
+    const glm::vec3 axis = normalSum / normalSumLength;
+
+    float minNormalDot = 1.f;
+    for (const glm::vec3& n : normals) {
+        const bool isDegenerate = n == glm::vec3(0.f);
+        if (!isDegenerate) {
+            minNormalDot = glm::min(minNormalDot, glm::dot(n, axis));
+        }
+    }
+    if (minNormalDot <= meshletConeMinNormalDot) {
+        return;
+    }
+
+    //apex is moved back along the axis until it lies behind all triangle planes
+    //all triangles are then backfacing for every view position inside the cone mirrored at the apex
+    float maxApexOffset = 0.f;
+    for (uint32_t triangle = 0; triangle < normals.size(); triangle++) {
+        const glm::vec3 n = normals[triangle];
+        const bool isDegenerate = n == glm::vec3(0.f);
+        if (isDegenerate) {
+            continue;
+        }
+        const glm::vec3 p0 = positions[indices[meshlet->firstIndex + 3 * triangle]];
+        const float apexOffset = glm::dot(meshlet->sphereCenter - p0, n) / glm::dot(axis, n);
+        maxApexOffset = glm::max(maxApexOffset, apexOffset);
+    }
+
+    meshlet->coneApex = meshlet->sphereCenter - axis * maxApexOffset;
+    meshlet->coneAxis = axis;
+    meshlet->coneCutoff = glm::sqrt(1.f - minNormalDot * minNormalDot);
+}
\ No newline at end of file
@@ -0,0 +1,13 @@
+#pragma once
+#include "pch.h"
+#include "Common/MeshData.h"
+
+//limits are chosen to fit common mesh shader output limits, so meshlets can be reused for mesh shading
+const uint32_t meshletMaxVertexCount = 64;
+const uint32_t meshletMaxTriangleCount = 124;
+
+//meshlets are built from consecutive triangles, so the index buffer is not changed and each meshlet is an index range
+//triangles should be ordered for locality beforehand, e.g. by optimiseMeshOrder, else meshlets are spatially scattered
+//a meshlet is closed once adding the next triangle would exceed the vertex or triangle limit
+//meshlet index ranges are relative to the start of indices, so levels of detail can be passed separately
+std::vector<Meshlet> buildMeshlets(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices);
\ No newline at end of file
@@ -6,8 +6,12 @@
 
 const uint32_t binaryModelMagicNumber = *(uint32_t*)"PlMB"; // stands for Plain Model Binary
 
+// increment when the file structure changes, files with a different version must be recreated by the asset pipeline
+const uint32_t binaryModelVersion = 3;
+
 struct ModelFileHeader {
     uint32_t magicNumber;   // for verification
+    uint32_t version;       // uses former padding, files from before versioning fail the check
     size_t objectCount;
     size_t meshCount;
 };
@@ -19,7 +23,7 @@ ModelFileHeader
 header.objectCount time the Object struct which contains a 4x4 model matrix and a mesh index
 
 header.meshCount times the following data structure:
-uint32_t indexCount
+uint32_t indexCount, of all levels of detail
 uint32_t vertexCount
 uint32_t albedo texture path length
 char* albedo texture path
@@ -27,8 +31,17 @@ uint32_t normal texture path length
 char* normal texture path
 uint32_t specular texture path length
 char* specular texture path
+uint32_t sdf texture path length
+char* sdf texture path
+uint32_t sdf indirection texture path length
+char* sdf indirection texture path
+glm::vec3 mean albedo
 index buffer data, as 16 bit or 32 bit unsigned int, uses 16 bit if index count < uint16_t::max
 vertex buffer data, vertexCount times full vertex format size
+uint32_t meshletCount
+Meshlet* meshlets, meshletCount times the Meshlet struct
+uint32_t lodCount
+MeshLod* lods, lodCount times the MeshLod struct
 */
 
 // copies data and returns offset + copy size
@@ -40,6 +53,7 @@ size_t copyToBuffer(const void* src, uint8_t* dst, const size_t copySize, const
 void saveBinaryScene(const std::filesystem::path& filename, SceneBinary scene){
     ModelFileHeader header;
     header.magicNumber = binaryModelMagicNumber;
+    header.version = binaryModelVersion;
     header.objectCount = scene.objects.size();
     header.meshCount = scene.meshes.size();
 
@@ -56,10 +70,16 @@ void saveBinaryScene(const std::filesystem::path& filename, SceneBinary scene){
         meshDataSize += sizeof(uint32_t); // specular texture path length
         meshDataSize += meshBinary.texturePaths.specularTexturePath.string().size();
         meshDataSize += sizeof(uint32_t); // sdf texture path length
-        meshDataSize += sizeof(meshBinary.meanAlbedo);
         meshDataSize += meshBinary.texturePaths.sdfTexturePath.string().size();
+        meshDataSize += sizeof(uint32_t); // sdf indirection texture path length
+        meshDataSize += meshBinary.texturePaths.sdfIndirectionTexturePath.string().size();
+        meshDataSize += sizeof(meshBinary.meanAlbedo);
         meshDataSize += sizeof(uint16_t) * meshBinary.indexBuffer.size();
         meshDataSize += sizeof(uint8_t) * meshBinary.vertexBuffer.size();
+        meshDataSize += sizeof(uint32_t); // meshlet count
+        meshDataSize += sizeof(Meshlet) * meshBinary.meshlets.size();
+        meshDataSize += sizeof(uint32_t); // lod count
+        meshDataSize += sizeof(MeshLod) * meshBinary.lods.size();
     }
 
     const size_t objectDataSize = sizeof(ObjectBinary) * scene.objects.size();
@@ -112,6 +132,15 @@ void saveBinaryScene(const std::filesystem::path& filename, SceneBinary scene){
             meshBinary.texturePaths.sdfTexturePath.string().size() * sizeof(char),
             writePointer);
 
+        const uint32_t sdfIndirectionPathLength = (uint32_t)meshBinary.texturePaths.sdfIndirectionTexturePath.string().size();
+        writePointer = copyToBuffer(&sdfIndirectionPathLength, fileData, sizeof(sdfIndirectionPathLength), writePointer);
+
+        writePointer = copyToBuffer(
+            meshBinary.texturePaths.sdfIndirectionTexturePath.string().c_str(),
+            fileData,
+            meshBinary.texturePaths.sdfIndirectionTexturePath.string().size() * sizeof(char),
+            writePointer);
+
         writePointer = copyToBuffer(
             &meshBinary.meanAlbedo,
             fileData,
@@ -129,6 +158,24 @@ void saveBinaryScene(const std::filesystem::path& filename, SceneBinary scene){
             fileData,
             sizeof(uint8_t) * meshBinary.vertexBuffer.size(),
             writePointer);
+
+        const uint32_t meshletCount = (uint32_t)meshBinary.meshlets.size();
+        writePointer = copyToBuffer(&meshletCount, fileData, sizeof(meshletCount), writePointer);
+
+        writePointer = copyToBuffer(
+            meshBinary.meshlets.data(),
+            fileData,
+            sizeof(Meshlet) * meshBinary.meshlets.size(),
+            writePointer);
+
+        const uint32_t lodCount = (uint32_t)meshBinary.lods.size();
+        writePointer = copyToBuffer(&lodCount, fileData, sizeof(lodCount), writePointer);
+
+        writePointer = copyToBuffer(
+            meshBinary.lods.data(),
+            fileData,
+            sizeof(MeshLod) * meshBinary.lods.size(),
+            writePointer);
     }
 
     assert(writePointer == fileSize);
@@ -159,6 +206,11 @@ bool loadBinaryScene(const std::filesystem::path& filename, SceneBinary* outScen
         file.close();
         return false;
     }
+    if (header.version != binaryModelVersion) {
+        std::cout << "Binary model file has outdated version, run asset pipeline again: " << fullPath << "\n";
+        file.close();
+        return false;
+    }
 
     // read object data
     outScene->objects.resize(header.objectCount);
@@ -202,6 +254,13 @@ bool loadBinaryScene(const std::filesystem::path& filename, SceneBinary* outScen
         file.read(sdfPathString.data(), sdfPathLength * sizeof(char));
         mesh.texturePaths.sdfTexturePath = sdfPathString;
 
+        uint32_t sdfIndirectionPathLength;
+        file.read((char*)&sdfIndirectionPathLength, sizeof(sdfIndirectionPathLength));
+        std::string sdfIndirectionPathString;
+        sdfIndirectionPathString.resize(sdfIndirectionPathLength);
+        file.read(sdfIndirectionPathString.data(), sdfIndirectionPathLength * sizeof(char));
+        mesh.texturePaths.sdfIndirectionTexturePath = sdfIndirectionPathString;
+
         file.read((char*)&mesh.meanAlbedo, sizeof(mesh.meanAlbedo));
 
         size_t halfPerIndex;
@@ -223,6 +282,16 @@ bool loadBinaryScene(const std::filesystem::path& filename, SceneBinary* outScen
         mesh.vertexBuffer.resize(vertexBufferSize);
         file.read((char*)mesh.vertexBuffer.data(), vertexBufferSize);
 
+        uint32_t meshletCount;
+        file.read((char*)&meshletCount, sizeof(meshletCount));
+        mesh.meshlets.resize(meshletCount);
+        file.read((char*)mesh.meshlets.data(), meshletCount * sizeof(Meshlet));
+
+        uint32_t lodCount;
+        file.read((char*)&lodCount, sizeof(lodCount));
+        mesh.lods.resize(lodCount);
+        file.read((char*)mesh.lods.data(), lodCount * sizeof(MeshLod));
+
         outScene->meshes.push_back(mesh);
     }
 
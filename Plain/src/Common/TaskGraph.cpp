@@ -0,0 +1,67 @@
+#include "pch.h"
+#include "TaskGraph.h"
+
+namespace JobSystem {
+
+    TaskHandle TaskGraph::addTask(JobFunction&& function, const JobPriority priority, const char* label) {
+        assert(m_counter.counter.load() == 0);
+        std::unique_ptr<Task> task = std::make_unique<Task>();
+        task->function = std::move(function);
+        task->priority = priority;
+        task->label = label;
+        m_tasks.push_back(std::move(task));
+
+        TaskHandle handle;
+        handle.index = (uint32_t)(m_tasks.size() - 1);
+        return handle;
+    }
+
+    void TaskGraph::addDependency(const TaskHandle predecessor, const TaskHandle successor) {
+        assert(m_counter.counter.load() == 0);
+        assert(predecessor.index < m_tasks.size());
+        assert(successor.index < m_tasks.size());
+        assert(predecessor.index != successor.index);
+        m_tasks[predecessor.index]->successors.push_back(successor.index);
+        m_tasks[successor.index]->predecessorCount++;
+    }
+
+    void TaskGraph::run() {
+        assert(m_counter.counter.load() == 0);
+        //all counts must be reset before the first task is started, as it may release successors immediately
+        for (const std::unique_ptr<Task>& task : m_tasks) {
+            task->remainingPredecessorCount.store(task->predecessorCount, std::memory_order_relaxed);
+        }
+        for (uint32_t taskIndex = 0; taskIndex < m_tasks.size(); taskIndex++) {
+            if (m_tasks[taskIndex]->predecessorCount == 0) {
+                startTask(taskIndex);
+            }
+        }
+    }
+
+    void TaskGraph::wait() {
+        waitOnCounter(m_counter);
+    }
+
+    void TaskGraph::execute() {
+        run();
+        wait();
+    }
+
+    void TaskGraph::startTask(const uint32_t taskIndex) {
+        addJob([this, taskIndex](int workerIndex) {
+            runTask(taskIndex, workerIndex);
+        }, &m_counter, m_tasks[taskIndex]->priority, m_tasks[taskIndex]->label);
+    }
+
+    void TaskGraph::runTask(const uint32_t taskIndex, const int workerIndex) {
+        Task& task = *m_tasks[taskIndex];
+        task.function(workerIndex);
+        //successors are added before this job decrements the counter, so it can't reach zero early
+        //acquire and release make results of all predecessors visible to the successor
+        for (const uint32_t successorIndex : task.successors) {
+            if (m_tasks[successorIndex]->remainingPredecessorCount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                startTask(successorIndex);
+            }
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,58 @@
+#pragma once
+#include "pch.h"
+#include "JobSystem.h"
+
+namespace JobSystem {
+
+    struct TaskHandle {
+        uint32_t index;
+    };
+
+    //tasks are jobs that only start after all their predecessors finished
+    //a finished task adds its released successors as jobs, so independent chains of tasks overlap
+    //dependencies must not form cycles
+    //graph must not be changed or destroyed while it is running
+    class TaskGraph {
+    public:
+        //label is shown in traces, see addJob
+        TaskHandle addTask(JobFunction&& function, const JobPriority priority = JobPriority::High,
+            const char* label = nullptr);
+
+        //function must be callable as function(int workerIndex), captures must fit into JobFunction::storageSize
+        template<typename Function>
+        TaskHandle addTask(Function&& function, const JobPriority priority = JobPriority::High,
+            const char* label = nullptr) {
+            return addTask(JobFunction(std::forward<Function>(function)), priority, label);
+        }
+
+        //successor is started after predecessor finished
+        void addDependency(const TaskHandle predecessor, const TaskHandle successor);
+
+        //adds tasks without predecessors as jobs and returns
+        //graph can be run again after it finished
+        void run();
+
+        //waits until all tasks finished, runs jobs if calling thread is a worker
+        void wait();
+
+        //run and wait
+        void execute();
+
+    private:
+        struct Task {
+            JobFunction function;
+            JobPriority priority = JobPriority::High;
+            const char* label = nullptr;
+            std::vector<uint32_t> successors;
+            int predecessorCount = 0;
+            std::atomic<int> remainingPredecessorCount = 0;
+        };
+
+        void startTask(const uint32_t taskIndex);
+        void runTask(const uint32_t taskIndex, const int workerIndex);
+
+        //tasks are stored as pointers as they are neither copyable nor movable
+        std::vector<std::unique_ptr<Task>> m_tasks;
+        Counter m_counter;
+    };
+}
\ No newline at end of file
@@ -5,6 +5,9 @@ float getImageFormatBytePerPixel(const ImageFormat format) {
     if (format == ImageFormat::R8) {
         return 1.f;
     }
+    else if (format == ImageFormat::R8_sNorm) {
+        return 1.f;
+    }
     else if (format == ImageFormat::R11G11B10_uFloat) {
         return 4;
     }
@@ -38,6 +41,9 @@ float getImageFormatBytePerPixel(const ImageFormat format) {
     else if (format == ImageFormat::BC3) {
         return 1;
     }
+    else if (format == ImageFormat::BC4_sNorm) {
+        return 0.5;
+    }
     else if (format == ImageFormat::BC5) {
         return 1;
     }
@@ -53,6 +59,9 @@ bool getImageFormatIsBCnCompressed(const ImageFormat format) {
     else if (format == ImageFormat::BC3) {
         return true;
     }
+    else if (format == ImageFormat::BC4_sNorm) {
+        return true;
+    }
     else if (format == ImageFormat::BC5) {
         return true;
     }
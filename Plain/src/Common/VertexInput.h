@@ -30,7 +30,7 @@ const uint32_t vertexInputNormalByteSize    = 4;
 const uint32_t vertexInputTangentByteSize   = 4;
 const uint32_t vertexInputBitangentByteSize = 4;
 
-const uint32_t vertexInputBytePerLocation[VERTEX_INPUT_ATTRIBUTE_COUNT] = {
+constexpr uint32_t vertexInputBytePerLocation[VERTEX_INPUT_ATTRIBUTE_COUNT] = {
     vertexInputPositionByteSize,
     vertexInputUVByteSize,
     vertexInputNormalByteSize,
@@ -0,0 +1,99 @@
+#include "pch.h"
+#include "WorkStealingQueue.h"
+
+WorkStealingQueue::CircularArray::CircularArray(const int64_t capacity)
+    : capacity(capacity), indexMask(capacity - 1), elements(new std::atomic<JobSystem::Job*>[capacity]) {
+    assert((capacity & indexMask) == 0); //must be power of two
+}
+
+//release and acquire ordering of elements makes the job's data visible to the stealing thread
+//on x86 this is not more expensive than relaxed ordering
+JobSystem::Job* WorkStealingQueue::CircularArray::get(const int64_t index) const {
+    return elements[index & indexMask].load(std::memory_order_acquire);
+}
+
+void WorkStealingQueue::CircularArray::put(const int64_t index, JobSystem::Job* job) {
+    elements[index & indexMask].store(job, std::memory_order_release);
+}
+
+WorkStealingQueue::WorkStealingQueue(const int64_t initialCapacity) {
+    m_arrays.push_back(std::make_unique<CircularArray>(initialCapacity));
+    m_array.store(m_arrays.back().get(), std::memory_order_relaxed);
+    m_top.store(0, std::memory_order_relaxed);
+    m_bottom.store(0, std::memory_order_relaxed);
+}
+
+void WorkStealingQueue::push(JobSystem::Job* job) {
+    const int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+    const int64_t top = m_top.load(std::memory_order_acquire);
+    CircularArray* array = m_array.load(std::memory_order_relaxed);
+
+    if (bottom - top > array->capacity - 1) {
+        //queue is full
+        array = grow(array, top, bottom);
+    }
+    array->put(bottom, job);
+    std::atomic_thread_fence(std::memory_order_release);
+    m_bottom.store(bottom + 1, std::memory_order_relaxed);
+}
+
+JobSystem::Job* WorkStealingQueue::pop() {
+    const int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+    CircularArray* array = m_array.load(std::memory_order_relaxed);
+    m_bottom.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t top = m_top.load(std::memory_order_relaxed);
+
+    if (top > bottom) {
+        //queue is empty, restore bottom
+        m_bottom.store(bottom + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    JobSystem::Job* job = array->get(bottom);
+    if (top == bottom) {
+        //last element, competing with stealing threads
+        if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            //lost race
+            job = nullptr;
+        }
+        m_bottom.store(bottom + 1, std::memory_order_relaxed);
+    }
+    return job;
+}
+
+JobSystem::Job* WorkStealingQueue::steal() {
+    int64_t top = m_top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const int64_t bottom = m_bottom.load(std::memory_order_acquire);
+
+    if (top >= bottom) {
+        //queue is empty
+        return nullptr;
+    }
+
+    //consume ordering would be sufficient, but is promoted to acquire by compilers anyways
+    const CircularArray* array = m_array.load(std::memory_order_acquire);
+    JobSystem::Job* job = array->get(top);
+    if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+        //lost race against owner or other stealing thread
+        return nullptr;
+    }
+    return job;
+}
+
+bool WorkStealingQueue::isEmpty() const {
+    const int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+    const int64_t top = m_top.load(std::memory_order_relaxed);
+    return top >= bottom;
+}
+
+WorkStealingQueue::CircularArray* WorkStealingQueue::grow(CircularArray* current, const int64_t top, const int64_t bottom) {
+    m_arrays.push_back(std::make_unique<CircularArray>(current->capacity * 2));
+    CircularArray* grown = m_arrays.back().get();
+    for (int64_t i = top; i < bottom; i++) {
+        grown->put(i, current->get(i));
+    }
+    m_array.store(grown, std::memory_order_release);
+    return grown;
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+#include "pch.h"
+#include <atomic>
+#include <memory>
+
+namespace JobSystem {
+    struct Job;
+}
+
+//Chase-Lev work stealing deque, grows when full
+//the owning thread pushes and pops at the bottom, any other thread can steal from the top
+//reference: "Dynamic Circular Work-Stealing Deque", Chase and Lev
+//reference: "Correct and Efficient Work-Stealing for Weak Memory Models", Le et al.
+class WorkStealingQueue {
+public:
+    //initialCapacity must be a power of two
+    WorkStealingQueue(const int64_t initialCapacity);
+
+    //must only be called by owning thread
+    void push(JobSystem::Job* job);
+
+    //must only be called by owning thread
+    //returns nullptr if queue is empty
+    JobSystem::Job* pop();
+
+    //can be called by any thread
+    //returns nullptr if queue is empty or another thread took the last job
+    JobSystem::Job* steal();
+
+    //not exact when other threads are accessing the queue at the same time
+    bool isEmpty() const;
+
+private:
+    struct CircularArray {
+        CircularArray(const int64_t capacity);
+
+        int64_t capacity;
+        int64_t indexMask;  //capacity is a power of two, so wrapping index can use a mask
+        std::unique_ptr<std::atomic<JobSystem::Job*>[]> elements;
+
+        JobSystem::Job* get(const int64_t index) const;
+        void put(const int64_t index, JobSystem::Job* job);
+    };
+
+    //must only be called by owning thread
+    //copies the elements in range [top, bottom) into an array of twice the size
+    CircularArray* grow(CircularArray* current, const int64_t top, const int64_t bottom);
+
+    std::atomic<int64_t> m_top;
+    std::atomic<int64_t> m_bottom;
+    std::atomic<CircularArray*> m_array;
+
+    //stealing threads may still read from replaced arrays, so they are kept alive until the queue is destroyed
+    std::vector<std::unique_ptr<CircularArray>> m_arrays;
+};
\ No newline at end of file
@@ -268,7 +268,8 @@ void RenderBackend::drawMeshes(
     const std::vector<MeshHandle>   meshHandles, 
     const char*                     pushConstantData, 
     const RenderPassHandle          passHandle, 
-    const int                       workerIndex) {
+    const int                       workerIndex,
+    const MeshIndexRanges*          indexRanges) {
 
     const GraphicPass& pass = m_renderPasses.getGraphicPassRefByHandle(passHandle);
 
@@ -308,7 +309,17 @@ void RenderBackend::drawMeshes(
                 (uint32_t)pass.pushConstantSize,
                 pushConstantData + i * pass.pushConstantSize);
         }
-        vkCmdDrawIndexed(meshCommandBuffer, mesh.indexCount, 1, 0, 0, 0);
+        if (indexRanges == nullptr) {
+            vkCmdDrawIndexed(meshCommandBuffer, mesh.indexCount, 1, 0, 0, 0);
+        }
+        else {
+            assert(indexRanges->firstRangePerMesh.size() == meshHandles.size() + 1);
+            const uint32_t rangeEnd = indexRanges->firstRangePerMesh[i + 1];
+            for (uint32_t rangeIndex = indexRanges->firstRangePerMesh[i]; rangeIndex < rangeEnd; rangeIndex++) {
+                const MeshIndexRange& range = indexRanges->ranges[rangeIndex];
+                vkCmdDrawIndexed(meshCommandBuffer, range.indexCount, 1, range.firstIndex, 0, 0);
+            }
+        }
     }
 }
 
@@ -477,10 +488,11 @@ std::vector<MeshHandle> RenderBackend::createMeshes(const std::vector<MeshBinary
         std::vector<uint32_t> bufferQueueFamilies = { vkContext.queueFamilies.graphics };
 
         Mesh mesh;
-        mesh.indexCount = meshData.indexCount;
+        // draws without index ranges use the full detail level, coarser levels are stored after it
+        mesh.indexCount = meshData.lods.empty() ? meshData.indexCount : meshData.lods.front().indexCount;
 
-        // index buffer
-        if (mesh.indexCount < std::numeric_limits<uint16_t>::max()) {
+        // index buffer, precision depends on the index count of all levels
+        if (meshData.indexCount < std::numeric_limits<uint16_t>::max()) {
             mesh.indexPrecision = VK_INDEX_TYPE_UINT16;
         }
         else {
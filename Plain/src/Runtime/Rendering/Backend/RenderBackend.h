@@ -20,6 +20,18 @@
 
 struct GLFWwindow;
 
+// part of a mesh index buffer
+struct MeshIndexRange {
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+};
+
+// ranges of mesh i are ranges[firstRangePerMesh[i]] to ranges[firstRangePerMesh[i + 1] - 1]
+struct MeshIndexRanges {
+    std::vector<MeshIndexRange> ranges;
+    std::vector<uint32_t>       firstRangePerMesh;  // mesh count + 1 entries
+};
+
 struct UniformBufferFillOrder {
     UniformBufferHandle buffer;
     std::vector<char>   data;
@@ -59,7 +71,9 @@ public:
     void prepareForDrawcallRecording();
 
     // must be called after startDrawcallRecording
-    void drawMeshes(const std::vector<MeshHandle> meshHandles, const char* pushConstantData, const RenderPassHandle passHandle, const int workerIndex);
+    // if indexRanges is set only the ranges of every mesh are drawn, else the full meshes
+    void drawMeshes(const std::vector<MeshHandle> meshHandles, const char* pushConstantData, const RenderPassHandle passHandle, const int workerIndex, 
+        const MeshIndexRanges* indexRanges = nullptr);
 
     // actual copy is deferred to before submitting, to avoid stalling cpu until previous frame is finished rendering
     // results in an extra copy of data
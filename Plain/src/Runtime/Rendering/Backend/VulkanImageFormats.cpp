@@ -4,6 +4,7 @@
 VkFormat imageFormatToVulkanFormat(const ImageFormat format) {
     switch (format) {
     case ImageFormat::R8:               return VK_FORMAT_R8_UNORM;
+    case ImageFormat::R8_sNorm:         return VK_FORMAT_R8_SNORM;
     case ImageFormat::RG8:              return VK_FORMAT_R8G8_UNORM;
     case ImageFormat::RGBA8:            return VK_FORMAT_R8G8B8A8_UNORM;
     case ImageFormat::RG16_sFloat:      return VK_FORMAT_R16G16_SFLOAT;
@@ -18,6 +19,7 @@ VkFormat imageFormatToVulkanFormat(const ImageFormat format) {
     case ImageFormat::Depth32:          return VK_FORMAT_D32_SFLOAT;
     case ImageFormat::BC1:              return VK_FORMAT_BC1_RGB_UNORM_BLOCK;
     case ImageFormat::BC3:              return VK_FORMAT_BC3_UNORM_BLOCK;
+    case ImageFormat::BC4_sNorm:        return VK_FORMAT_BC4_SNORM_BLOCK;
     case ImageFormat::BC5:              return VK_FORMAT_BC5_UNORM_BLOCK;
     case ImageFormat::BGRA8_uNorm:            return VK_FORMAT_B8G8R8A8_UNORM;
     default: std::cout << "Unknown Image format\n"; return VK_FORMAT_MAX_ENUM;
@@ -27,6 +29,7 @@ VkFormat imageFormatToVulkanFormat(const ImageFormat format) {
 VkImageAspectFlagBits imageFormatToVkAspectFlagBits(const ImageFormat format) {
     switch (format) {
     case ImageFormat::R8:               return VK_IMAGE_ASPECT_COLOR_BIT;
+    case ImageFormat::R8_sNorm:         return VK_IMAGE_ASPECT_COLOR_BIT;
     case ImageFormat::RG8:              return VK_IMAGE_ASPECT_COLOR_BIT;
     case ImageFormat::RGBA8:            return VK_IMAGE_ASPECT_COLOR_BIT;
     case ImageFormat::RG16_sFloat:      return VK_IMAGE_ASPECT_COLOR_BIT;
@@ -41,6 +44,7 @@ VkImageAspectFlagBits imageFormatToVkAspectFlagBits(const ImageFormat format) {
     case ImageFormat::Depth32:          return VK_IMAGE_ASPECT_DEPTH_BIT;
     case ImageFormat::BC1:              return VK_IMAGE_ASPECT_COLOR_BIT;
     case ImageFormat::BC3:              return VK_IMAGE_ASPECT_COLOR_BIT;
+    case ImageFormat::BC4_sNorm:        return VK_IMAGE_ASPECT_COLOR_BIT;
     case ImageFormat::BC5:              return VK_IMAGE_ASPECT_COLOR_BIT;
     case ImageFormat::BGRA8_uNorm:            return VK_IMAGE_ASPECT_COLOR_BIT;
     default: std::cout << "Unknown Image format\n"; return VK_IMAGE_ASPECT_FLAG_BITS_MAX_ENUM;
@@ -50,6 +54,7 @@ VkImageAspectFlagBits imageFormatToVkAspectFlagBits(const ImageFormat format) {
 ImageFormat vulkanImageFormatToImageFormat(const VkFormat format) {
     switch (format) {
     case VK_FORMAT_R8_UNORM:                return ImageFormat::R8;
+    case VK_FORMAT_R8_SNORM:                return ImageFormat::R8_sNorm;
     case VK_FORMAT_R8G8_UNORM:              return ImageFormat::RG8;
     case VK_FORMAT_R8G8B8A8_UNORM:          return ImageFormat::RGBA8;
     case VK_FORMAT_R16G16_SFLOAT:           return ImageFormat::RG16_sFloat;
@@ -64,6 +69,7 @@ ImageFormat vulkanImageFormatToImageFormat(const VkFormat format) {
     case VK_FORMAT_D32_SFLOAT:              return ImageFormat::Depth32;
     case VK_FORMAT_BC1_RGB_UNORM_BLOCK:     return ImageFormat::BC1;
     case VK_FORMAT_BC3_UNORM_BLOCK:         return ImageFormat::BC3;
+    case VK_FORMAT_BC4_SNORM_BLOCK:         return ImageFormat::BC4_sNorm;
     case VK_FORMAT_BC5_UNORM_BLOCK:         return ImageFormat::BC5;
     case VK_FORMAT_B8G8R8A8_UNORM:          return ImageFormat::BGRA8_uNorm;
     default: std::cout << "Unknown Image format\n"; return ImageFormat::R8;
@@ -39,4 +39,44 @@ bool isAxisAlignedBoundingBoxIntersectingViewFrustum(const ViewFrustum& frustum,
         }
     }
     return true;
+}
+
+bool isSphereIntersectingViewFrustum(const ViewFrustum& frustum, const glm::vec3& center, const float radius) {
+
+    const auto& fps = frustum.points;
+    const auto& fns = frustum.normals;
+
+    // same planes as for bounding boxes, normals point outwards
+    const glm::vec3 planePointNormalPairs[6][2] = {
+        {fps.l_u_f, fns.top},
+        {fps.l_l_f, fns.bot},
+        {fps.l_u_n, fns.near},
+        {fps.l_u_f, fns.far},
+        {fps.l_u_f, fns.left},
+        {fps.r_u_f, fns.right}
+    };
+
+    for (uint32_t i = 0; i < 6; i++) {
+        const auto& planePoint  = planePointNormalPairs[i][0];
+        const auto& planeNormal = planePointNormalPairs[i][1];
+        if (dot(center - planePoint, planeNormal) > radius) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// reference: "meshoptimizer", Arseny Kapoulkine, meshopt_computeClusterBounds
+bool isMeshletBackfacing(const Meshlet& meshlet, const ConeCullingView& view) {
+    // a cutoff of 1 marks cones that are too wide, the check avoids culling because of rounding
+    if (meshlet.coneCutoff >= 1.f) {
+        return false;
+    }
+    if (view.isOrthographic) {
+        return dot(view.direction, meshlet.coneAxis) >= meshlet.coneCutoff;
+    }
+    else {
+        // view position at the apex results in NaN, which fails the comparison and is not culled
+        return dot(glm::normalize(meshlet.coneApex - view.position), meshlet.coneAxis) >= meshlet.coneCutoff;
+    }
 }
\ No newline at end of file
@@ -2,5 +2,19 @@
 #include "pch.h"
 #include "ViewFrustum.h"
 #include "AABB.h"
+#include "Common/MeshData.h"
 
-bool isAxisAlignedBoundingBoxIntersectingViewFrustum(const ViewFrustum& frustum, const AxisAlignedBoundingBox& bb);
\ No newline at end of file
+bool isAxisAlignedBoundingBoxIntersectingViewFrustum(const ViewFrustum& frustum, const AxisAlignedBoundingBox& bb);
+
+bool isSphereIntersectingViewFrustum(const ViewFrustum& frustum, const glm::vec3& center, const float radius);
+
+// view used for normal cone culling of meshlets, must be in the local space of the mesh
+// perspective views test against the view position, orthographic views against the view direction
+struct ConeCullingView {
+    bool        isOrthographic = false;
+    glm::vec3   position = glm::vec3(0.f);
+    glm::vec3   direction = glm::vec3(0.f, 0.f, -1.f);  // normalized
+};
+
+// true if all triangles of the meshlet are backfacing, so they would all be removed by backface culling
+bool isMeshletBackfacing(const Meshlet& meshlet, const ConeCullingView& view);
\ No newline at end of file
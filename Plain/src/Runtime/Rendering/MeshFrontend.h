@@ -1,6 +1,7 @@
 #pragma once
 #include "pch.h"
 #include "RenderHandles.h"
+#include "Common/MeshData.h"
 
 // texture indices for direct use in shader, index into global texture array
 struct Material {
@@ -11,8 +12,11 @@ struct Material {
 
 struct MeshFrontend {
     MeshHandle              backendHandle;
-    int                     sdfTextureIndex = 0;
+    int                     sdfTextureIndex = 0;            // brick atlas, -1 if mesh has no sdf
+    int                     sdfIndirectionTextureIndex = 0;
     glm::vec3               meanAlbedo = glm::vec3(0.5f);
     Material                material;
     AxisAlignedBoundingBox  localBB;
+    std::vector<Meshlet>    meshlets;                       // cover all indices in order, used for culling parts of the mesh
+    std::vector<MeshLod>    lods;                           // ordered from fine to coarse, each references a range of meshlets
 };
\ No newline at end of file
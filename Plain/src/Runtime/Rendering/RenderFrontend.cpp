@@ -275,6 +275,12 @@ void RenderFrontend::prepareNewFrame() {
     m_currentMeshCount = 0;
     m_currentMainPassDrawcallCount = 0;
     m_currentShadowPassDrawcallCount = 0;
+    m_currentMainPassMeshletCount = 0;
+    m_currentMainPassVisibleMeshletCount = 0;
+    m_currentShadowPassMeshletCount = 0;
+    m_currentShadowPassVisibleMeshletCount = 0;
+    m_currentMainPassTriangleCount = 0;
+    m_currentShadowPassTriangleCount = 0;
 }
 
 void RenderFrontend::setupGlobalShaderInfoLayout() {
@@ -464,13 +470,14 @@ std::vector<MeshHandleFrontend> RenderFrontend::registerMeshes(const std::vector
     meshHandlesFrontend.reserve(backendHandles.size());
 
     std::vector<fs::path> imagePaths;
-    const size_t texturesPerMesh = 4;
+    const size_t texturesPerMesh = 5;
     imagePaths.reserve(meshes.size() * texturesPerMesh);
     for (const MeshBinary& mesh : meshes) {
         imagePaths.push_back(mesh.texturePaths.albedoTexturePath);
         imagePaths.push_back(mesh.texturePaths.normalTexturePath);
         imagePaths.push_back(mesh.texturePaths.specularTexturePath);
         imagePaths.push_back(mesh.texturePaths.sdfTexturePath);
+        imagePaths.push_back(mesh.texturePaths.sdfIndirectionTexturePath);
     }
     const std::vector<ImageHandle> meshImageHandles = loadImagesFromPaths(imagePaths);
 
@@ -487,8 +494,28 @@ std::vector<MeshHandleFrontend> RenderFrontend::registerMeshes(const std::vector
 
         meshFrontend.localBB = mesh.boundingBox;
         meshFrontend.meanAlbedo = mesh.meanAlbedo;
+        meshFrontend.meshlets = mesh.meshlets;
+
+        // meshes created without meshlets are covered by a single one, which is never cone culled
+        if (meshFrontend.meshlets.empty()) {
+            Meshlet meshlet;
+            meshlet.indexCount = mesh.indexCount;
+            meshlet.boundingBox = mesh.boundingBox;
+            meshlet.sphereCenter = (mesh.boundingBox.min + mesh.boundingBox.max) * 0.5f;
+            meshlet.sphereRadius = glm::length(mesh.boundingBox.max - mesh.boundingBox.min) * 0.5f;
+            meshFrontend.meshlets.push_back(meshlet);
+        }
+
+        // meshes created without levels of detail only have the full detail level
+        meshFrontend.lods = mesh.lods;
+        if (meshFrontend.lods.empty()) {
+            MeshLod lod;
+            lod.indexCount = mesh.indexCount;
+            lod.meshletCount = (uint32_t)meshFrontend.meshlets.size();
+            meshFrontend.lods.push_back(lod);
+        }
 
-        const size_t baseIndex = (size_t)4 * i;
+        const size_t baseIndex = texturesPerMesh * i;
 
         // material
         ImageHandle albedoHandle = meshImageHandles[baseIndex + 0];
@@ -504,16 +531,20 @@ std::vector<MeshHandleFrontend> RenderFrontend::registerMeshes(const std::vector
             specularHandle = m_defaultTextures.specular;
         }
         ImageHandle sdfHandle = meshImageHandles[baseIndex + 3];
+        ImageHandle sdfIndirectionHandle = meshImageHandles[baseIndex + 4];
 
         meshFrontend.material.albedoTextureIndex = gRenderBackend.getImageGlobalTextureArrayIndex(albedoHandle);
         meshFrontend.material.normalTextureIndex = gRenderBackend.getImageGlobalTextureArrayIndex(normalHandle);
         meshFrontend.material.specularTextureIndex = gRenderBackend.getImageGlobalTextureArrayIndex(specularHandle);
 
-        if (sdfHandle.index == invalidIndex) {
+        // sparse sdf needs both atlas and indirection
+        if (sdfHandle.index == invalidIndex || sdfIndirectionHandle.index == invalidIndex) {
             meshFrontend.sdfTextureIndex = -1;
+            meshFrontend.sdfIndirectionTextureIndex = -1;
         }
         else {
             meshFrontend.sdfTextureIndex = (int)gRenderBackend.getImageGlobalTextureArrayIndex(sdfHandle);
+            meshFrontend.sdfIndirectionTextureIndex = (int)gRenderBackend.getImageGlobalTextureArrayIndex(sdfIndirectionHandle);
         }
 
         m_frontendMeshes.push_back(meshFrontend);
@@ -558,19 +589,36 @@ void RenderFrontend::renderScene(const std::vector<RenderObject>& scene) {
     // data needed in outer scope to keep data pointer in scope when executing job
     std::vector<MainPassPushConstants> mainPassPushConstants;	
     std::vector<MeshHandle> mainPassCulledMeshes;
+    MeshIndexRanges mainPassIndexRanges;
     {
         std::vector<MainPassMatrices> mainPassMatrices;
 
         // frustum culling
-        for (const RenderObject& obj : scene) {
+        const std::vector<uint8_t> isVisibleList = computeObjectVisibility(scene, m_cameraFrustum);
 
-            const bool isVisible = isAxisAlignedBoundingBoxIntersectingViewFrustum(m_cameraFrustum, obj.bbWorld);
+        ConeCullingView cameraConeView;
+        cameraConeView.position = m_camera.extrinsic.position;
+        const MeshletCullingResult meshletCulling = computeVisibleMeshletRanges(scene, isVisibleList, m_cameraFrustum, cameraConeView,
+            m_lodErrorThresholdPixels);
+        m_currentMainPassMeshletCount += meshletCulling.testedMeshletCount;
+        m_currentMainPassVisibleMeshletCount += meshletCulling.visibleMeshletCount;
+        m_currentMainPassTriangleCount += meshletCulling.visibleTriangleCount;
+
+        for (size_t i = 0; i < scene.size(); i++) {
+
+            const RenderObject& obj = scene[i];
+            // objects culled as a whole have no ranges either
+            const std::vector<MeshIndexRange>& indexRanges = meshletCulling.rangesPerObject[i];
+            const bool isVisible = !indexRanges.empty();
 
             if (isVisible) {
                 m_currentMainPassDrawcallCount++;
-                MeshFrontend meshFrontend = m_frontendMeshes[obj.mesh.index];
+                const MeshFrontend& meshFrontend = m_frontendMeshes[obj.mesh.index];
                 mainPassCulledMeshes.push_back(meshFrontend.backendHandle);
 
+                mainPassIndexRanges.firstRangePerMesh.push_back((uint32_t)mainPassIndexRanges.ranges.size());
+                mainPassIndexRanges.ranges.insert(mainPassIndexRanges.ranges.end(), indexRanges.begin(), indexRanges.end());
+
                 MainPassPushConstants meshPushConstants;
                 meshPushConstants.albedoTextureIndex = meshFrontend.material.albedoTextureIndex;
                 meshPushConstants.normalTextureIndex = meshFrontend.material.normalTextureIndex;
@@ -585,19 +633,22 @@ void RenderFrontend::renderScene(const std::vector<RenderObject>& scene) {
                 mainPassMatrices.push_back(matrices);
             }
         }
+        mainPassIndexRanges.firstRangePerMesh.push_back((uint32_t)mainPassIndexRanges.ranges.size());
+
         // only prepass drawcalls needed for sdf debug visualisation
         if (renderingSDFVisualisation) {
-            JobSystem::addJob([this, &mainPassCulledMeshes, &mainPassPushConstants](int workerIndex) {
-                gRenderBackend.drawMeshes(mainPassCulledMeshes, (char*)mainPassPushConstants.data(), m_depthPrePass, workerIndex);
-            }, &recordingFinished);
+            JobSystem::addJob([this, &mainPassCulledMeshes, &mainPassPushConstants, &mainPassIndexRanges](int workerIndex) {
+                gRenderBackend.drawMeshes(mainPassCulledMeshes, (char*)mainPassPushConstants.data(), m_depthPrePass, workerIndex, &mainPassIndexRanges);
+            }, &recordingFinished, JobSystem::JobPriority::High, "Record depth prepass");
         }
         else {
-            JobSystem::addJob([this, &mainPassCulledMeshes, &mainPassPushConstants](int workerIndex) {
-                gRenderBackend.drawMeshes(mainPassCulledMeshes, (char*)mainPassPushConstants.data(), m_mainPass, workerIndex);
-            }, &recordingFinished);
-            JobSystem::addJob([this, &mainPassCulledMeshes, &mainPassPushConstants](int workerIndex) {
-                gRenderBackend.drawMeshes(mainPassCulledMeshes, (char*)mainPassPushConstants.data(), m_depthPrePass, workerIndex);
-            }, &recordingFinished);
+            // main pass uses depth test equal, so both passes must draw the same ranges
+            JobSystem::addJob([this, &mainPassCulledMeshes, &mainPassPushConstants, &mainPassIndexRanges](int workerIndex) {
+                gRenderBackend.drawMeshes(mainPassCulledMeshes, (char*)mainPassPushConstants.data(), m_mainPass, workerIndex, &mainPassIndexRanges);
+            }, &recordingFinished, JobSystem::JobPriority::High, "Record main pass");
+            JobSystem::addJob([this, &mainPassCulledMeshes, &mainPassPushConstants, &mainPassIndexRanges](int workerIndex) {
+                gRenderBackend.drawMeshes(mainPassCulledMeshes, (char*)mainPassPushConstants.data(), m_depthPrePass, workerIndex, &mainPassIndexRanges);
+            }, &recordingFinished, JobSystem::JobPriority::High, "Record depth prepass");
         }
         gRenderBackend.setStorageBufferData(m_mainPassTransformsBuffer, mainPassMatrices.data(), 
             sizeof(MainPassMatrices) * mainPassMatrices.size());
@@ -610,6 +661,7 @@ void RenderFrontend::renderScene(const std::vector<RenderObject>& scene) {
     };
     std::vector<MeshHandle> shadowCulledMeshes;
     std::vector<ShadowPushConstants> shadowPushConstantData;
+    MeshIndexRanges shadowIndexRanges;
     {
         const glm::vec3 sunDirection = directionToVector(m_sunDirection);
         // we must not cull behind the shadow frustum near plane, as objects there cast shadows into the visible area
@@ -626,16 +678,34 @@ void RenderFrontend::renderScene(const std::vector<RenderObject>& scene) {
 
         // coarse frustum culling for shadow rendering, assuming shadow frustum if fitted to camera frustum
         // actual frustum is fitted tightly to depth buffer values, but that is done on the GPU
-        for (const RenderObject& obj : scene) {
+        const std::vector<uint8_t> isVisibleList = computeObjectVisibility(scene, m_sunShadowFrustum);
+
+        // shadow passes cull front faces, so meshlets facing the sun are removed
+        // these are exactly the backfacing ones for a view looking along the sun direction
+        ConeCullingView sunConeView;
+        sunConeView.isOrthographic = true;
+        sunConeView.direction = sunDirection;
+        const MeshletCullingResult meshletCulling = computeVisibleMeshletRanges(scene, isVisibleList, m_sunShadowFrustum, sunConeView,
+            m_shadowLodErrorThresholdPixels);
+        m_currentShadowPassMeshletCount += meshletCulling.testedMeshletCount;
+        m_currentShadowPassVisibleMeshletCount += meshletCulling.visibleMeshletCount;
+        m_currentShadowPassTriangleCount += meshletCulling.visibleTriangleCount;
+
+        for (size_t i = 0; i < scene.size(); i++) {
 
-            const bool isVisible = isAxisAlignedBoundingBoxIntersectingViewFrustum(m_sunShadowFrustum, obj.bbWorld);
+            const RenderObject& obj = scene[i];
+            const std::vector<MeshIndexRange>& indexRanges = meshletCulling.rangesPerObject[i];
+            const bool isVisible = !indexRanges.empty();
 
             if (isVisible) {
                 m_currentShadowPassDrawcallCount++;
 
-                const MeshFrontend mesh = m_frontendMeshes[obj.mesh.index];
+                const MeshFrontend& mesh = m_frontendMeshes[obj.mesh.index];
                 shadowCulledMeshes.push_back(mesh.backendHandle);
 
+                shadowIndexRanges.firstRangePerMesh.push_back((uint32_t)shadowIndexRanges.ranges.size());
+                shadowIndexRanges.ranges.insert(shadowIndexRanges.ranges.end(), indexRanges.begin(), indexRanges.end());
+
                 ShadowPushConstants pushConstants;
                 pushConstants.albedoTextureIndex = mesh.material.albedoTextureIndex;
                 pushConstants.transformIndex = (uint32_t)shadowModelMatrices.size();
@@ -644,10 +714,13 @@ void RenderFrontend::renderScene(const std::vector<RenderObject>& scene) {
                 shadowModelMatrices.push_back(obj.modelMatrix);
             }
         }
+        shadowIndexRanges.firstRangePerMesh.push_back((uint32_t)shadowIndexRanges.ranges.size());
+
         for (int shadowPass = 0; shadowPass < m_shadingConfig.sunShadowCascadeCount; shadowPass++) {
-            JobSystem::addJob([this, shadowPass, &shadowCulledMeshes, &shadowPushConstantData](int workerIndex) {
-                gRenderBackend.drawMeshes(shadowCulledMeshes, (char*)shadowPushConstantData.data(), m_shadowPasses[shadowPass], workerIndex);
-            }, & recordingFinished);
+            JobSystem::addJob([this, shadowPass, &shadowCulledMeshes, &shadowPushConstantData, &shadowIndexRanges](int workerIndex) {
+                gRenderBackend.drawMeshes(shadowCulledMeshes, (char*)shadowPushConstantData.data(), m_shadowPasses[shadowPass], workerIndex, 
+                    &shadowIndexRanges);
+            }, &recordingFinished, JobSystem::JobPriority::High, "Record shadow pass");
         }
         gRenderBackend.setStorageBufferData(m_shadowPassTransformsBuffer, shadowModelMatrices.data(),
             sizeof(glm::mat4) * shadowModelMatrices.size());
@@ -675,13 +748,135 @@ void RenderFrontend::renderScene(const std::vector<RenderObject>& scene) {
         }
         JobSystem::addJob([this, &bbMeshHandles, &bbPushConstantData](int workerIndex) {
             gRenderBackend.drawMeshes(bbMeshHandles, (char*)bbPushConstantData.data(), m_debugGeoPass, workerIndex);
-        }, & recordingFinished);
+        }, &recordingFinished, JobSystem::JobPriority::High, "Record bounding boxes");
         const size_t bbMatricesSize = boundingBoxMatrices.size() * sizeof(glm::mat4);
         gRenderBackend.setStorageBufferData(m_boundingBoxDebugRenderMatrices, (char*)boundingBoxMatrices.data(), bbMatricesSize);
     }
     JobSystem::waitOnCounter(recordingFinished);
 }
 
+std::vector<uint8_t> RenderFrontend::computeObjectVisibility(const std::vector<RenderObject>& scene, const ViewFrustum& frustum) const {
+    // uint8_t instead of bool, as std::vector<bool> can't be written from multiple threads
+    std::vector<uint8_t> isVisibleList(scene.size());
+    const size_t cullingGrainSize = 256;
+    JobSystem::parallelFor(0, scene.size(), cullingGrainSize, 
+        [&scene, &frustum, &isVisibleList](const size_t rangeBegin, const size_t rangeEnd, int) {
+        for (size_t i = rangeBegin; i < rangeEnd; i++) {
+            isVisibleList[i] = isAxisAlignedBoundingBoxIntersectingViewFrustum(frustum, scene[i].bbWorld);
+        }
+    });
+    return isVisibleList;
+}
+
+MeshletCullingResult RenderFrontend::computeVisibleMeshletRanges(const std::vector<RenderObject>& scene, const std::vector<uint8_t>& isVisibleList,
+    const ViewFrustum& frustum, const ConeCullingView& coneView, const float lodErrorThresholdPixels) const {
+
+    MeshletCullingResult result;
+    result.rangesPerObject.resize(scene.size());
+    std::vector<uint32_t> testedMeshletCountPerObject(scene.size(), 0);
+    std::vector<uint32_t> visibleMeshletCountPerObject(scene.size(), 0);
+    std::vector<uint32_t> visibleTriangleCountPerObject(scene.size(), 0);
+
+    // large meshes have hundreds of meshlets, so the grain size is smaller than for object culling
+    const size_t cullingGrainSize = 32;
+    JobSystem::parallelFor(0, scene.size(), cullingGrainSize,
+        [this, &scene, &isVisibleList, &frustum, &coneView, lodErrorThresholdPixels, &result,
+        &testedMeshletCountPerObject, &visibleMeshletCountPerObject, &visibleTriangleCountPerObject](const size_t rangeBegin, const size_t rangeEnd, int) {
+        for (size_t objectIndex = rangeBegin; objectIndex < rangeEnd; objectIndex++) {
+            if (!isVisibleList[objectIndex]) {
+                continue;
+            }
+            const RenderObject& obj = scene[objectIndex];
+            const MeshFrontend& mesh = m_frontendMeshes[obj.mesh.index];
+
+            // spheres are scaled by the largest axis scale, so they stay conservative for non-uniform scaling
+            const glm::vec3 axisScale = glm::vec3(
+                glm::length(glm::vec3(obj.modelMatrix[0])),
+                glm::length(glm::vec3(obj.modelMatrix[1])),
+                glm::length(glm::vec3(obj.modelMatrix[2])));
+            const float maxScale = glm::max(glm::max(axisScale.x, axisScale.y), axisScale.z);
+            const float minScale = glm::min(glm::min(axisScale.x, axisScale.y), axisScale.z);
+
+            // cone angles are only preserved by uniform scaling and mirroring reverses the winding
+            // cone culling is skipped in these cases, as it could remove visible triangles
+            const float uniformScaleTolerance = 0.001f;
+            const bool isScaleUniform = maxScale - minScale <= maxScale * uniformScaleTolerance;
+            const bool isMirrored = glm::determinant(glm::mat3(obj.modelMatrix)) < 0.f;
+            const bool useConeCulling = m_meshletConeCulling && isScaleUniform && !isMirrored;
+
+            ConeCullingView localConeView = coneView;
+            if (useConeCulling) {
+                const glm::mat4 worldToLocal = glm::inverse(obj.modelMatrix);
+                localConeView.position = glm::vec3(worldToLocal * glm::vec4(coneView.position, 1.f));
+                localConeView.direction = glm::normalize(glm::mat3(worldToLocal) * coneView.direction);
+            }
+
+            const MeshLod& lod = mesh.lods[selectMeshLod(mesh, obj, maxScale, lodErrorThresholdPixels)];
+            testedMeshletCountPerObject[objectIndex] = lod.meshletCount;
+
+            std::vector<MeshIndexRange>& ranges = result.rangesPerObject[objectIndex];
+            for (uint32_t meshletIndex = lod.firstMeshlet; meshletIndex < lod.firstMeshlet + lod.meshletCount; meshletIndex++) {
+                const Meshlet& meshlet = mesh.meshlets[meshletIndex];
+                bool isVisible = true;
+                if (m_meshletFrustumCulling) {
+                    const glm::vec3 centerWorld = glm::vec3(obj.modelMatrix * glm::vec4(meshlet.sphereCenter, 1.f));
+                    isVisible = isSphereIntersectingViewFrustum(frustum, centerWorld, meshlet.sphereRadius * maxScale);
+                }
+                if (isVisible && useConeCulling) {
+                    isVisible = !isMeshletBackfacing(meshlet, localConeView);
+                }
+                if (!isVisible) {
+                    continue;
+                }
+                visibleMeshletCountPerObject[objectIndex]++;
+                visibleTriangleCountPerObject[objectIndex] += meshlet.indexCount / 3;
+
+                // meshlets are ordered and without gaps, so directly following meshlets extend the last range
+                const bool extendsLastRange = !ranges.empty() && ranges.back().firstIndex + ranges.back().indexCount == meshlet.firstIndex;
+                if (extendsLastRange) {
+                    ranges.back().indexCount += meshlet.indexCount;
+                }
+                else {
+                    MeshIndexRange range;
+                    range.firstIndex = meshlet.firstIndex;
+                    range.indexCount = meshlet.indexCount;
+                    ranges.push_back(range);
+                }
+            }
+        }
+    });
+
+    for (size_t i = 0; i < scene.size(); i++) {
+        result.testedMeshletCount += testedMeshletCountPerObject[i];
+        result.visibleMeshletCount += visibleMeshletCountPerObject[i];
+        result.visibleTriangleCount += visibleTriangleCountPerObject[i];
+    }
+    return result;
+}
+
+uint32_t RenderFrontend::selectMeshLod(const MeshFrontend& mesh, const RenderObject& obj, const float maxScale,
+    const float errorThresholdPixels) const {
+
+    // closest point of the bounding box, so the error of parts close to the camera is not underestimated
+    const glm::vec3 cameraPosition = m_camera.extrinsic.position;
+    const glm::vec3 closestPoint = glm::clamp(cameraPosition, obj.bbWorld.min, obj.bbWorld.max);
+    const float distance = glm::max(glm::length(closestPoint - cameraPosition), m_camera.intrinsic.near);
+
+    // pixels covered by a world space length of one at distance one
+    const float projectionScale = (float)m_screenHeight / (2.f * glm::tan(glm::radians(m_camera.intrinsic.fov) * 0.5f));
+    const float pixelsPerLocalError = maxScale * projectionScale / distance;
+
+    // errors increase with every level, so the search stops at the first level exceeding the threshold
+    uint32_t selectedLod = 0;
+    for (uint32_t lod = 1; lod < mesh.lods.size(); lod++) {
+        if (mesh.lods[lod].error * pixelsPerLocalError > errorThresholdPixels) {
+            break;
+        }
+        selectedLod = lod;
+    }
+    return selectedLod;
+}
+
 void RenderFrontend::renderFrame() {
 
     if (m_minimized) {
@@ -969,34 +1164,24 @@ std::vector<ImageHandle> RenderFrontend::loadImagesFromPaths(const std::vector<s
     }
 
     // parallel load of required images
-    JobSystem::Counter loadingFinised;
+    const std::vector<std::string> requiredPaths(requiredDataSet.begin(), requiredDataSet.end());
     std::mutex mapMutex;
     std::unordered_map<std::string, std::pair<ImageDescription, size_t>> pathToDescriptionMap;
     std::vector<std::vector<uint8_t>> imageDataList;
-    imageDataList.resize(requiredDataSet.size());
+    imageDataList.resize(requiredPaths.size());
 
-    size_t dataIndex = 0;
-    for (const std::string &path : requiredDataSet) {
-
-        // disable workerIndex unused parameter warning
-        #pragma warning( push )
-        #pragma warning( disable : 4100)
-
-        JobSystem::addJob([path, dataIndex, &pathToDescriptionMap, &mapMutex, &imageDataList](int workerIndex) {
+    JobSystem::parallelFor(0, requiredPaths.size(), 1, 
+        [&requiredPaths, &pathToDescriptionMap, &mapMutex, &imageDataList](const size_t rangeBegin, const size_t rangeEnd, int) {
+        for (size_t dataIndex = rangeBegin; dataIndex < rangeEnd; dataIndex++) {
+            const std::string& path = requiredPaths[dataIndex];
             ImageDescription image;
             if (loadImage(path, true, &image, &imageDataList[dataIndex])) {
                 mapMutex.lock();
                 pathToDescriptionMap[path] = std::pair(image, dataIndex);
                 mapMutex.unlock();
             }
-        }, &loadingFinised);
-
-        // reenable warning
-        #pragma warning( pop )
-
-        dataIndex++;
-    }
-    JobSystem::waitOnCounter(loadingFinised);
+        }
+    });
 
     // create images and store in map
     for (const fs::path path : requiredDataSet) {
@@ -1086,6 +1271,7 @@ SDFTraceDependencies RenderFrontend::fillOutSdfGiDependencies(const FrameRenderT
     traceDependencies.lightBuffer = m_lightBuffer;
     traceDependencies.sunShadowInfoBuffer = m_sunShadowInfoBuffer;
     traceDependencies.depthMinMaxPyramid = m_minMaxDepthPyramid;
+    traceDependencies.cameraPosition = m_camera.extrinsic.position;
 
     return traceDependencies;
 }
@@ -1842,6 +2028,12 @@ void RenderFrontend::drawUi() {
         ImGui::Text(("Mesh count: " + std::to_string(m_currentMeshCount)).c_str());
         ImGui::Text(("Main pass drawcalls: " + std::to_string(m_currentMainPassDrawcallCount)).c_str());
         ImGui::Text(("Shadow map drawcalls: " + std::to_string(m_currentShadowPassDrawcallCount)).c_str());
+        ImGui::Text(("Main pass meshlets: " + std::to_string(m_currentMainPassVisibleMeshletCount) + 
+            " / " + std::to_string(m_currentMainPassMeshletCount)).c_str());
+        ImGui::Text(("Shadow map meshlets: " + std::to_string(m_currentShadowPassVisibleMeshletCount) + 
+            " / " + std::to_string(m_currentShadowPassMeshletCount)).c_str());
+        ImGui::Text(("Main pass triangles: " + std::to_string(m_currentMainPassTriangleCount)).c_str());
+        ImGui::Text(("Shadow map triangles: " + std::to_string(m_currentShadowPassTriangleCount)).c_str());
 
         uint64_t allocatedMemorySizeByte;
         uint64_t usedMemorySizeByte;
@@ -1901,6 +2093,12 @@ void RenderFrontend::drawUi() {
         if (!m_sdfTraceSettings.strictInfluenceRadiusCutoff) {
             ImGui::InputFloat("Shadow map extra padding", &m_sdfTraceSettings.additionalSunShadowMapPadding);
         }
+        if (m_sdfDebugSettings.visualisationMode == SDFVisualisationMode::None) {
+            m_isSDFDiffuseTraceShaderDescriptionStale |=
+                ImGui::Checkbox("Trace far field in scene SDF clipmap", &m_sdfTraceSettings.traceFarFieldInClipmap);
+            m_isSDFDiffuseTraceShaderDescriptionStale |=
+                ImGui::Checkbox("Sample SDF mips by cone radius", &m_sdfTraceSettings.sampleSDFMipsByConeRadius);
+        }
         if (m_sdfDebugSettings.visualisationMode == SDFVisualisationMode::CameraTileUsage) {
             ImGui::Checkbox("Camera tile usage with hi-Z culling", &m_sdfDebugSettings.showCameraTileUsageWithHiZ);
         }
@@ -2000,6 +2198,10 @@ void RenderFrontend::drawUi() {
         m_isSDFDiffuseTraceShaderDescriptionStale   |= shadowCascadeCountChanged;
         m_isSDFDebugShaderDescriptionStale          |= shadowCascadeCountChanged;
     }
+    if (ImGui::CollapsingHeader("Level of detail settings")) {
+        ImGui::DragFloat("LOD error threshold pixels", &m_lodErrorThresholdPixels, 0.1f, 0.f, 64.f);
+        ImGui::DragFloat("Shadow LOD error threshold pixels", &m_shadowLodErrorThresholdPixels, 0.1f, 0.f, 64.f);
+    }
     // camera settings
     if (ImGui::CollapsingHeader("Camera settings")) {
         ImGui::InputFloat("Near plane", &m_camera.intrinsic.near);
@@ -2007,6 +2209,8 @@ void RenderFrontend::drawUi() {
     }
     if (ImGui::CollapsingHeader("Debug settings")) {
         ImGui::Checkbox("Render bounding boxes", &m_renderBoundingBoxes);
+        ImGui::Checkbox("Meshlet frustum culling", &m_meshletFrustumCulling);
+        ImGui::Checkbox("Meshlet cone culling", &m_meshletConeCulling);
     }
     ImGui::End();
 }
\ No newline at end of file
@@ -6,6 +6,7 @@
 #include "Camera.h"
 #include "AABB.h"
 #include "ViewFrustum.h"
+#include "Culling.h"
 #include "Runtime/RuntimeScene.h"
 #include "MeshFrontend.h"
 
@@ -39,6 +40,14 @@ struct ShadingConfig {
 
 enum class ShaderResourceType { SampledImage, Sampler, StorageImage, StorageBuffer, UniformBuffer };
 
+// culling result of the meshlets of all objects in a scene
+struct MeshletCullingResult {
+    std::vector<std::vector<MeshIndexRange>> rangesPerObject;  // empty for objects that are culled completely
+    uint32_t testedMeshletCount = 0;    // meshlets of the selected levels of detail
+    uint32_t visibleMeshletCount = 0;
+    uint32_t visibleTriangleCount = 0;
+};
+
 struct DefaultTextures {
     ImageHandle diffuse;
     ImageHandle specular;
@@ -87,6 +96,22 @@ private:
     void computeTonemapping(const ImageHandle& src) const;
     void renderDebugGeometry(const ImageHandle colorTarget, const ImageHandle depthTarget) const;
 
+    // frustum culling of all objects, computed in parallel
+    // result contains one entry per object, 1 if visible, 0 if culled
+    std::vector<uint8_t> computeObjectVisibility(const std::vector<RenderObject>& scene, const ViewFrustum& frustum) const;
+
+    // culls the meshlets of all objects with an isVisibleList entry of 1, computed in parallel
+    // meshlets are culled against the frustum and, if enabled, by their normal cone, using the world space coneView
+    // adjacent visible meshlets are merged into a single index range
+    // only the meshlets of the level of detail selected by selectMeshLod are culled, using lodErrorThresholdPixels
+    MeshletCullingResult computeVisibleMeshletRanges(const std::vector<RenderObject>& scene, const std::vector<uint8_t>& isVisibleList,
+        const ViewFrustum& frustum, const ConeCullingView& coneView, const float lodErrorThresholdPixels) const;
+
+    // returns the coarsest level of detail whose error, projected at the closest point of the object bounding box, is below the threshold
+    // the error is projected with the camera for all passes, as shadows are only seen through it
+    // maxScale is the largest axis scale of the model matrix, used to scale the error to world space
+    uint32_t selectMeshLod(const MeshFrontend& mesh, const RenderObject& obj, const float maxScale, const float errorThresholdPixels) const;
+
     // load multiple images, loading from disk is parallel
     // checks a map of all loaded images if it is avaible, returns existing image if possible
     // if image could not be loaded ImageHandle.index is set to invalidIndex
@@ -104,6 +129,12 @@ private:
     uint32_t m_currentMeshCount = 0;                // mesh commands received
     uint32_t m_currentMainPassDrawcallCount = 0;    // executed after camera culling
     uint32_t m_currentShadowPassDrawcallCount = 0;  // executed after shadow frustum culling
+    uint32_t m_currentMainPassMeshletCount = 0;     // meshlets of objects passing camera culling
+    uint32_t m_currentMainPassVisibleMeshletCount = 0;
+    uint32_t m_currentShadowPassMeshletCount = 0;   // meshlets of objects passing shadow frustum culling
+    uint32_t m_currentShadowPassVisibleMeshletCount = 0;
+    uint32_t m_currentMainPassTriangleCount = 0;    // of visible meshlets
+    uint32_t m_currentShadowPassTriangleCount = 0;
 
     // timings are cached and not updated every frame to improve readability
     std::vector<RenderPassTime> m_currentRenderTimings;
@@ -112,11 +143,16 @@ private:
     float m_latestCPUTimeStatMs = 0.f;      // not updated every frame, only use as performance metric
     float m_latestDeltaTimeStatMs = 0.f;    // not updated every frame, only use as performance metric
 
-    glm::ivec3 m_sceneSDFResolution = glm::ivec3(1);
-
     bool m_didResolutionChange = false;
     bool m_minimized = false;
     bool m_renderBoundingBoxes = false;
+    bool m_meshletFrustumCulling = true;
+    bool m_meshletConeCulling = true;
+
+    // levels of detail are selected by their error projected to the screen, in pixels
+    // shadow maps are filtered and rarely magnified, so a coarser threshold is used for them
+    float m_lodErrorThresholdPixels = 1.f;
+    float m_shadowLodErrorThresholdPixels = 4.f;
     bool m_drawUI = true;
 
     // stored for resizing
@@ -10,6 +10,56 @@
 const size_t sdfCameraCullingTileSize = 32;
 const size_t maxSdfObjectsPerTile = 100;    // must be the same as shader constant maxObjectsPerTile in sdfCulling.inc
 
+const int sdfClipmapResolution = 64;                // must be the same as shader constant in sdfClipmap.inc
+const float sdfClipmapBaseVoxelSize = 0.25f;        // voxel size of the finest cascade, doubles with every cascade
+const float sdfClipmapMaxDistanceVoxels = 4.f;      // stored distances are clamped, instances further away don't affect a voxel
+const int sdfClipmapMaxDirtyBoxes = 8;              // per cascade and frame, further dirty boxes are merged into the last one
+
+struct GPUBoundingBox {
+    glm::vec3 min = glm::vec3(0);
+    float padding1 = 0.f;
+    glm::vec3 max = glm::vec3(0);
+    float padding2 = 0.f;
+};
+
+// instance data is copied, so compositing doesn't depend on the instance buffer, which is updated after the passes are set
+struct SDFClipmapCompositeInstance {
+    SDFInstance instance;
+    GPUBoundingBox worldBB;
+};
+
+// voxels of a dirty box are enumerated linearly, firstVoxel is the index of the first one within the dispatch of the cascade
+struct SDFClipmapDirtyBox {
+    glm::ivec3 min;
+    uint32_t instanceOffset;
+    glm::ivec3 size;
+    uint32_t instanceCount;
+    uint32_t firstVoxel;
+    uint32_t padding[3];
+};
+
+// integer box in voxels of a cascade, max is exclusive
+struct VoxelBox {
+    glm::ivec3 min;
+    glm::ivec3 max;
+};
+
+bool isVoxelBoxEmpty(const VoxelBox& box) {
+    return glm::any(glm::greaterThanEqual(box.min, box.max));
+}
+
+VoxelBox intersectVoxelBoxes(const VoxelBox& a, const VoxelBox& b) {
+    return VoxelBox{ glm::max(a.min, b.min), glm::min(a.max, b.max) };
+}
+
+// voxels whose center is within maxDistance of the bounding box
+VoxelBox voxelBoxFromWorldBB(const AxisAlignedBoundingBox& bb, const float voxelSize, const float maxDistance) {
+    VoxelBox box;
+    box.min = glm::ivec3(glm::floor((bb.min - maxDistance) / voxelSize - 0.5f));
+    box.max = glm::ivec3(glm::floor((bb.max + maxDistance) / voxelSize - 0.5f)) + 1;
+    return box;
+}
+
 ShaderDescription createSDFDebugShaderDescription(const SDFDebugSettings& settings, const int sunShadowCascadeIndex) {
     ShaderDescription desc;
     desc.srcPathRelative = "sdfDebugVisualisation.comp";
@@ -42,6 +92,16 @@ ShaderDescription createSDFDiffuseTraceShaderDescription(const SDFTraceSettings&
         1,                                                                              // location
         dataToCharArray((void*)&sunShadowCascadeIndex, sizeof(sunShadowCascadeIndex))   // value
         });
+    // far field clipmap trace
+    desc.specialisationConstants.push_back({
+        2,                                                                                                  // location
+        dataToCharArray((void*)&settings.traceFarFieldInClipmap, sizeof(settings.traceFarFieldInClipmap))   // value
+        });
+    // cone mip selection
+    desc.specialisationConstants.push_back({
+        3,                                                                                                      // location
+        dataToCharArray((void*)&settings.sampleSDFMipsByConeRadius, sizeof(settings.sampleSDFMipsByConeRadius))   // value
+        });
     return desc;
 }
 
@@ -115,6 +175,23 @@ void SDFGI::init(const glm::ivec2 screenResolution, const SDFTraceSettings& trac
 
         m_indirectLightingFullRes_CoCg = gRenderBackend.createImage(desc, nullptr, 0);
     }
+    // scene sdf clipmap cascades
+    {
+        ImageDescription desc;
+        desc.width  = sdfClipmapResolution;
+        desc.height = sdfClipmapResolution;
+        desc.depth  = sdfClipmapResolution;
+        desc.type = ImageType::Type3D;
+        desc.format = ImageFormat::RGBA16_sFloat;
+        desc.usageFlags = ImageUsageFlags::Storage | ImageUsageFlags::Sampled;
+        desc.mipCount = MipCount::One;
+        desc.manualMipCount = 1;
+        desc.autoCreateMips = false;
+
+        for (int i = 0; i < sdfClipmapCascadeCount; i++) {
+            m_sdfClipmap[i] = gRenderBackend.createImage(desc, nullptr, 0);
+        }
+    }
     // sdf instance buffer
     {
         StorageBufferDescription desc;
@@ -156,6 +233,33 @@ void SDFGI::init(const glm::ivec2 screenResolution, const SDFTraceSettings& trac
         desc.size = sizeof(float);
         m_sdfTraceInfluenceRangeBuffer = gRenderBackend.createUniformBuffer(desc);
     }
+    // sdf clipmap composite instances, every dirty box of every cascade can require all instances
+    {
+        StorageBufferDescription desc;
+        desc.size = sdfClipmapCascadeCount * sdfClipmapMaxDirtyBoxes * maxObjectCountMainScene * sizeof(SDFClipmapCompositeInstance);
+        m_sdfClipmapCompositeInstances = gRenderBackend.createStorageBuffer(desc);
+    }
+    // sdf clipmap dirty boxes
+    {
+        StorageBufferDescription desc;
+        desc.size = sdfClipmapCascadeCount * sdfClipmapMaxDirtyBoxes * sizeof(SDFClipmapDirtyBox);
+        m_sdfClipmapDirtyBoxes = gRenderBackend.createStorageBuffer(desc);
+    }
+    // sdf clipmap info, world space minimum and voxel size per cascade
+    {
+        UniformBufferDescription desc;
+        desc.size = sdfClipmapCascadeCount * sizeof(glm::vec4);
+        m_sdfClipmapInfoBuffer = gRenderBackend.createUniformBuffer(desc);
+    }
+    // sdf clipmap update, one pass per cascade as each one is dispatched with its own image and region
+    {
+        for (int i = 0; i < sdfClipmapCascadeCount; i++) {
+            ComputePassDescription desc;
+            desc.name = "SDF clipmap update";
+            desc.shaderDescription.srcPathRelative = "sdfClipmapUpdate.comp";
+            m_sdfClipmapUpdatePass[i] = gRenderBackend.createComputePass(desc);
+        }
+    }
     // sdf debug pass
     {
         ComputePassDescription desc;
@@ -261,16 +365,12 @@ void SDFGI::updateSDFScene(const std::vector<RenderObject>& scene, const std::ve
 
     // TODO: instead of updating complete scene transforms every frame, track dirty transforms and ony write changes using compute shader
 
-    struct GPUBoundingBox {
-        glm::vec3 min = glm::vec3(0);
-        float padding1 = 0.f;
-        glm::vec3 max = glm::vec3(0);
-        float padding2 = 0.f;
-    };
     std::vector<GPUBoundingBox> instanceWorldBBs;
-    std::vector<SDFInstance> instanceData;
+    std::vector<SDFInstance>& instanceData = m_sdfInstances;
+    instanceData.clear();
     instanceData.reserve(scene.size());
     instanceWorldBBs.reserve(scene.size());
+    m_sdfInstanceWorldBBs.clear();
     for (const RenderObject& obj : scene) {
 
         const MeshFrontend& mesh = frontendMeshes[obj.mesh.index];
@@ -285,9 +385,11 @@ void SDFGI::updateSDFScene(const std::vector<RenderObject>& scene, const std::ve
         worldBB.min = paddedWorldBB.min;
         worldBB.max = paddedWorldBB.max;
         instanceWorldBBs.push_back(worldBB);
+        m_sdfInstanceWorldBBs.push_back(paddedWorldBB);
 
         SDFInstance instance;
         instance.sdfTextureIndex = mesh.sdfTextureIndex;
+        instance.sdfIndirectionTextureIndex = mesh.sdfIndirectionTextureIndex;
 
         const AxisAlignedBoundingBox paddedLocalBB = padSDFBoundingBox(mesh.localBB);
         instance.localExtends = paddedLocalBB.max - paddedLocalBB.min;
@@ -325,8 +427,10 @@ SDFGI::IndirectLightingImages SDFGI::getIndirectLightingResults(const bool trace
     return result;
 }
 
-void SDFGI::computeIndirectLighting(const SDFTraceDependencies& dependencies, const SDFTraceSettings& traceSettings) const {
+void SDFGI::computeIndirectLighting(const SDFTraceDependencies& dependencies, const SDFTraceSettings& traceSettings) {
 
+    // updated even if far field isn't traced, so the clipmap is valid when it's enabled
+    updateSDFClipmap(dependencies.cameraPosition);
     diffuseSDFTrace(dependencies, traceSettings);
     filterIndirectDiffuse(dependencies, traceSettings);
 }
@@ -398,6 +502,9 @@ void SDFGI::diffuseSDFTrace(const SDFTraceDependencies& dependencies, const SDFT
         ImageResource(dependencies.skyLut, 0, 4),
         ImageResource(dependencies.shadowMap, 0, 10)
     };
+    for (int i = 0; i < sdfClipmapCascadeCount; i++) {
+        exe.genericInfo.resources.sampledImages.push_back(ImageResource(m_sdfClipmap[i], 0, 12 + i));
+    }
     exe.genericInfo.resources.storageBuffers = {
         StorageBufferResource(dependencies.lightBuffer, true, 5),
         StorageBufferResource(m_sdfInstanceBuffer, true, 6),
@@ -406,7 +513,8 @@ void SDFGI::diffuseSDFTrace(const SDFTraceDependencies& dependencies, const SDFT
     };
 
     exe.genericInfo.resources.uniformBuffers = {
-        UniformBufferResource(m_sdfTraceInfluenceRangeBuffer, 8)
+        UniformBufferResource(m_sdfTraceInfluenceRangeBuffer, 8),
+        UniformBufferResource(m_sdfClipmapInfoBuffer, 11)
     };
 
     const float localThreadSize = 8.f;
@@ -627,4 +735,154 @@ void SDFGI::sdfInstanceCulling(const SDFTraceDependencies& dependencies,
 
         gRenderBackend.setComputePassExecution(exe);
     }
+}
+
+void SDFGI::updateSDFClipmap(const glm::vec3& cameraPosition) {
+
+    // instances are matched by index, so a changed scene order is handled like moved instances
+    std::vector<AxisAlignedBoundingBox> changedWorldBBs;
+    const size_t instanceCountMax = std::max(m_sdfInstances.size(), m_sdfClipmapInstances.size());
+    for (size_t i = 0; i < instanceCountMax; i++) {
+        const bool isNew = i >= m_sdfClipmapInstances.size();
+        const bool isRemoved = i >= m_sdfInstances.size();
+        if (!isNew && !isRemoved && memcmp(&m_sdfInstances[i], &m_sdfClipmapInstances[i], sizeof(SDFInstance)) == 0) {
+            continue;
+        }
+        // previous position must be cleared, new position must be added
+        if (!isNew) {
+            changedWorldBBs.push_back(m_sdfClipmapInstanceWorldBBs[i]);
+        }
+        if (!isRemoved) {
+            changedWorldBBs.push_back(m_sdfInstanceWorldBBs[i]);
+        }
+    }
+
+    glm::vec4 cascadeMinAndVoxelSize[sdfClipmapCascadeCount];
+    std::vector<SDFClipmapCompositeInstance> compositeInstances;
+    std::vector<SDFClipmapDirtyBox> clipmapDirtyBoxes;
+
+    for (int cascade = 0; cascade < sdfClipmapCascadeCount; cascade++) {
+        const float voxelSize = sdfClipmapBaseVoxelSize * float(1 << cascade);
+        const float maxDistance = sdfClipmapMaxDistanceVoxels * voxelSize;
+
+        VoxelBox cascadeBox;
+        cascadeBox.min = glm::ivec3(glm::floor(cameraPosition / voxelSize)) - sdfClipmapResolution / 2;
+        cascadeBox.max = cascadeBox.min + sdfClipmapResolution;
+        cascadeMinAndVoxelSize[cascade] = glm::vec4(glm::vec3(cascadeBox.min) * voxelSize, voxelSize);
+
+        std::vector<VoxelBox> dirtyBoxes;
+        const glm::ivec3 shift = cascadeBox.min - m_sdfClipmapOrigin[cascade];
+        const bool isShiftBeyondCascade = glm::any(glm::greaterThanEqual(glm::abs(shift), glm::ivec3(sdfClipmapResolution)));
+        if (!m_isSDFClipmapValid[cascade] || isShiftBeyondCascade) {
+            dirtyBoxes.push_back(cascadeBox);
+        }
+        else {
+            // toroidal addressing keeps voxels which stay in the cascade, only the slabs that became visible are new
+            // slabs are cut from the remaining box, so voxels of a shift along multiple axes are updated only once
+            VoxelBox remainingBox = cascadeBox;
+            for (int axis = 0; axis < 3; axis++) {
+                VoxelBox slab = remainingBox;
+                if (shift[axis] > 0) {
+                    slab.min[axis] = cascadeBox.max[axis] - shift[axis];
+                    remainingBox.max[axis] = slab.min[axis];
+                }
+                else if (shift[axis] < 0) {
+                    slab.max[axis] = cascadeBox.min[axis] - shift[axis];
+                    remainingBox.min[axis] = slab.max[axis];
+                }
+                else {
+                    continue;
+                }
+                dirtyBoxes.push_back(slab);
+            }
+            for (const AxisAlignedBoundingBox& bb : changedWorldBBs) {
+                const VoxelBox box = intersectVoxelBoxes(voxelBoxFromWorldBB(bb, voxelSize, maxDistance), remainingBox);
+                if (!isVoxelBoxEmpty(box)) {
+                    dirtyBoxes.push_back(box);
+                }
+            }
+        }
+        m_sdfClipmapOrigin[cascade] = cascadeBox.min;
+        m_isSDFClipmapValid[cascade] = true;
+
+        if (dirtyBoxes.empty()) {
+            continue;
+        }
+        // the box list has a fixed size, surplus boxes are merged, which only costs additional voxels
+        while (dirtyBoxes.size() > (size_t)sdfClipmapMaxDirtyBoxes) {
+            const VoxelBox last = dirtyBoxes.back();
+            dirtyBoxes.pop_back();
+            dirtyBoxes.back().min = glm::min(dirtyBoxes.back().min, last.min);
+            dirtyBoxes.back().max = glm::max(dirtyBoxes.back().max, last.max);
+        }
+
+        // every instance affecting the voxels of a box is composited, not only changed ones
+        const uint32_t boxOffset = (uint32_t)clipmapDirtyBoxes.size();
+        uint32_t voxelCount = 0;
+        for (const VoxelBox& box : dirtyBoxes) {
+            SDFClipmapDirtyBox dirtyBox = {};
+            dirtyBox.min = box.min;
+            dirtyBox.size = box.max - box.min;
+            dirtyBox.firstVoxel = voxelCount;
+            dirtyBox.instanceOffset = (uint32_t)compositeInstances.size();
+            for (size_t i = 0; i < m_sdfInstances.size(); i++) {
+                const VoxelBox instanceBox = voxelBoxFromWorldBB(m_sdfInstanceWorldBBs[i], voxelSize, maxDistance);
+                if (isVoxelBoxEmpty(intersectVoxelBoxes(instanceBox, box))) {
+                    continue;
+                }
+                SDFClipmapCompositeInstance compositeInstance;
+                compositeInstance.instance = m_sdfInstances[i];
+                compositeInstance.worldBB.min = m_sdfInstanceWorldBBs[i].min;
+                compositeInstance.worldBB.max = m_sdfInstanceWorldBBs[i].max;
+                compositeInstances.push_back(compositeInstance);
+            }
+            dirtyBox.instanceCount = (uint32_t)compositeInstances.size() - dirtyBox.instanceOffset;
+            clipmapDirtyBoxes.push_back(dirtyBox);
+            voxelCount += dirtyBox.size.x * dirtyBox.size.y * dirtyBox.size.z;
+        }
+
+        struct ClipmapUpdatePushConstants {
+            uint32_t boxOffset;
+            uint32_t boxCount;
+            uint32_t voxelCount;
+            float voxelSize;
+            float maxDistance;
+        };
+        ClipmapUpdatePushConstants pushConstants;
+        pushConstants.boxOffset = boxOffset;
+        pushConstants.boxCount = (uint32_t)dirtyBoxes.size();
+        pushConstants.voxelCount = voxelCount;
+        pushConstants.voxelSize = voxelSize;
+        pushConstants.maxDistance = maxDistance;
+
+        ComputePassExecution exe;
+        exe.genericInfo.handle = m_sdfClipmapUpdatePass[cascade];
+        exe.genericInfo.resources.storageImages = { ImageResource(m_sdfClipmap[cascade], 0, 0) };
+        exe.genericInfo.resources.storageBuffers = {
+            StorageBufferResource(m_sdfClipmapCompositeInstances, true, 1),
+            StorageBufferResource(m_sdfClipmapDirtyBoxes, true, 2)
+        };
+        exe.pushConstants = dataToCharArray((void*)&pushConstants, sizeof(pushConstants));
+
+        // one dimensional dispatch over the voxels of all dirty boxes, the box of a voxel is looked up in the shader
+        const float localThreadSize = 64.f;
+        exe.dispatchCount[0] = (uint32_t)glm::ceil(voxelCount / localThreadSize);
+        exe.dispatchCount[1] = 1;
+        exe.dispatchCount[2] = 1;
+
+        gRenderBackend.setComputePassExecution(exe);
+    }
+
+    if (!compositeInstances.empty()) {
+        gRenderBackend.setStorageBufferData(m_sdfClipmapCompositeInstances, compositeInstances.data(),
+            compositeInstances.size() * sizeof(SDFClipmapCompositeInstance));
+    }
+    if (!clipmapDirtyBoxes.empty()) {
+        gRenderBackend.setStorageBufferData(m_sdfClipmapDirtyBoxes, clipmapDirtyBoxes.data(),
+            clipmapDirtyBoxes.size() * sizeof(SDFClipmapDirtyBox));
+    }
+    gRenderBackend.setUniformBufferData(m_sdfClipmapInfoBuffer, cascadeMinAndVoxelSize, sizeof(cascadeMinAndVoxelSize));
+
+    m_sdfClipmapInstances = m_sdfInstances;
+    m_sdfClipmapInstanceWorldBBs = m_sdfInstanceWorldBBs;
 }
\ No newline at end of file
@@ -26,13 +26,21 @@ struct SDFTraceSettings {
     // highest sun shadow cascade used for shadowing trace hits
     // if strict influence radius cutoff is disabled hits can be outside influence radius, so extra padding is necessary
     float additionalSunShadowMapPadding = 3.f;
+    // rays without hit within influence radius continue through the scene SDF clipmap
+    // gives far occlusion at the cost of precision, as the clipmap is coarser than the instance SDFs
+    bool traceFarFieldInClipmap = true;
+    // diffuse rays are treated as cones and sample coarser SDF mips with distance, reduces bandwidth of far samples
+    bool sampleSDFMipsByConeRadius = true;
 };
 
+// scene SDF clipmap: camera centered cascades of a merged scene SDF, each cascade covers twice the extent of the previous one
+const int sdfClipmapCascadeCount = 4;  // must be the same as shader constant in sdfClipmap.inc
+
 struct SDFInstance {
     glm::vec3 localExtends;
-    uint32_t sdfTextureIndex;   // indexes into global texture descriptor array
+    uint32_t sdfTextureIndex;               // indexes into global texture descriptor array
     glm::vec3 meanAlbedo;
-    float padding;
+    uint32_t sdfIndirectionTextureIndex;    // indexes into global texture descriptor array
     glm::mat4x4 worldToLocal;
 };
 
@@ -47,6 +55,7 @@ struct SDFTraceDependencies {
     StorageBufferHandle lightBuffer;
     StorageBufferHandle sunShadowInfoBuffer;
     ImageHandle depthMinMaxPyramid;
+    glm::vec3 cameraPosition;
 };
 
 class SDFGI {
@@ -65,7 +74,8 @@ public:
 
     IndirectLightingImages getIndirectLightingResults(const bool tracedHalfRes) const;
 
-    void computeIndirectLighting(const SDFTraceDependencies& dependencies, const SDFTraceSettings& traceSettings) const;
+    // updates the scene SDF clipmap before tracing
+    void computeIndirectLighting(const SDFTraceDependencies& dependencies, const SDFTraceSettings& traceSettings);
 
     void renderSDFVisualization(const ImageHandle target, const SDFTraceDependencies dependencies,
         const SDFDebugSettings& debugSettings, const SDFTraceSettings& traceSettings) const;
@@ -84,6 +94,10 @@ private:
 
     void filterIndirectDiffuse(const SDFTraceDependencies& dependencies, const SDFTraceSettings& traceSettings) const;
 
+    // cascades follow the camera, voxels that became visible and voxels near instances that changed are recomposited
+    // instances are set in updateSDFScene, which is called after the passes are prepared, so the clipmap lags a frame
+    void updateSDFClipmap(const glm::vec3& cameraPosition);
+
     uint32_t m_sdfInstanceCount = 0;
 
     RenderPassHandle m_diffuseSDFTracePass;
@@ -94,6 +108,7 @@ private:
     RenderPassHandle m_sdfCameraTileCulling;
     RenderPassHandle m_sdfCameraTileCullingHiZ;
     RenderPassHandle m_sdfDebugVisualisationPass;
+    RenderPassHandle m_sdfClipmapUpdatePass[sdfClipmapCascadeCount];
 
     ImageHandle m_indirectDiffuse_Y_SH[2];          // ping pong buffers for filtering, Y component of YCoCg color space as spherical harmonics		
     ImageHandle m_indirectDiffuse_CoCg[2];          // ping pong buffers for filtering, CoCg component of YCoCg color space
@@ -101,12 +116,25 @@ private:
     ImageHandle m_indirectDiffuseHistory_CoCg[2];   // CoCg component of YCoCg color space
     ImageHandle m_indirectLightingFullRes_Y_SH;
     ImageHandle m_indirectLightingFullRes_CoCg;
+    ImageHandle m_sdfClipmap[sdfClipmapCascadeCount];  // rgb is albedo of closest instance, a is distance, addressed toroidally
+
+    glm::ivec3 m_sdfClipmapOrigin[sdfClipmapCascadeCount];     // in voxels of the cascade
+    bool m_isSDFClipmapValid[sdfClipmapCascadeCount] = {};     // invalid cascades are recomposited completely
+
+    std::vector<SDFInstance> m_sdfInstances;
+    std::vector<AxisAlignedBoundingBox> m_sdfInstanceWorldBBs;
+    // scene as composited into the clipmap, compared to current instances to find changes
+    std::vector<SDFInstance> m_sdfClipmapInstances;
+    std::vector<AxisAlignedBoundingBox> m_sdfClipmapInstanceWorldBBs;
 
     StorageBufferHandle m_sdfInstanceBuffer;
     StorageBufferHandle m_sdfCameraFrustumCulledInstances;
     StorageBufferHandle m_sdfInstanceWorldBBBuffer;
     StorageBufferHandle m_sdfCameraCulledTiles;
+    StorageBufferHandle m_sdfClipmapCompositeInstances;
+    StorageBufferHandle m_sdfClipmapDirtyBoxes;
 
     UniformBufferHandle m_cameraFrustumBuffer;
     UniformBufferHandle m_sdfTraceInfluenceRangeBuffer;
+    UniformBufferHandle m_sdfClipmapInfoBuffer;
 };
\ No newline at end of file
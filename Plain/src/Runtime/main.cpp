@@ -13,10 +13,13 @@
 //argv[1] = window width
 //argv[2] = window height
 //argv[3] = binary scene file path
+//argv[4] = job trace file path, optional, tracing is disabled if not set
+//the trace is written on exit and contains the last events of every worker
 struct CommandLineSettings {
     int width = 0;
     int height = 0;
     std::string sceneFilePath;
+    std::string traceFilePath;
 };
 
 CommandLineSettings parseCommandLineArguments(const int argc, char* argv[]) {
@@ -49,6 +52,10 @@ CommandLineSettings parseCommandLineArguments(const int argc, char* argv[]) {
         return settings;
     }
     settings.sceneFilePath = argv[3];
+
+    if (argc >= 5) {
+        settings.traceFilePath = argv[4];
+    }
     
     return settings;
 }
@@ -65,6 +72,7 @@ void main(int argc, char* argv[]){
     GLFWwindow* window = Window::createWindow(settings.width, settings.height);
 
     JobSystem::initJobSystem();
+    JobSystem::setTracingEnabled(!settings.traceFilePath.empty());
 
     gRenderBackend.setup(window);
     gRenderFrontend.setup(window);
@@ -91,4 +99,9 @@ void main(int argc, char* argv[]){
 
     gRenderFrontend.shutdown();
     gRenderBackend.shutdown();
+
+    if (JobSystem::isTracingEnabled() && JobSystem::writeTraceFile(settings.traceFilePath)) {
+        std::cout << "Saved job trace: " << settings.traceFilePath << "\n";
+    }
+    JobSystem::shutdownJobSystem();
 }
\ No newline at end of file